@@ -0,0 +1,171 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Compares ray kernels for every supported instruction set against scalar
+// intersection tests from GLM and AABB
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "glm/gtx/intersect.hpp"
+
+#include "src/render/aabb.h"
+#include "src/render/raykernels.h"
+
+using namespace std;
+
+using namespace reone::render;
+
+static const int kTriangleCount = 4096;
+static const int kBoxCount = 4096;
+static const int kRayCount = 1024;
+static const int kRepeatCount = 5;
+
+static double measure(const function<void()> &fn) {
+    double best = numeric_limits<double>::max();
+
+    for (int i = 0; i < kRepeatCount; ++i) {
+        auto start = chrono::steady_clock::now();
+        fn();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+static const char *getKernelSetName(RayKernelSet set) {
+    switch (set) {
+        case RayKernelSet::SSE:
+            return "SSE";
+        case RayKernelSet::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+int main() {
+    mt19937 random(1);
+    uniform_real_distribution<float> coord(-50.0f, 50.0f);
+    uniform_real_distribution<float> offset(-2.0f, 2.0f);
+
+    vector<glm::vec3> vertices;
+    TriangleBatch triangles;
+    for (int i = 0; i < kTriangleCount; ++i) {
+        glm::vec3 p0(coord(random), coord(random), coord(random));
+        glm::vec3 p1(p0 + glm::vec3(offset(random), offset(random), offset(random)));
+        glm::vec3 p2(p0 + glm::vec3(offset(random), offset(random), offset(random)));
+        vertices.push_back(p0);
+        vertices.push_back(p1);
+        vertices.push_back(p2);
+        triangles.add(p0, p1, p2);
+    }
+
+    vector<AABB> boxes;
+    AABBBatch boxBatch;
+    for (int i = 0; i < kBoxCount; ++i) {
+        glm::vec3 min(coord(random), coord(random), coord(random));
+        glm::vec3 max(min + glm::abs(glm::vec3(offset(random), offset(random), offset(random))));
+        boxes.push_back(AABB(min, max));
+        boxBatch.add(boxes.back());
+    }
+
+    vector<Ray> rays(kRayCount);
+    for (auto &ray : rays) {
+        ray.origin = glm::vec3(coord(random), coord(random), coord(random));
+        ray.dir = glm::normalize(glm::vec3(coord(random), coord(random), coord(random)));
+        ray.maxDistance = 100.0f;
+    }
+
+    // Rays vs triangles
+
+    vector<RayHit> expected(kRayCount);
+    double glmTime = measure([&]() {
+        for (int i = 0; i < kRayCount; ++i) {
+            const Ray &ray = rays[i];
+            RayHit &hit = expected[i];
+            hit = RayHit();
+
+            for (int j = 0; j < kTriangleCount; ++j) {
+                glm::vec2 baryPosition;
+                float distance;
+                if (glm::intersectRayTriangle(ray.origin, ray.dir, vertices[3 * j + 0], vertices[3 * j + 1], vertices[3 * j + 2], baryPosition, distance) &&
+                    distance >= 0.0f &&
+                    distance <= ray.maxDistance &&
+                    (hit.index == -1 || distance < hit.distance)) {
+
+                    hit.index = j;
+                    hit.distance = distance;
+                }
+            }
+        }
+    });
+
+    cout << boost::format("%d rays vs %d triangles") % kRayCount % kTriangleCount << endl;
+    cout << boost::format("  %-8s %10.3f ms") % "glm" % glmTime << endl;
+
+    for (auto set : { RayKernelSet::Scalar, RayKernelSet::SSE, RayKernelSet::AVX2 }) {
+        if (!setRayKernelSet(set)) continue;
+
+        vector<RayHit> hits(kRayCount);
+        double time = measure([&]() { intersectRaysTriangles(&rays[0], kRayCount, triangles, &hits[0]); });
+
+        int mismatches = 0;
+        for (int i = 0; i < kRayCount; ++i) {
+            if (hits[i].index != expected[i].index) ++mismatches;
+        }
+        cout << boost::format("  %-8s %10.3f ms, %5.1fx, %d mismatches") % getKernelSetName(set) % time % (glmTime / time) % mismatches << endl;
+    }
+
+    // Ray vs boxes
+
+    int aabbHitCount = 0;
+    double aabbTime = measure([&]() {
+        aabbHitCount = 0;
+        for (auto &ray : rays) {
+            glm::vec3 to(ray.origin + ray.dir * ray.maxDistance);
+            for (auto &box : boxes) {
+                float distance;
+                if (box.intersectLine(ray.origin, to, distance)) ++aabbHitCount;
+            }
+        }
+    });
+
+    cout << boost::format("%d rays vs %d boxes") % kRayCount % kBoxCount << endl;
+    cout << boost::format("  %-8s %10.3f ms, %d hits") % "AABB" % aabbTime % aabbHitCount << endl;
+
+    vector<int> indices(kBoxCount);
+    for (auto set : { RayKernelSet::Scalar, RayKernelSet::SSE, RayKernelSet::AVX2 }) {
+        if (!setRayKernelSet(set)) continue;
+
+        int hitCount = 0;
+        double time = measure([&]() {
+            hitCount = 0;
+            for (auto &ray : rays) {
+                hitCount += intersectRayBoxes(ray, boxBatch, &indices[0]);
+            }
+        });
+        cout << boost::format("  %-8s %10.3f ms, %5.1fx, %d hits") % getKernelSetName(set) % time % (aabbTime / time) % hitCount << endl;
+    }
+
+    return 0;
+}
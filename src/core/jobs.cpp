@@ -17,19 +17,27 @@
 
 #include "jobs.h"
 
+#include <algorithm>
 #include <thread>
 
 #include <boost/asio/post.hpp>
 
+#include "profiler.h"
+
 using namespace std;
 
 namespace reone {
 
+static const int kChunksPerThread = 4;
+
 JobExecutor &JobExecutor::instance() {
     static JobExecutor executor;
     return executor;
 }
 
+JobExecutor::JobExecutor() : _threadCount(max(1, static_cast<int>(thread::hardware_concurrency()))) {
+}
+
 JobExecutor::~JobExecutor() {
     deinit();
 }
@@ -44,7 +52,10 @@ void JobExecutor::enqueue(const function<void(const atomic_bool &)> &job) {
 
     boost::asio::post(_pool, [&, job]() {
         ++_jobsActive;
-        job(_cancel);
+        {
+            PROFILE_SCOPE("job");
+            job(_cancel);
+        }
         --_jobsActive;
     });
 }
@@ -59,4 +70,46 @@ void JobExecutor::await() {
     }
 }
 
+void JobExecutor::parallelFor(int count, const function<void(int)> &func) {
+    if (count <= 0) return;
+
+    int chunkSize = max(1, count / (kChunksPerThread * _threadCount));
+    int chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    struct State {
+        atomic_int nextChunk { 0 };
+        atomic_int chunksDone { 0 };
+    };
+    auto state = make_shared<State>();
+
+    // Helpers may start after all chunks are taken, so they must not reference the caller's stack
+    auto processChunks = [state, func, count, chunkSize, chunkCount]() {
+        PROFILE_SCOPE("parallelFor");
+
+        int chunk;
+        while ((chunk = state->nextChunk++) < chunkCount) {
+            int begin = chunk * chunkSize;
+            int end = min(count, begin + chunkSize);
+            for (int i = begin; i < end; ++i) {
+                func(i);
+            }
+            ++state->chunksDone;
+        }
+    };
+
+    int helperCount = min(chunkCount, _threadCount) - 1;
+    for (int i = 0; i < helperCount; ++i) {
+        boost::asio::post(_pool, processChunks);
+    }
+    processChunks();
+
+    while (state->chunksDone < chunkCount) {
+        this_thread::yield();
+    }
+}
+
+int JobExecutor::threadCount() const {
+    return _threadCount;
+}
+
 } // namespace reone
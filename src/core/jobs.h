@@ -32,12 +32,25 @@ public:
     void cancel();
     void await();
 
+    /**
+     * Calls func for every index in [0, count), splitting indices into
+     * chunks that are processed by the thread pool and the calling thread.
+     * Returns when all indices have been processed.
+     */
+    void parallelFor(int count, const std::function<void(int)> &func);
+
+    /**
+     * @return number of threads in the pool
+     */
+    int threadCount() const;
+
 private:
     boost::asio::thread_pool _pool;
+    int _threadCount { 1 };
     std::atomic_bool _cancel { false };
     std::atomic_int _jobsActive { 0 };
 
-    JobExecutor() = default;
+    JobExecutor();
 };
 
 #define TheJobExecutor JobExecutor::instance()
@@ -28,6 +28,8 @@ namespace fs = boost::filesystem;
 
 namespace reone {
 
+static fs::path g_cachePath;
+
 fs::path getPathIgnoreCase(const fs::path &basePath, const string &relPath) {
     vector<string> tokens;
     boost::split(tokens, relPath, boost::is_any_of("/"), boost::token_compress_on);
@@ -51,4 +53,12 @@ fs::path getPathIgnoreCase(const fs::path &basePath, const string &relPath) {
     return "";
 }
 
+void setCachePath(const fs::path &path) {
+    g_cachePath = path;
+}
+
+const fs::path &getCachePath() {
+    return g_cachePath;
+}
+
 } // namespace reone
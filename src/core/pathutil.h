@@ -23,4 +23,12 @@ namespace reone {
 
 boost::filesystem::path getPathIgnoreCase(const boost::filesystem::path &basePath, const std::string &relPath);
 
+/**
+ * Sets the directory to store caches of computed data in, e.g. shader
+ * binaries and nav meshes.
+ */
+void setCachePath(const boost::filesystem::path &path);
+
+const boost::filesystem::path &getCachePath();
+
 } // namespace reone
@@ -0,0 +1,311 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "log.h"
+
+using namespace std;
+
+namespace reone {
+
+static const int kEventCapacity = 1 << 18;
+static const int kThreadEventCapacity = 1 << 16;
+static const int kMaxFrameSectionDepth = 3;
+
+static thread_local uint32_t g_threadId = 0;
+static thread_local int g_depth = 0;
+
+Profiler &Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : _epoch(chrono::steady_clock::now()) {
+}
+
+void Profiler::init(const ProfilerOptions &opts) {
+    _opts = opts;
+
+#ifdef REONE_ENABLE_PROFILER
+    if (!_opts.traceFile.empty()) {
+        _events.resize(kEventCapacity);
+
+        // Trace loading done before the first frame, if the window starts at startup
+        _tracing = _opts.traceStart <= 0.0f;
+    }
+#else
+    if (!_opts.traceFile.empty()) {
+        warn("Profiler: disabled at build time, trace will not be written");
+        _traceWritten = true;
+    }
+#endif
+}
+
+void Profiler::deinit() {
+    if (!_opts.traceFile.empty() && !_traceWritten) {
+        mergeEvents();
+        appendTraceEvents();
+        writeTrace();
+    }
+}
+
+void Profiler::beginFrame() {
+    _frameThreadId = getThreadId();
+    _frameStart = getTime();
+}
+
+void Profiler::endFrame() {
+    int64_t frameEnd = getTime();
+    _frameTime = (frameEnd - _frameStart) / 1000.0f;
+    _frameSections.clear();
+
+    mergeEvents();
+
+    for (auto &event : _mergedEvents) {
+        if (event.end < _frameStart) continue;
+
+        // Worker threads have no frame scope, so their top level scopes are
+        // sections. Worker scopes that started in a previous frame only count
+        // towards this frame with the part that falls into it.
+        bool mainThread = event.threadId == _frameThreadId;
+        int depth = mainThread ? event.depth : event.depth + 1;
+        if (depth < 1 || depth > kMaxFrameSectionDepth) continue;
+
+        int64_t start = max(event.start, _frameStart);
+
+        auto maybeSection = find_if(_frameSections.begin(), _frameSections.end(), [&](const ProfilerSection &section) {
+            return section.mainThread == mainThread && section.depth == depth && strcmp(section.name, event.name) == 0;
+        });
+        if (maybeSection == _frameSections.end()) {
+            ProfilerSection section;
+            section.name = event.name;
+            section.mainThread = mainThread;
+            section.depth = depth;
+            section.start = start;
+            maybeSection = _frameSections.insert(_frameSections.end(), section);
+        }
+        maybeSection->start = min(maybeSection->start, start);
+        maybeSection->time += (event.end - start) / 1000.0f;
+    }
+
+    stable_sort(_frameSections.begin(), _frameSections.end(), [](const ProfilerSection &left, const ProfilerSection &right) {
+        return left.mainThread != right.mainThread ? left.mainThread : left.start < right.start;
+    });
+
+    if (_opts.traceFile.empty() || _traceWritten) return;
+
+    appendTraceEvents();
+
+    int64_t traceStart = static_cast<int64_t>(1000000.0f * _opts.traceStart);
+    int64_t traceEnd = static_cast<int64_t>(1000000.0f * (_opts.traceStart + _opts.traceDuration));
+    if (frameEnd >= traceEnd) {
+        writeTrace();
+    } else {
+        // Start recording a frame early, so that the trace window is covered from its start
+        int64_t nextFrameEnd = frameEnd + static_cast<int64_t>(1000.0f * _frameTime);
+        _tracing = nextFrameEnd >= traceStart;
+    }
+}
+
+void Profiler::mergeEvents() {
+    _mergedEvents.clear();
+
+    lock_guard<mutex> lock(_mutex);
+
+    _mergedEvents.insert(_mergedEvents.end(), _spilledEvents.begin(), _spilledEvents.end());
+    _spilledEvents.clear();
+
+    for (auto &buffer : _threadBuffers) {
+        lock_guard<mutex> bufferLock(buffer->mutex);
+        _mergedEvents.insert(_mergedEvents.end(), buffer->events.begin(), buffer->events.end());
+        buffer->events.clear();
+    }
+}
+
+void Profiler::appendTraceEvents() {
+    if (_events.empty()) return;
+
+    for (auto &event : _mergedEvents) {
+        _events[_eventCount++ % kEventCapacity] = event;
+    }
+}
+
+void Profiler::addEvent(const char *name, int64_t start, int64_t end, int depth) {
+    ThreadBuffer &buffer = getThreadBuffer();
+
+    Event event;
+    event.name = name;
+    event.threadId = buffer.threadId;
+    event.depth = depth;
+    event.start = start;
+    event.end = end;
+
+    vector<Event> spilled;
+    {
+        lock_guard<mutex> lock(buffer.mutex);
+
+        if (static_cast<int>(buffer.events.size()) < kThreadEventCapacity) {
+            buffer.events.push_back(move(event));
+            return;
+        }
+        swap(spilled, buffer.events);
+        buffer.events.push_back(move(event));
+    }
+
+    // Buffers are not merged before the first frame, so loading may fill them up
+
+    lock_guard<mutex> lock(_mutex);
+
+    if (static_cast<int>(_spilledEvents.size() + spilled.size()) <= kEventCapacity) {
+        _spilledEvents.insert(_spilledEvents.end(), spilled.begin(), spilled.end());
+    } else {
+        _droppedEventCount += static_cast<int>(spilled.size());
+    }
+}
+
+bool Profiler::isRecording() const {
+    return _overlayEnabled || _tracing;
+}
+
+void Profiler::setOverlayEnabled(bool enabled) {
+    _overlayEnabled = enabled;
+}
+
+void Profiler::setThreadName(const string &name) {
+    uint32_t threadId = getThreadId();
+
+    lock_guard<mutex> lock(_mutex);
+    _threadNames[threadId] = name;
+}
+
+uint32_t Profiler::getThreadId() {
+    if (g_threadId == 0) {
+        g_threadId = _nextThreadId++;
+    }
+    return g_threadId;
+}
+
+Profiler::ThreadBuffer &Profiler::getThreadBuffer() {
+    static thread_local ThreadBuffer *threadBuffer = nullptr;
+
+    if (!threadBuffer) {
+        auto buffer = make_unique<ThreadBuffer>();
+        buffer->threadId = getThreadId();
+        threadBuffer = buffer.get();
+
+        lock_guard<mutex> lock(_mutex);
+        _threadBuffers.push_back(move(buffer));
+    }
+
+    return *threadBuffer;
+}
+
+void Profiler::writeTrace() {
+    _traceWritten = true;
+    _tracing = false;
+
+    int64_t traceStart = static_cast<int64_t>(1000000.0f * _opts.traceStart);
+    int64_t traceEnd = static_cast<int64_t>(1000000.0f * (_opts.traceStart + _opts.traceDuration));
+
+    ofstream trace(_opts.traceFile);
+    if (!trace) {
+        warn("Profiler: failed to open trace file: " + _opts.traceFile);
+        return;
+    }
+
+    uint64_t first = _eventCount > kEventCapacity ? _eventCount - kEventCapacity : 0;
+    if (first > 0 && _events[first % kEventCapacity].start > traceStart) {
+        warn("Profiler: ring buffer overflow, trace is truncated");
+    }
+    if (_droppedEventCount > 0) {
+        warn(boost::format("Profiler: %d events dropped, trace is incomplete") % _droppedEventCount.load());
+    }
+
+    trace << "{\"traceEvents\":[";
+
+    bool separator = false;
+    for (uint64_t i = first; i < _eventCount; ++i) {
+        const Event &event = _events[i % kEventCapacity];
+        if (event.start < traceStart || event.start >= traceEnd) continue;
+
+        if (separator) trace << ",";
+        trace << boost::format("\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%d,\"dur\":%d}") % event.name % event.threadId % event.start % (event.end - event.start);
+        separator = true;
+    }
+    if (_droppedEventCount > 0) {
+        if (separator) trace << ",";
+        trace << boost::format("\n{\"name\":\"dropped_events\",\"ph\":\"C\",\"pid\":1,\"ts\":%d,\"args\":{\"count\":%d}}") % traceEnd % _droppedEventCount.load();
+        separator = true;
+    }
+
+    lock_guard<mutex> lock(_mutex);
+
+    for (auto &pair : _threadNames) {
+        if (separator) trace << ",";
+        trace << boost::format("\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}") % pair.first % pair.second;
+        separator = true;
+    }
+
+    trace << "\n]}\n";
+
+    info("Profiler: trace written to " + _opts.traceFile);
+}
+
+int64_t Profiler::getTime() const {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - _epoch).count();
+}
+
+const vector<ProfilerSection> &Profiler::frameSections() const {
+    return _frameSections;
+}
+
+float Profiler::frameTime() const {
+    return _frameTime;
+}
+
+int Profiler::droppedEventCount() const {
+    return _droppedEventCount;
+}
+
+ProfileScope::ProfileScope(const char *name) : _name(name), _depth(g_depth++), _recording(TheProfiler.isRecording()) {
+    if (_recording) {
+        _start = TheProfiler.getTime();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    --g_depth;
+
+    if (_recording) {
+        TheProfiler.addEvent(_name, _start, TheProfiler.getTime(), _depth);
+    }
+}
+
+ProfileFrame::ProfileFrame() : _scope("frame") {
+    TheProfiler.beginFrame();
+}
+
+ProfileFrame::~ProfileFrame() {
+    TheProfiler.endFrame();
+}
+
+} // namespace reone
@@ -0,0 +1,205 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace reone {
+
+/**
+ * Total time spent in a profiled scope during a frame.
+ */
+struct ProfilerSection {
+    const char *name { nullptr };
+    bool mainThread { true };
+    int depth { 0 }; /**< nesting level within the frame, starting from 1 */
+    int64_t start { 0 }; /**< start of the first occurrence in microseconds */
+    float time { 0.0f }; /**< milliseconds */
+};
+
+/**
+ * Collects durations of profiled scopes from all threads into per-thread
+ * buffers, which are merged at the end of every frame. Full buffers are
+ * spilled into a shared buffer, e.g. while loading. Computes per-frame
+ * breakdown of the main loop and can export events from a time window in
+ * Chrome trace_event format.
+ *
+ * Events are only recorded while the overlay is enabled or the trace window
+ * is open. Scopes are instrumented with PROFILE_SCOPE and PROFILE_FRAME
+ * macros, which are compiled out unless REONE_ENABLE_PROFILER is defined.
+ */
+class Profiler {
+public:
+    static Profiler &instance();
+
+    void init(const ProfilerOptions &opts);
+
+    /**
+     * Writes the trace file, if it was requested and not written yet.
+     */
+    void deinit();
+
+    void beginFrame();
+    void endFrame();
+
+    void addEvent(const char *name, int64_t start, int64_t end, int depth);
+
+    /**
+     * @return true if profiled scopes should be recorded
+     */
+    bool isRecording() const;
+
+    /**
+     * Enables recording for the per-frame breakdown, e.g. while it is displayed.
+     */
+    void setOverlayEnabled(bool enabled);
+
+    /**
+     * Sets the name of the calling thread, as displayed in the trace.
+     */
+    void setThreadName(const std::string &name);
+
+    /**
+     * @return microseconds since the profiler was created
+     */
+    int64_t getTime() const;
+
+    /**
+     * @return breakdown of the last complete frame
+     */
+    const std::vector<ProfilerSection> &frameSections() const;
+
+    /**
+     * @return duration of the last complete frame in milliseconds
+     */
+    float frameTime() const;
+
+    /**
+     * @return number of events dropped since startup, because buffers were full
+     */
+    int droppedEventCount() const;
+
+private:
+    struct Event {
+        const char *name { nullptr };
+        uint32_t threadId { 0 };
+        int depth { 0 };
+        int64_t start { 0 };
+        int64_t end { 0 };
+    };
+
+    /**
+     * Events recorded by a single thread since the last merge.
+     */
+    struct ThreadBuffer {
+        uint32_t threadId { 0 };
+        std::mutex mutex; /**< contended only while merging */
+        std::vector<Event> events;
+    };
+
+    ProfilerOptions _opts;
+    std::chrono::steady_clock::time_point _epoch;
+    std::atomic_uint32_t _nextThreadId { 1 };
+    std::atomic_bool _overlayEnabled { false };
+    std::atomic_bool _tracing { false };
+
+    std::mutex _mutex; /**< guards thread buffers and names */
+    std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers;
+    std::map<uint32_t, std::string> _threadNames;
+    std::vector<Event> _spilledEvents; /**< events of full thread buffers */
+    std::atomic_int _droppedEventCount { 0 };
+
+    std::vector<Event> _mergedEvents; /**< events merged at the end of the last frame */
+    std::vector<Event> _events; /**< ring buffer of trace events */
+    uint64_t _eventCount { 0 };
+
+    uint32_t _frameThreadId { 0 };
+    int64_t _frameStart { 0 };
+    float _frameTime { 0.0f };
+    std::vector<ProfilerSection> _frameSections;
+
+    bool _traceWritten { false };
+
+    Profiler();
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    void mergeEvents();
+    void appendTraceEvents();
+    void writeTrace();
+
+    uint32_t getThreadId();
+    ThreadBuffer &getThreadBuffer();
+};
+
+/**
+ * Records duration of the enclosing scope.
+ */
+class ProfileScope {
+public:
+    ProfileScope(const char *name);
+    ~ProfileScope();
+
+private:
+    const char *_name { nullptr };
+    int64_t _start { 0 };
+    int _depth { 0 };
+    bool _recording { false };
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+/**
+ * Marks the enclosing scope as a frame of the main loop.
+ */
+class ProfileFrame {
+public:
+    ProfileFrame();
+    ~ProfileFrame();
+
+private:
+    ProfileScope _scope;
+
+    ProfileFrame(const ProfileFrame &) = delete;
+    ProfileFrame &operator=(const ProfileFrame &) = delete;
+};
+
+#define TheProfiler Profiler::instance()
+
+#define REONE_PROFILE_CONCAT2(a, b) a##b
+#define REONE_PROFILE_CONCAT(a, b) REONE_PROFILE_CONCAT2(a, b)
+
+#ifdef REONE_ENABLE_PROFILER
+#define PROFILE_SCOPE(name) reone::ProfileScope REONE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME() reone::ProfileFrame REONE_PROFILE_CONCAT(profileFrame, __LINE__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME()
+#endif
+
+} // namespace reone
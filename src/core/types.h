@@ -17,10 +17,17 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
 namespace reone {
 
 typedef std::vector<char> ByteArray;
 
+struct ProfilerOptions {
+    std::string traceFile; /**< path to the Chrome trace file, or empty to not write one */
+    float traceStart { 0.0f }; /**< seconds since startup */
+    float traceDuration { 0.0f }; /**< seconds */
+};
+
 } // namespace reone
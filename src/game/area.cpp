@@ -18,17 +18,20 @@
 #include "area.h"
 
 #include <cassert>
+#include <chrono>
+#include <limits>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
 
-#include "glm/gtx/intersect.hpp"
 #include "glm/gtx/norm.hpp"
 
 #include "SDL2/SDL.h"
 
 #include "../core/jobs.h"
 #include "../core/log.h"
+#include "../core/pathutil.h"
+#include "../core/profiler.h"
 #include "../core/streamutil.h"
 #include "../resources/lytfile.h"
 #include "../resources/resources.h"
@@ -47,6 +50,8 @@ using namespace reone::render;
 using namespace reone::resources;
 using namespace reone::script;
 
+namespace fs = boost::filesystem;
+
 namespace reone {
 
 namespace game {
@@ -57,13 +62,23 @@ static const float kPartyMemberFollowDistance = 4.0f;
 static const float kMaxDistanceToTestCollision = 64.0f;
 static const float kElevationTestOffset = 0.1f;
 static const float kElevationTestDistance = 1.0f;
+static const float kSpatialGridCellSize = 8.0f;
+
+static const char kNavMeshCacheDirectory[] = "navmesh";
 
 static const char kPartyLeaderTag[] = "party-leader";
 static const char kPartyMember1Tag[] = "party-member-1";
 static const char kPartyMember2Tag[] = "party-member-2";
 
 Area::Area(uint32_t id, GameVersion version, ObjectFactory *factory) :
-    Object(id), _version(version), _objectFactory(factory), _navMesh(new NavMesh()) {
+    Object(id),
+    _version(version),
+    _objectFactory(factory),
+    _objectGrid(kSpatialGridCellSize),
+    _roomGrid(kSpatialGridCellSize),
+    _navMesh(new NavMesh()),
+    _pathService(new PathService(*_navMesh)),
+    _triggerGrid(kSpatialGridCellSize) {
 
     assert(_objectFactory);
 
@@ -79,6 +94,16 @@ Area::Area(uint32_t id, GameVersion version, ObjectFactory *factory) :
     _renderLists.insert(make_pair(RenderListName::Transparent, RenderList()));
 }
 
+Area::~Area() {
+    // Objects may outlive the area, e.g. when referenced by actions
+
+    for (auto &list : _objects) {
+        for (auto &object : list.second) {
+            object->setSpatialGrid(nullptr);
+        }
+    }
+}
+
 void Area::load(const string &name, const GffStruct &are, const GffStruct &git) {
     _name = name;
 
@@ -93,40 +118,69 @@ void Area::load(const string &name, const GffStruct &are, const GffStruct &git)
         creature->load(gffs);
         landObject(*creature);
         creature->setSynchronize(true);
-        _objects[ObjectType::Creature].push_back(move(creature));
+        add(creature);
     }
     for (auto &gffs : git.getList("Door List")) {
         shared_ptr<Door> door(_objectFactory->newDoor());
         door->load(gffs);
         door->setSynchronize(true);
-        _objects[ObjectType::Door].push_back(move(door));
+        add(door);
     }
     for (auto &gffs : git.getList("Placeable List")) {
         shared_ptr<Placeable> placeable(_objectFactory->newPlaceable());
         placeable->load(gffs);
         if (placeable->walkmesh()) {
-            _navMesh->add(placeable->walkmesh(), placeable->transform());
+            _navMesh->addObstacle(placeable->walkmesh(), placeable->transform());
         }
-        _objects[ObjectType::Placeable].push_back(move(placeable));
+        add(placeable);
     }
     for (auto &gffs : git.getList("WaypointList")) {
         shared_ptr<Waypoint> waypoint(_objectFactory->newWaypoint());
         waypoint->load(gffs);
-        _objects[ObjectType::Waypoint].push_back(move(waypoint));
+        add(waypoint);
     }
     for (auto &gffs : git.getList("TriggerList")) {
         shared_ptr<Trigger> trigger(_objectFactory->newTrigger());
         trigger->load(gffs);
-        _objects[ObjectType::Trigger].push_back(move(trigger));
+        add(trigger);
     }
 
-    TheJobExecutor.enqueue([this](const atomic_bool &cancel) {
+    loadNavMesh();
+}
+
+void Area::loadNavMesh() {
+    fs::path cachePath(getCachePath() / kNavMeshCacheDirectory / (_name + ".nav"));
+
+    if (_navMesh->load(cachePath)) {
+        debug("Area: nav mesh loaded from cache");
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(_navMeshMutex);
+        _navMeshPending = true;
+    }
+
+    TheJobExecutor.enqueue([this, cachePath](const atomic_bool &cancel) {
         debug("Area: compute nav mesh");
         _navMesh->compute(cancel);
-        debug("Area: nav mesh computed");
+
+        if (_navMesh->isComputed()) {
+            debug("Area: nav mesh computed");
+            _navMesh->save(cachePath);
+        }
+
+        lock_guard<mutex> lock(_navMeshMutex);
+        _navMeshPending = false;
+        _navMeshDone.notify_all();
     });
 }
 
+void Area::awaitNavMesh() const {
+    unique_lock<mutex> lock(_navMeshMutex);
+    _navMeshDone.wait(lock, [this]() { return !_navMeshPending; });
+}
+
 void Area::loadProperties(const GffStruct &gffs) {
     ResourceManager &resources = ResourceManager::instance();
     shared_ptr<TwoDaTable> musicTable(resources.find2DA("ambientmusic"));
@@ -144,17 +198,29 @@ void Area::loadLayout() {
     lyt.load(wrap(resources.find(_name, ResourceType::AreaLayout)));
 
     for (auto &lytRoom : lyt.rooms()) {
-        unique_ptr<ModelInstance> model(new ModelInstance(resources.findModel(lytRoom.name)));
+        // Room models are cached, so vertex data must outlive the first upload to be batched again
+        shared_ptr<Model> roomModel(resources.findModel(lytRoom.name));
+        if (roomModel) {
+            roomModel->setKeepMeshData(true);
+        }
+
+        unique_ptr<ModelInstance> model(new ModelInstance(roomModel));
         model->animate("animloop1", kAnimationLoop);
+        _staticGeometry.add(*model, glm::translate(glm::mat4(1.0f), lytRoom.position));
 
         shared_ptr<Walkmesh> walkmesh(resources.findWalkmesh(lytRoom.name, ResourceType::Walkmesh));
         if (walkmesh) {
             _navMesh->add(walkmesh, glm::mat4(1.0f));
         }
 
-        unique_ptr<Room> room(new Room(lytRoom.name, lytRoom.position, move(model), move(walkmesh)));
+        unique_ptr<Room> room(new Room(lytRoom.name, lytRoom.position, move(model), walkmesh));
+        if (walkmesh) {
+            _roomGrid.add(room.get(), walkmesh->aabb());
+        }
         _rooms.push_back(move(room));
     }
+
+    debug(boost::format("Area: %d static geometry batches") % _staticGeometry.batchCount());
 }
 
 void Area::loadVisibility() {
@@ -185,6 +251,76 @@ void Area::loadScripts(const GffStruct &are) {
     _scripts[ScriptType::OnUserDefined] = are.getString("OnUserDefined");
 }
 
+void Area::add(const shared_ptr<SpatialObject> &object) {
+    _objects[object->type()].push_back(object);
+    _objectById[object->id()] = object;
+
+    ObjectList &tagged = _objectsByTag[object->tag()];
+    auto position = upper_bound(tagged.begin(), tagged.end(), object->type(), [](ObjectType type, const shared_ptr<SpatialObject> &other) {
+        return type < other->type();
+    });
+    tagged.insert(position, object);
+
+    switch (object->type()) {
+        case ObjectType::Creature:
+            // Cached face may belong to a room of another area
+            static_cast<Creature &>(*object).setRoomFace(RoomFace());
+            // fallthrough
+        case ObjectType::Door:
+        case ObjectType::Placeable:
+            _objectGrid.add(object.get(), object->getBounds());
+            object->setSpatialGrid(&_objectGrid);
+            break;
+        case ObjectType::Trigger: {
+            Trigger *trigger = static_cast<Trigger *>(object.get());
+            _triggerGrid.add(trigger, trigger->geometryBounds());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Area::remove(const shared_ptr<SpatialObject> &object) {
+    uint32_t objectId = object->id();
+
+    ObjectList &objects = _objects[object->type()];
+    objects.erase(std::remove(objects.begin(), objects.end(), object), objects.end());
+    _objectById.erase(objectId);
+
+    ObjectList &tagged = _objectsByTag[object->tag()];
+    tagged.erase(std::remove(tagged.begin(), tagged.end(), object), tagged.end());
+
+    // Events of the object are no longer dispatched
+
+    auto eventsEnd = std::remove_if(_triggerEvents.begin(), _triggerEvents.end(), [&objectId](const TriggerEvent &event) {
+        return event.creatureId == objectId || event.triggerId == objectId;
+    });
+    _triggerEvents.erase(eventsEnd, _triggerEvents.end());
+
+    switch (object->type()) {
+        case ObjectType::Creature:
+            _pathService->cancel(objectId);
+            _triggersByCreature.erase(objectId);
+            // fallthrough
+        case ObjectType::Door:
+        case ObjectType::Placeable:
+            _objectGrid.remove(object.get());
+            object->setSpatialGrid(nullptr);
+            break;
+        case ObjectType::Trigger: {
+            Trigger *trigger = static_cast<Trigger *>(object.get());
+            _triggerGrid.remove(trigger);
+            for (auto &triggers : _triggersByCreature) {
+                triggers.second.erase(std::remove(triggers.second.begin(), triggers.second.end(), trigger), triggers.second.end());
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 void Area::landObject(SpatialObject &object) {
     glm::vec3 position(object.position());
     if (findElevationAt(position, position.z)) {
@@ -195,7 +331,7 @@ void Area::landObject(SpatialObject &object) {
 void Area::loadParty(const PartyConfiguration &party, const glm::vec3 &position, float heading) {
     if (party.memberCount > 0) {
         shared_ptr<Creature> partyLeader(makeCharacter(party.leader, kPartyLeaderTag, position, heading));
-        _objects[ObjectType::Creature].push_back(partyLeader);
+        add(partyLeader);
         landObject(*partyLeader);
         partyLeader->setSynchronize(true);
         _player = partyLeader;
@@ -206,7 +342,7 @@ void Area::loadParty(const PartyConfiguration &party, const glm::vec3 &position,
         shared_ptr<Creature> partyMember(makeCharacter(party.member1, kPartyMember1Tag, position, heading));
         landObject(*partyMember);
         partyMember->setSynchronize(true);
-        _objects[ObjectType::Creature].push_back(partyMember);
+        add(partyMember);
         _partyMember1 = partyMember;
 
         Creature::Action action(Creature::ActionType::Follow, _partyLeader, kPartyMemberFollowDistance);
@@ -217,7 +353,7 @@ void Area::loadParty(const PartyConfiguration &party, const glm::vec3 &position,
         shared_ptr<Creature> partyMember(makeCharacter(party.member2, kPartyMember2Tag, position, heading));
         landObject(*partyMember);
         partyMember->setSynchronize(true);
-        _objects[ObjectType::Creature].push_back(partyMember);
+        add(partyMember);
         _partyMember2 = partyMember;
 
         Creature::Action action(Creature::ActionType::Follow, _partyLeader, kPartyMemberFollowDistance);
@@ -240,11 +376,23 @@ bool Area::handle(const SDL_Event &event) {
 }
 
 void Area::update(const UpdateContext &updateCtx, GuiContext &guiCtx) {
+    PROFILE_SCOPE("Area::update");
+
     updateDelayedCommands();
 
-    for (auto &creature : _objects[ObjectType::Creature]) {
-        updateCreature(static_cast<Creature &>(*creature), updateCtx.deltaTime);
+    _pathService->update([this](uint32_t objectId, const glm::vec3 &dest, vector<glm::vec3> &&points) {
+        shared_ptr<SpatialObject> creature(find(objectId, ObjectType::Creature));
+        if (creature) {
+            static_cast<Creature &>(*creature).setPath(dest, move(points), SDL_GetTicks());
+        }
+    });
+    {
+        PROFILE_SCOPE("Area::updateCreatures");
+        for (auto &creature : _objects[ObjectType::Creature]) {
+            updateCreature(static_cast<Creature &>(*creature), updateCtx.deltaTime);
+        }
     }
+    dispatchTriggerEvents();
 
     if (_partyLeader) {
         guiCtx.hud.partyPortraits.push_back(static_cast<Creature &>(*_partyLeader).portrait());
@@ -256,19 +404,25 @@ void Area::update(const UpdateContext &updateCtx, GuiContext &guiCtx) {
         guiCtx.hud.partyPortraits.push_back(static_cast<Creature &>(*_partyMember2).portrait());
     }
 
-    for (auto &room : _rooms) {
-        shared_ptr<ModelInstance> model(room->model());
-        if (model) {
-            model->update(updateCtx.deltaTime);
-        }
+    {
+        PROFILE_SCOPE("Area::updateObjects");
+        updateObjects(updateCtx);
     }
-    for (auto &pair : _objects) {
-        for (auto &object : pair.second) {
-            object->update(updateCtx);
-        }
+
+    auto fillStart = chrono::steady_clock::now();
+    {
+        PROFILE_SCOPE("Area::fillRenderLists");
+        fillRenderLists();
     }
+    auto sortStart = chrono::steady_clock::now();
+    {
+        PROFILE_SCOPE("Area::sortRenderLists");
+        sortRenderLists(updateCtx.cameraPosition);
+    }
+    auto sortEnd = chrono::steady_clock::now();
 
-    fillRenderLists(updateCtx.cameraPosition);
+    _renderListTimes.fill = chrono::duration<float>(sortStart - fillStart).count();
+    _renderListTimes.sort = chrono::duration<float>(sortEnd - sortStart).count();
 
     switch (_debugMode) {
         case DebugMode::ModelNodes:
@@ -288,13 +442,43 @@ void Area::update(const UpdateContext &updateCtx, GuiContext &guiCtx) {
                     addToDebugContext(*object, updateCtx, guiCtx.debug);
                 }
             }
+            addAnimationStatsToDebugContext(guiCtx.debug);
+            break;
+        case DebugMode::Profiler:
+            addProfilerStatsToDebugContext(guiCtx.debug);
             break;
         default:
             break;
     }
 }
 
+void Area::updateObjects(const UpdateContext &updateCtx) {
+    _objectsToUpdate.clear();
+    for (auto &pair : _objects) {
+        for (auto &object : pair.second) {
+            _objectsToUpdate.push_back(object.get());
+        }
+    }
+
+    // Room models and objects are independent of each other, so update them in parallel
+    int roomCount = static_cast<int>(_rooms.size());
+    int count = roomCount + static_cast<int>(_objectsToUpdate.size());
+
+    TheJobExecutor.parallelFor(count, [&](int i) {
+        if (i < roomCount) {
+            shared_ptr<ModelInstance> model(_rooms[i]->model());
+            if (model && !model->isStatic()) {
+                model->update(updateCtx.deltaTime);
+            }
+        } else {
+            _objectsToUpdate[i - roomCount]->update(updateCtx);
+        }
+    });
+}
+
 void Area::updateDelayedCommands() {
+    PROFILE_SCOPE("Area::updateDelayedCommands");
+
     uint32_t now = SDL_GetTicks();
 
     for (auto &command : _delayed) {
@@ -334,36 +518,93 @@ bool Area::moveCreatureTowards(Creature &creature, const glm::vec3 &point, float
     if (findObstacleByAABB(position, newPosition + 1.0f * dir, kObstacleCreature, &creature, &obstacle)) {
         return false;
     }
-    if (findElevationAt(newPosition, newPosition.z)) {
+    RoomFace face(creature.roomFace());
+    if (findElevationAt(newPosition, newPosition.z, &face)) {
+        creature.setRoomFace(face);
         creature.setPosition(newPosition);
-        if (&creature == &*_partyLeader) {
-            updateTriggers(creature);
-        }
+        updateTriggers(creature);
     }
 
     return true;
 }
 
 void Area::updateTriggers(const Creature &creature) {
-    glm::vec3 liftedPosition(creature.position() + glm::vec3(0.0f, 0.0f, kElevationTestOffset));
-    glm::vec3 down(0.0f, 0.0f, -kElevationTestDistance);
-    glm::vec2 intersection;
-    float distance;
+    glm::vec3 position(creature.position());
+    vector<Trigger *> triggers;
+
+    _triggerGrid.query(position, position, [&](Trigger *trigger) {
+        if (trigger->isIn(position)) {
+            triggers.push_back(trigger);
+        }
+        return false;
+    });
+
+    // Scripts only run on transitions, so compare with triggers the creature
+    // was in after its previous move
+
+    auto maybePrevious = _triggersByCreature.find(creature.id());
+    if (maybePrevious == _triggersByCreature.end()) {
+        if (triggers.empty()) return;
+        maybePrevious = _triggersByCreature.insert(make_pair(creature.id(), vector<Trigger *>())).first;
+    }
+    const vector<Trigger *> &previousTriggers = maybePrevious->second;
+
+    // Scripts may change objects of the area, so they are not run here, as
+    // creatures may be being updated
+
+    for (auto trigger : previousTriggers) {
+        if (std::find(triggers.begin(), triggers.end(), trigger) == triggers.end()) {
+            _triggerEvents.push_back(TriggerEvent { trigger->id(), creature.id(), false });
+        }
+    }
+    for (auto trigger : triggers) {
+        if (std::find(previousTriggers.begin(), previousTriggers.end(), trigger) == previousTriggers.end()) {
+            _triggerEvents.push_back(TriggerEvent { trigger->id(), creature.id(), true });
+        }
+    }
+
+    // Only creatures inside triggers are tracked
+    if (triggers.empty()) {
+        _triggersByCreature.erase(maybePrevious);
+    } else {
+        maybePrevious->second = move(triggers);
+    }
+}
+
+void Area::dispatchTriggerEvents() {
+    if (_triggerEvents.empty()) return;
+
+    // Scripts may move creatures, which queues events for the next update
+
+    vector<TriggerEvent> events;
+    swap(events, _triggerEvents);
+
+    for (auto &event : events) {
+        shared_ptr<SpatialObject> object(find(event.triggerId, ObjectType::Trigger));
+        if (!object) continue;
 
-    for (auto &object : _objects[ObjectType::Trigger]) {
         Trigger &trigger = static_cast<Trigger &>(*object);
-        if (trigger.distanceTo(liftedPosition) > kMaxDistanceToTestCollision) continue;
+        if (event.entered) {
+            trigger.runOnEnterScript(event.creatureId);
+        } else {
+            trigger.runOnExitScript(event.creatureId);
+        }
+    }
 
-        const vector<glm::vec3> &geometry = trigger.geometry();
-        bool triggered =
-            (geometry.size() >= 3 && glm::intersectRayTriangle(liftedPosition, down, geometry[0], geometry[1], geometry[2], intersection, distance)) ||
-            (geometry.size() >= 4 && glm::intersectRayTriangle(liftedPosition, down, geometry[2], geometry[3], geometry[0], intersection, distance));
+    // Module transition may destroy this area, so it goes last
 
-        if (triggered) {
-            if (!trigger.linkedToModule().empty() && _onModuleTransition) {
-                _onModuleTransition(trigger.linkedToModule(), trigger.linkedTo());
-            }
-            break;
+    if (!_partyLeader || !_onModuleTransition) return;
+
+    for (auto &event : events) {
+        if (!event.entered || event.creatureId != _partyLeader->id()) continue;
+
+        shared_ptr<SpatialObject> object(find(event.triggerId, ObjectType::Trigger));
+        if (!object) continue;
+
+        Trigger &trigger = static_cast<Trigger &>(*object);
+        if (!trigger.linkedToModule().empty()) {
+            _onModuleTransition(trigger.linkedToModule(), trigger.linkedTo());
+            return;
         }
     }
 }
@@ -408,7 +649,7 @@ void Area::addToDebugContext(const RenderListItem &item, const UpdateContext &up
     const ModelNode &node = *item.node;
 
     glm::vec4 viewport(0.0f, 0.0f, 1.0f, 1.0f);
-    glm::vec3 position(item.transform[3]);
+    glm::vec3 position(_renderTransforms[item.transformIndex][3]);
 
     DebugObject object;
     object.tag = node.name();
@@ -430,8 +671,51 @@ void Area::addToDebugContext(const SpatialObject &object, const UpdateContext &u
     debugCtx.objects.push_back(move(debugObj));
 }
 
+void Area::addAnimationStatsToDebugContext(DebugContext &debugCtx) const {
+    int full = 0;
+    int reduced = 0;
+    int frozen = 0;
+
+    for (auto &list : _objects) {
+        for (auto &object : list.second) {
+            shared_ptr<ModelInstance> model(object->model());
+            if (!model || !model->visible()) continue;
+
+            switch (model->animationLOD()) {
+                case AnimationLOD::Full:
+                    ++full;
+                    break;
+                case AnimationLOD::Reduced:
+                    ++reduced;
+                    break;
+                default:
+                    ++frozen;
+                    break;
+            }
+        }
+    }
+
+    debugCtx.stats.push_back(str(boost::format("Animation LOD: full %d, reduced %d, frozen %d") % full % reduced % frozen));
+}
+
+void Area::addProfilerStatsToDebugContext(DebugContext &debugCtx) const {
+    const Profiler &profiler = TheProfiler;
+
+    debugCtx.stats.push_back(str(boost::format("Frame: %.2f ms") % profiler.frameTime()));
+
+    if (profiler.droppedEventCount() > 0) {
+        debugCtx.stats.push_back(str(boost::format("Dropped events: %d") % profiler.droppedEventCount()));
+    }
+
+    for (auto &section : profiler.frameSections()) {
+        string indent(2 * (section.depth - 1), ' ');
+        debugCtx.stats.push_back(str(boost::format("%s%s%s: %.2f ms") % indent % section.name % (section.mainThread ? "" : " (jobs)") % section.time));
+    }
+}
+
 void Area::setDebugMode(DebugMode mode) {
     _debugMode = mode;
+    TheProfiler.setOverlayEnabled(mode == DebugMode::Profiler);
 }
 
 void Area::saveTo(GameState &state) const {
@@ -464,65 +748,62 @@ void Area::loadState(const GameState &state) {
 }
 
 shared_ptr<SpatialObject> Area::find(uint32_t id) const {
-    shared_ptr<SpatialObject> object;
-    for (auto &list : _objects) {
-        object = find(id, list.first);
-        if (object) return object;
-    }
-
-    return nullptr;
+    auto maybeObject = _objectById.find(id);
+    return maybeObject != _objectById.end() ? maybeObject->second : nullptr;
 }
 
 shared_ptr<SpatialObject> Area::find(const string &tag, int nth) const {
-    shared_ptr<SpatialObject> object;
-    for (auto &list : _objects) {
-        object = find(tag, list.first, nth);
-        if (object) return object;
-    }
+    auto maybeObjects = _objectsByTag.find(tag);
+    if (maybeObjects == _objectsByTag.end() || nth < 0) return nullptr;
+
+    const ObjectList &objects = maybeObjects->second;
 
-    return nullptr;
+    return nth < static_cast<int>(objects.size()) ? objects[nth] : nullptr;
 }
 
 shared_ptr<SpatialObject> Area::find(uint32_t id, ObjectType type) const {
-    const ObjectList &list = _objects.find(type)->second;
-
-    auto it = find_if(
-        list.begin(),
-        list.end(),
-        [&id](const shared_ptr<SpatialObject> &object) { return object->id() == id; });
-
-    return it != list.end() ? *it : nullptr;
+    shared_ptr<SpatialObject> object(find(id));
+    return object && object->type() == type ? object : nullptr;
 }
 
 shared_ptr<SpatialObject> Area::find(const string &tag, ObjectType type, int nth) const {
-    const ObjectList &list = _objects.find(type)->second;
-    int idx = 0;
+    auto maybeObjects = _objectsByTag.find(tag);
+    if (maybeObjects == _objectsByTag.end()) return nullptr;
 
-    for (auto &object : list) {
-        if (object->tag() == tag && idx++ == nth) return object;
-    }
+    // Objects are ordered by type, so those of the requested type are contiguous
+
+    const ObjectList &objects = maybeObjects->second;
+    auto begin = lower_bound(objects.begin(), objects.end(), type, [](const shared_ptr<SpatialObject> &object, ObjectType type) {
+        return object->type() < type;
+    });
+    if (nth < 0 || objects.end() - begin <= nth) return nullptr;
 
-    return nullptr;
+    const shared_ptr<SpatialObject> &object = *(begin + nth);
+
+    return object->type() == type ? object : nullptr;
 }
 
 bool Area::findObstacleByWalkmesh(const glm::vec3 &from, const glm::vec3 &to, int mask, glm::vec3 &intersection, SpatialObject **obstacle) const {
+    glm::vec3 min(glm::min(from, to));
+    glm::vec3 max(glm::max(from, to));
     vector<pair<SpatialObject *, float>> candidates;
 
-    for (auto &list : _objects) {
-        if (list.first != ObjectType::Door && list.first != ObjectType::Placeable) continue;
-        if (list.first == ObjectType::Door && (mask & kObstacleDoor) == 0) continue;
-        if (list.first == ObjectType::Placeable && (mask & kObstaclePlaceable) == 0) continue;
+    _objectGrid.query(min, max, [&](SpatialObject *object) {
+        ObjectType type = object->type();
+        if (type != ObjectType::Door && type != ObjectType::Placeable) return false;
+        if (type == ObjectType::Door && (mask & kObstacleDoor) == 0) return false;
+        if (type == ObjectType::Placeable && (mask & kObstaclePlaceable) == 0) return false;
 
-        for (auto &object : list.second) {
-            if (!object->walkmesh() ||
-                (object->type() == ObjectType::Door && static_cast<Door &>(*object).isOpen())) continue;
+        if (!object->walkmesh() ||
+            (type == ObjectType::Door && static_cast<Door &>(*object).isOpen())) return false;
 
-            float distToFrom = object->distanceTo(from);
-            if (distToFrom > kMaxDistanceToTestCollision) continue;
+        float distToFrom = object->distanceTo(from);
+        if (distToFrom > kMaxDistanceToTestCollision) return false;
 
-            candidates.push_back(make_pair(object.get(), distToFrom));
-        }
-    }
+        candidates.push_back(make_pair(object, distToFrom));
+
+        return false;
+    });
 
     sort(
         candidates.begin(),
@@ -532,7 +813,7 @@ bool Area::findObstacleByWalkmesh(const glm::vec3 &from, const glm::vec3 &to, in
     for (auto &pair : candidates) {
         SpatialObject &object = *pair.first;
 
-        glm::mat4 invObjectTransform(glm::inverse(object.transform()));
+        const glm::mat4 &invObjectTransform = object.inverseTransform();
         glm::vec3 relFrom(invObjectTransform * glm::vec4(from, 1.0f));
         glm::vec3 relTo(invObjectTransform * glm::vec4(to, 1.0f));
 
@@ -545,44 +826,36 @@ bool Area::findObstacleByWalkmesh(const glm::vec3 &from, const glm::vec3 &to, in
 
     if ((mask & kObstacleRoom) == 0) return false;
 
-    for (auto &room : _rooms) {
+    return _roomGrid.query(min, max, [&](Room *room) {
         shared_ptr<Walkmesh> walkmesh(room->walkmesh());
-        if (!walkmesh) continue;
-
-        AABB aabb(walkmesh->aabb());
-        if (!aabb.contains(from) && !aabb.contains(to)) continue;
 
-        if (walkmesh->findObstacle(from, to, intersection)) {
-            return true;
-        }
-    }
+        const AABB &aabb = walkmesh->aabb();
+        if (!aabb.contains(from) && !aabb.contains(to)) return false;
 
-    return false;
+        return walkmesh->findObstacle(from, to, intersection);
+    });
 }
 
 bool Area::findObstacleByAABB(const glm::vec3 &from, const glm::vec3 &to, int mask, const SpatialObject *except, SpatialObject **obstacle) const {
     vector<pair<SpatialObject *, float>> candidates;
 
-    for (auto &list : _objects) {
-        if (list.first != ObjectType::Creature &&
-            list.first != ObjectType::Door &&
-            list.first != ObjectType::Placeable) continue;
+    _objectGrid.query(glm::min(from, to), glm::max(from, to), [&](SpatialObject *object) {
+        ObjectType type = object->type();
+        if (type == ObjectType::Creature && (mask & kObstacleCreature) == 0) return false;
+        if (type == ObjectType::Door && (mask & kObstacleDoor) == 0) return false;
+        if (type == ObjectType::Placeable && (mask & kObstaclePlaceable) == 0) return false;
 
-        if (list.first == ObjectType::Creature && (mask & kObstacleCreature) == 0) continue;
-        if (list.first == ObjectType::Door && (mask & kObstacleDoor) == 0) continue;
-        if (list.first == ObjectType::Placeable && (mask & kObstaclePlaceable) == 0) continue;
+        if (!object->model() ||
+            (type == ObjectType::Door && static_cast<Door &>(*object).isOpen()) ||
+            (except && object == except)) return false;
 
-        for (auto &object : list.second) {
-            if (!object->model() ||
-                (object->type() == ObjectType::Door && static_cast<Door &>(*object).isOpen()) ||
-                (except && object.get() == except)) continue;
+        float distToFrom = object->distanceTo(from);
+        if (distToFrom > kMaxDistanceToTestCollision) return false;
 
-            float distToFrom = object->distanceTo(from);
-            if (distToFrom > kMaxDistanceToTestCollision) continue;
+        candidates.push_back(make_pair(object, distToFrom));
 
-            candidates.push_back(make_pair(object.get(), distToFrom));
-        }
-    }
+        return false;
+    });
 
     sort(
         candidates.begin(),
@@ -603,7 +876,7 @@ bool Area::findObstacleByAABB(const glm::vec3 &from, const glm::vec3 &to, int ma
     return false;
 }
 
-bool Area::findElevationAt(const glm::vec3 &position, float &z) const {
+bool Area::findElevationAt(const glm::vec3 &position, float &z, RoomFace *face) const {
     glm::vec3 from(position + glm::vec3(0.0f, 0.0f, kElevationTestOffset));
     glm::vec3 to(from + glm::vec3(0.0f, 0.0f, -kElevationTestDistance));
     glm::vec3 intersection(0.0f);
@@ -612,19 +885,25 @@ bool Area::findElevationAt(const glm::vec3 &position, float &z) const {
     if (findObstacleByWalkmesh(from, to, kObstacleDoor | kObstaclePlaceable, intersection, &obstacle)) {
         return false;
     }
-    for (auto &room : _rooms) {
-        shared_ptr<Walkmesh> walkmesh(room->walkmesh());
-        if (!walkmesh) continue;
 
-        AABB aabb(walkmesh->aabb());
-        if (!aabb.contains(glm::vec2(position))) continue;
+    // Creatures mostly stay on the same or an adjacent face between steps
 
-        if (room->walkmesh()->findElevationAt(from, z)) {
-            return true;
-        }
+    if (face && face->room &&
+        face->room->walkmesh()->findElevationAround(face->face, from, kElevationTestOffset + kElevationTestDistance, z, &face->face)) {
+
+        return true;
     }
 
-    return false;
+    return _roomGrid.query(position, position, [&](Room *room) {
+        int roomFace = -1;
+        if (!room->walkmesh()->findElevationAt(from, z, &roomFace)) return false;
+
+        if (face) {
+            face->room = room;
+            face->face = roomFace;
+        }
+        return true;
+    });
 }
 
 const CameraStyle &Area::cameraStyle() const {
@@ -635,6 +914,14 @@ const string &Area::music() const {
     return _music;
 }
 
+const vector<shared_ptr<Room>> &Area::rooms() const {
+    return _rooms;
+}
+
+const RenderListTimes &Area::renderListTimes() const {
+    return _renderListTimes;
+}
+
 shared_ptr<SpatialObject> Area::player() const {
     return _player;
 }
@@ -17,25 +17,31 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <list>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "../gui/types.h"
 #include "../net/types.h"
 #include "../render/camera/camera.h"
 #include "../render/renderlist.h"
+#include "../render/staticgeometry.h"
 #include "../render/types.h"
 #include "../resources/types.h"
 #include "../script/variable.h"
 
 #include "multiplayer/command.h"
 #include "navmesh.h"
+#include "pathservice.h"
 #include "object/creature.h"
 #include "object/door.h"
 #include "object/placeable.h"
 #include "object/trigger.h"
 #include "object/waypoint.h"
 #include "room.h"
+#include "spatialgrid.h"
 #include "types.h"
 
 namespace reone {
@@ -49,11 +55,18 @@ class ObjectFactory;
 class Area : public Object {
 public:
     Area(uint32_t id, resources::GameVersion version, ObjectFactory *objectFactory);
+    ~Area();
 
     void load(const std::string &name, const resources::GffStruct &are, const resources::GffStruct &git);
     void loadParty(const PartyConfiguration &party, const glm::vec3 &position, float heading);
     void runOnEnterScript();
 
+    /**
+     * Blocks until the nav mesh, should it not be loaded from cache, is
+     * computed and saved.
+     */
+    void awaitNavMesh() const;
+
     bool handle(const SDL_Event &event);
     void update(const UpdateContext &updateCtx, GuiContext &guiCtx);
     bool moveCreatureTowards(Creature &creature, const glm::vec3 &point, float dt);
@@ -82,6 +95,8 @@ public:
     // General getters
     const render::CameraStyle &cameraStyle() const;
     const std::string &music() const;
+    const std::vector<std::shared_ptr<Room>> &rooms() const;
+    const RenderListTimes &renderListTimes() const;
 
     // Party getters
     std::shared_ptr<SpatialObject> player() const;
@@ -100,8 +115,12 @@ public:
 protected:
     ObjectFactory *_objectFactory { nullptr };
     std::map<ObjectType, ObjectList> _objects;
+    std::unordered_map<uint32_t, std::shared_ptr<SpatialObject>> _objectById;
+    std::unordered_map<std::string, ObjectList> _objectsByTag; /**< ordered by object type, then by addition */
     bool _scriptsEnabled { true };
     std::function<void()> _onPlayerChanged;
+    SpatialGrid<SpatialObject> _objectGrid; /**< creatures, doors and placeables */
+    SpatialGrid<Room> _roomGrid; /**< rooms with walkmeshes */
 
     // Party
     std::shared_ptr<SpatialObject> _player;
@@ -109,6 +128,13 @@ protected:
     std::shared_ptr<SpatialObject> _partyMember1;
     std::shared_ptr<SpatialObject> _partyMember2;
 
+    void add(const std::shared_ptr<SpatialObject> &object);
+
+    /**
+     * Must not be called while creatures are updated.
+     */
+    void remove(const std::shared_ptr<SpatialObject> &object);
+
     void landObject(SpatialObject &object);
 
     virtual void updateCreature(Creature &creature, float dt);
@@ -136,14 +162,33 @@ private:
         int eventNumber { 0 };
     };
 
+    struct TriggerEvent {
+        uint32_t triggerId { 0 };
+        uint32_t creatureId { 0 };
+        bool entered { false };
+    };
+
     resources::GameVersion _version { resources::GameVersion::KotOR };
     std::string _name;
     std::vector<std::shared_ptr<Room>> _rooms;
+    render::StaticGeometry _staticGeometry;
     std::unique_ptr<resources::Visibility> _visibility;
     render::CameraStyle _cameraStyle;
     std::string _music;
     std::map<RenderListName, render::RenderList> _renderLists;
+    std::vector<glm::mat4> _renderTransforms;
+    std::vector<render::RenderQueue> _renderQueues;
+    std::vector<SpatialObject *> _renderObjects;
+    RenderListTimes _renderListTimes;
+    std::vector<Object *> _objectsToUpdate;
     std::unique_ptr<NavMesh> _navMesh;
+    mutable std::mutex _navMeshMutex;
+    mutable std::condition_variable _navMeshDone;
+    bool _navMeshPending { false }; /**< guarded by _navMeshMutex */
+    std::unique_ptr<PathService> _pathService;
+    SpatialGrid<Trigger> _triggerGrid;
+    std::unordered_map<uint32_t, std::vector<Trigger *>> _triggersByCreature; /**< triggers every creature was in after its last move */
+    std::vector<TriggerEvent> _triggerEvents; /**< queued by moves, dispatched after creatures are updated */
     DebugMode _debugMode { DebugMode::None };
     std::map<ScriptType, std::string> _scripts;
     std::list<DelayedCommand> _delayed;
@@ -156,14 +201,24 @@ private:
 
     std::shared_ptr<Creature> makeCharacter(const CreatureConfiguration &character, const std::string &tag, const glm::vec3 &position, float heading);
     void updateDelayedCommands();
+    void updateObjects(const UpdateContext &updateCtx);
     bool navigateCreature(Creature &creature, const glm::vec3 &dest, float distance, float dt);
     void advanceCreatureOnPath(Creature &creature, float dt);
     void selectNextPathPoint(Creature::Path &path);
     void updateCreaturePath(Creature &creature, const glm::vec3 &dest);
-    void fillRenderLists(const glm::vec3 &cameraPosition);
+    void dispatchTriggerEvents();
+    void fillRenderLists();
+    void sortRenderLists(const glm::vec3 &cameraPosition);
     void addToDebugContext(const render::RenderListItem &item, const UpdateContext &updateCtx, DebugContext &debugCtx) const;
     void addToDebugContext(const SpatialObject &object, const UpdateContext &updateCtx, DebugContext &debugCtx) const;
-    bool findElevationAt(const glm::vec3 &position, float &z) const;
+    void addAnimationStatsToDebugContext(DebugContext &debugCtx) const;
+    void addProfilerStatsToDebugContext(DebugContext &debugCtx) const;
+
+    /**
+     * @param face if not null, walkable face to test first, which receives
+     *             the found face
+     */
+    bool findElevationAt(const glm::vec3 &position, float &z, RoomFace *face = nullptr) const;
 
     // Loading
     void loadProperties(const resources::GffStruct &gffs);
@@ -171,6 +226,7 @@ private:
     void loadVisibility();
     void loadCameraStyle(const resources::GffStruct &are);
     void loadScripts(const resources::GffStruct &are);
+    void loadNavMesh();
 };
 
 } // namespace game
@@ -19,7 +19,6 @@
 
 #include "SDL2/SDL.h"
 
-#include "../core/jobs.h"
 #include "../core/log.h"
 #include "../script/execution.h"
 
@@ -34,7 +33,10 @@ namespace game {
 static const float kKeepPathDuration = 1000.0f;
 
 void Area::updateCreature(Creature &creature, float dt) {
-    if (!creature.hasActions()) return;
+    if (!creature.hasActions()) {
+        _pathService->cancel(creature.id());
+        return;
+    }
 
     const Creature::Action &action = creature.currentAction();
     switch (action.type) {
@@ -76,6 +78,7 @@ bool Area::navigateCreature(Creature &creature, const glm::vec3 &dest, float dis
 
     if (distToDest <= distance) {
         creature.setMovementType(MovementType::None);
+        _pathService->cancel(creature.id());
         return true;
     }
 
@@ -118,28 +121,7 @@ void Area::selectNextPathPoint(Creature::Path &path) {
 }
 
 void Area::updateCreaturePath(Creature &creature, const glm::vec3 &dest) {
-    if (creature.isPathUpdating()) return;
-
-    creature.setPathUpdating();
-
-    TheJobExecutor.enqueue([=, &creature](const atomic_bool &) {
-        glm::vec3 origin(creature.position());
-        vector<glm::vec3> points(_navMesh->findPath(origin, dest));
-        uint32_t now = SDL_GetTicks();
-
-#ifdef DEBUG_PATH
-        vector<string> pointsStr;
-        pointsStr.reserve(points.size());
-
-        for (auto &point : points) {
-            pointsStr.push_back(str(boost::format("%.0f %.0f") % point.x % point.y));
-        }
-
-        debug(boost::join(pointsStr, " | "));
-#endif
-
-        creature.setPath(dest, move(points), now);
-    });
+    _pathService->request(creature.id(), creature.position(), dest);
 }
 
 } // namespace game
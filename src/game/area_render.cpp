@@ -19,6 +19,7 @@
 
 #include "glm/gtx/norm.hpp"
 
+#include "../core/jobs.h"
 #include "../render/mesh/aabb.h"
 
 using namespace std;
@@ -30,11 +31,14 @@ namespace reone {
 
 namespace game {
 
+static const int kRenderQueuesPerThread = 2;
+
 void Area::initGL() {
     for (auto &room : _rooms) {
         shared_ptr<ModelInstance> model(room->model());
         if (model) model->initGL();
     }
+    _staticGeometry.initGL();
     for (auto &pair : _objects) {
         for (auto &object : pair.second) {
             object->initGL();
@@ -42,40 +46,75 @@ void Area::initGL() {
     }
 }
 
-void Area::fillRenderLists(const glm::vec3 &cameraPosition) {
+void Area::fillRenderLists() {
+    _renderObjects.clear();
+    for (auto &pair : _objects) {
+        for (auto &object : pair.second) {
+            if (object->model()) _renderObjects.push_back(object.get());
+        }
+    }
+
+    // Rooms and objects are split into contiguous chunks, each filling its own queue
+
+    int roomCount = static_cast<int>(_rooms.size());
+    int count = roomCount + static_cast<int>(_renderObjects.size());
+    int chunkCount = min(count, kRenderQueuesPerThread * TheJobExecutor.threadCount());
+    int chunkSize = chunkCount > 0 ? (count + chunkCount - 1) / chunkCount : 0;
+
+    if (static_cast<int>(_renderQueues.size()) < chunkCount) {
+        _renderQueues.resize(chunkCount);
+    }
+
+    TheJobExecutor.parallelFor(chunkCount, [&](int chunk) {
+        RenderQueue &queue = _renderQueues[chunk];
+        queue.clear();
+
+        int end = min(count, (chunk + 1) * chunkSize);
+        for (int i = chunk * chunkSize; i < end; ++i) {
+            if (i < roomCount) {
+                const Room &room = *_rooms[i];
+                shared_ptr<ModelInstance> model(room.model());
+                if (!model || model->isStatic()) continue;
+
+                model->fillRenderLists(glm::translate(glm::mat4(1.0f), room.position()), queue);
+            } else {
+                const SpatialObject &object = *_renderObjects[i - roomCount];
+                object.model()->fillRenderLists(object.transform(), queue);
+            }
+        }
+    });
+
+    // Merge queues in chunk order, so that the result does not depend on scheduling
+
     auto &opaque = _renderLists[RenderListName::Opaque];
     auto &transparent = _renderLists[RenderListName::Transparent];
 
     opaque.clear();
     transparent.clear();
+    _renderTransforms.clear();
 
-    for (auto &room : _rooms) {
-        shared_ptr<ModelInstance> model(room->model());
-        if (!model) continue;
+    for (int i = 0; i < chunkCount; ++i) {
+        const RenderQueue &queue = _renderQueues[i];
+        uint32_t offset = static_cast<uint32_t>(_renderTransforms.size());
 
-        glm::mat4 transform(glm::translate(glm::mat4(1.0f), room->position()));
-        model->fillRenderLists(transform, opaque, transparent);
-    }
-    for (auto &pair : _objects) {
-        for (auto &object : pair.second) {
-            shared_ptr<ModelInstance> model(object->model());
-            if (!model) continue;
-
-            glm::mat4 transform(object->transform());
-            model->fillRenderLists(transform, opaque, transparent);
-        }
+        _renderTransforms.insert(_renderTransforms.end(), queue.transforms.begin(), queue.transforms.end());
+        opaque.append(queue.opaque, offset);
+        transparent.append(queue.transparent, offset);
     }
+}
 
-    opaque.sortByDistanceToCamera(cameraPosition);
-    transparent.sortByDistanceToCamera(cameraPosition);
+void Area::sortRenderLists(const glm::vec3 &cameraPosition) {
+    _renderLists[RenderListName::Opaque].sortByBatch(cameraPosition);
+    _renderLists[RenderListName::Transparent].sortByDistanceToCamera(cameraPosition);
 }
 
 void Area::render() const {
     auto &opaque = _renderLists.find(RenderListName::Opaque)->second;
     auto &transparent = _renderLists.find(RenderListName::Transparent)->second;
 
-    opaque.render(_debugMode == DebugMode::ModelNodes);
-    transparent.render(_debugMode == DebugMode::ModelNodes);
+    _staticGeometry.render();
+    opaque.render(_renderTransforms, _debugMode == DebugMode::ModelNodes);
+    transparent.render(_renderTransforms, _debugMode == DebugMode::ModelNodes);
 
     if (_debugMode == DebugMode::GameObjects) {
         AABBMesh &aabb = AABBMesh::instance();
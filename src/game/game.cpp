@@ -17,14 +17,14 @@
 
 #include "game.h"
 
-#include "GL/glew.h"
-
 #include "SDL2/SDL.h"
 
 #include "../audio/player.h"
 #include "../core/jobs.h"
 #include "../core/log.h"
+#include "../core/profiler.h"
 #include "../core/streamutil.h"
+#include "../render/glapi.h"
 #include "../resources/resources.h"
 
 #include "object/factory.h"
@@ -66,30 +66,41 @@ void Game::initObjectFactory() {
 }
 
 int Game::run() {
+    TheProfiler.init(_opts.profiler);
+    TheProfiler.setThreadName("main");
+
     _renderWindow.init();
 
     ResMan.init(_version, _path);
     TheAudioPlayer.init(_opts.audio);
     RoutineMan.init(_version, this);
 
-    configure();
+    if (_opts.bakeNavMesh) {
+        bakeNavMeshes();
+    } else if (_opts.benchmark.enabled) {
+        _renderWindow.show();
+        runBenchmark();
+    } else {
+        configure();
 
-    Cursor cursor;
-    cursor.pressed = ResMan.findTexture("gui_mp_defaultd", TextureType::Cursor);
-    cursor.pressed->initGL();
-    cursor.unpressed = ResMan.findTexture("gui_mp_defaultu", TextureType::Cursor);
-    cursor.unpressed->initGL();
+        Cursor cursor;
+        cursor.pressed = ResMan.findTexture("gui_mp_defaultd", TextureType::Cursor);
+        cursor.pressed->initGL();
+        cursor.unpressed = ResMan.findTexture("gui_mp_defaultu", TextureType::Cursor);
+        cursor.unpressed->initGL();
 
-    _renderWindow.setCursor(cursor);
-    _renderWindow.show();
+        _renderWindow.setCursor(cursor);
+        _renderWindow.show();
 
-    runMainLoop();
+        runMainLoop();
+    }
 
     TheJobExecutor.deinit();
     RoutineMan.deinit();
     TheAudioPlayer.deinit();
     ResMan.deinit();
     _renderWindow.deinit();
+    TheProfiler.deinit();
 
     return 0;
 }
@@ -131,27 +142,31 @@ void Game::loadMainMenu() {
     });
     mainMenu->setOnExit([this]() { _quit = true; });
     mainMenu->setOnModuleSelected([this](const string &name) {
-        PartyConfiguration party;
-        party.memberCount = 2;
-        party.leader.equipment.push_back("g_a_clothes01");
-        party.member1.equipment.push_back("g_a_clothes01");
-
-        switch (_version) {
-            case GameVersion::TheSithLords:
-                party.leader.appearance = kAppearanceAtton;
-                party.member1.appearance = kAppearanceKreia;
-                break;
-            default:
-                party.leader.appearance = kAppearanceCarth;
-                party.member1.appearance = kAppearanceBastila;
-                break;
-        }
-
-        loadModule(name, party);
+        loadModule(name, getDefaultParty());
     });
     _mainMenu = move(mainMenu);
 }
 
+PartyConfiguration Game::getDefaultParty() const {
+    PartyConfiguration party;
+    party.memberCount = 2;
+    party.leader.equipment.push_back("g_a_clothes01");
+    party.member1.equipment.push_back("g_a_clothes01");
+
+    switch (_version) {
+        case GameVersion::TheSithLords:
+            party.leader.appearance = kAppearanceAtton;
+            party.member1.appearance = kAppearanceKreia;
+            break;
+        default:
+            party.leader.appearance = kAppearanceCarth;
+            party.member1.appearance = kAppearanceBastila;
+            break;
+    }
+
+    return move(party);
+}
+
 void Game::loadClassSelectionGui() {
     unique_ptr<ClassSelectionGui> gui(new ClassSelectionGui(_opts.graphics));
     gui->load(_version);
@@ -190,6 +205,8 @@ void Game::loadPortraitsGui() {
 }
 
 void Game::loadModule(const string &name, const PartyConfiguration &party, string entry) {
+    PROFILE_SCOPE("Game::loadModule");
+
     info("Game: load module: " + name);
     ResMan.loadModule(name);
 
@@ -315,16 +332,30 @@ void Game::runMainLoop() {
     _ticks = SDL_GetTicks();
 
     while (!_quit) {
-        _renderWindow.processEvents(_quit);
-        update();
-
-        _renderWindow.clear();
-        drawWorld();
-        drawGUI();
-        drawGUI3D();
-        drawCursor();
-
-        _renderWindow.swapBuffers();
+        PROFILE_FRAME();
+        {
+            PROFILE_SCOPE("processEvents");
+            _renderWindow.processEvents(_quit);
+        }
+        {
+            PROFILE_SCOPE("update");
+            update();
+        }
+        {
+            PROFILE_SCOPE("drawWorld");
+            _renderWindow.clear();
+            drawWorld();
+        }
+        {
+            PROFILE_SCOPE("drawGUI");
+            drawGUI();
+            drawGUI3D();
+            drawCursor();
+        }
+        {
+            PROFILE_SCOPE("swapBuffers");
+            _renderWindow.swapBuffers();
+        }
     }
 }
 
@@ -365,6 +396,23 @@ void Game::loadNextModule() {
     _nextEntry.clear();
 }
 
+void Game::bakeNavMeshes() {
+    const vector<string> &moduleNames = ResMan.moduleNames();
+    int failedCount = 0;
+
+    for (auto &moduleName : moduleNames) {
+        try {
+            loadModule(moduleName, getDefaultParty());
+            _module->area().awaitNavMesh();
+        } catch (const exception &e) {
+            warn(boost::format("Game: failed to bake nav mesh of module %s: %s") % moduleName % e.what());
+            ++failedCount;
+        }
+    }
+
+    info(boost::format("Game: nav meshes baked for %d modules, %d failed") % (moduleNames.size() - failedCount) % failedCount);
+}
+
 float Game::getDeltaTime() {
     uint32_t ticks = SDL_GetTicks();
     float dt = (ticks - _ticks) / 1000.0f;
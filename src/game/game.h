@@ -155,6 +155,17 @@ private:
     void runMainLoop();
     std::shared_ptr<gui::GUI> currentGUI() const;
     float getDeltaTime();
+    PartyConfiguration getDefaultParty() const;
+
+    /**
+     * Loads every module, so that nav meshes missing from the cache are
+     * computed and saved.
+     */
+    void bakeNavMeshes();
+
+    // Benchmark
+    void runBenchmark();
+    std::vector<glm::vec3> getBenchmarkCameraPath() const;
 
     void onDialogSpeakerChanged(uint32_t from, uint32_t to);
 };
@@ -0,0 +1,183 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "game.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "glm/ext.hpp"
+
+#include "../core/log.h"
+#include "../core/profiler.h"
+#include "../render/backend.h"
+
+using namespace std;
+
+using namespace reone::render;
+using namespace reone::resources;
+
+namespace reone {
+
+namespace game {
+
+static const float kBenchmarkFrameTime = 1.0f / 60.0f;
+static const float kBenchmarkCameraSpeed = 4.0f;
+static const float kBenchmarkCameraHeight = 1.7f;
+
+struct BenchmarkPhase {
+    const char *name { nullptr };
+    float total { 0.0f };
+    float max { 0.0f };
+
+    BenchmarkPhase(const char *name) : name(name) {
+    }
+
+    void add(float time) {
+        total += time;
+        max = glm::max(max, time);
+    }
+};
+
+void Game::runBenchmark() {
+    string moduleName(_opts.benchmark.module);
+    if (moduleName.empty()) {
+        moduleName = _version == GameVersion::KotOR ? "end_m01aa" : "001ebo";
+    }
+    loadModule(moduleName, getDefaultParty());
+
+    vector<glm::vec3> path(getBenchmarkCameraPath());
+    vector<float> distances(1, 0.0f);
+    for (size_t i = 1; i <= path.size(); ++i) {
+        distances.push_back(distances.back() + glm::distance(path[i - 1], path[i % path.size()]));
+    }
+    float pathLength = distances.back();
+
+    BenchmarkPhase update("update");
+    BenchmarkPhase fill("fillRenderLists");
+    BenchmarkPhase sort("sort");
+    BenchmarkPhase submit("submit");
+    BenchmarkPhase frame("frame");
+
+    RenderStats stats;
+    int frameCount = max(1, _opts.benchmark.frameCount);
+
+    for (int i = 0; i < frameCount; ++i) {
+        PROFILE_FRAME();
+
+        // Move camera along the path, looping back to the start
+
+        glm::vec3 position(path.front());
+        float heading = glm::two_pi<float>() * i / frameCount;
+
+        if (pathLength > 0.0f) {
+            float distance = glm::mod(i * kBenchmarkCameraSpeed * kBenchmarkFrameTime, pathLength);
+            size_t segment = upper_bound(distances.begin(), distances.end(), distance) - distances.begin() - 1;
+            glm::vec3 from(path[segment]);
+            glm::vec3 to(path[(segment + 1) % path.size()]);
+            float segmentLength = distances[segment + 1] - distances[segment];
+            float t = segmentLength > 0.0f ? (distance - distances[segment]) / segmentLength : 0.0f;
+
+            position = glm::mix(from, to, t);
+            heading = -glm::atan(to.x - from.x, to.y - from.y);
+        }
+        _module->setFirstPersonCamera(position, heading);
+
+        TheRenderBackend.resetStats();
+
+        auto updateStart = chrono::steady_clock::now();
+        GuiContext guiCtx;
+        _module->update(kBenchmarkFrameTime, guiCtx);
+
+        auto submitStart = chrono::steady_clock::now();
+        _renderWindow.clear();
+        drawWorld();
+        _renderWindow.swapBuffers();
+        auto submitEnd = chrono::steady_clock::now();
+
+        const RenderListTimes &listTimes = _module->area().renderListTimes();
+        float updateTime = chrono::duration<float>(submitStart - updateStart).count();
+        float submitTime = chrono::duration<float>(submitEnd - submitStart).count();
+
+        update.add(updateTime - listTimes.fill - listTimes.sort);
+        fill.add(listTimes.fill);
+        sort.add(listTimes.sort);
+        submit.add(submitTime);
+        frame.add(updateTime + submitTime);
+
+        const RenderStats &frameStats = TheRenderBackend.stats();
+        stats.drawCalls += frameStats.drawCalls;
+        stats.programChanges += frameStats.programChanges;
+        stats.uniformUpdates += frameStats.uniformUpdates;
+        stats.textureBinds += frameStats.textureBinds;
+        stats.vertexArrayBinds += frameStats.vertexArrayBinds;
+        stats.bufferBinds += frameStats.bufferBinds;
+        stats.stateChanges += frameStats.stateChanges;
+        stats.bufferUploads += frameStats.bufferUploads;
+        stats.uploadedBytes += frameStats.uploadedBytes;
+    }
+
+    bool nullBackend = TheRenderBackend.type() == RenderBackendType::Null;
+
+    info(boost::format("Benchmark: module %s, %d frames, %d camera path points, %s backend") % moduleName % frameCount % path.size() % (nullBackend ? "null" : "OpenGL"));
+    info(boost::format("Benchmark: %-16s %10s %10s") % "CPU phase" % "avg, ms" % "max, ms");
+
+    for (auto phase : { &update, &fill, &sort, &submit, &frame }) {
+        info(boost::format("Benchmark: %-16s %10.3f %10.3f") % phase->name % (1000.0f * phase->total / frameCount) % (1000.0f * phase->max));
+    }
+
+    // GL calls are only counted by the null backend
+    if (!nullBackend) return;
+
+    float n = static_cast<float>(frameCount);
+    info(boost::format("Benchmark: per frame: %.1f draw calls, %.1f program changes, %.1f uniform updates, %.1f texture binds, %.1f vertex array binds, %.1f buffer binds, %.1f state changes, %.1f buffer uploads (%.1f KB)")
+        % (stats.drawCalls / n)
+        % (stats.programChanges / n)
+        % (stats.uniformUpdates / n)
+        % (stats.textureBinds / n)
+        % (stats.vertexArrayBinds / n)
+        % (stats.bufferBinds / n)
+        % (stats.stateChanges / n)
+        % (stats.bufferUploads / n)
+        % (stats.uploadedBytes / n / 1024.0f));
+}
+
+vector<glm::vec3> Game::getBenchmarkCameraPath() const {
+    // Visit centers of all rooms in layout order
+
+    vector<glm::vec3> path;
+
+    for (auto &room : _module->area().rooms()) {
+        shared_ptr<ModelInstance> model(room->model());
+        if (!model) continue;
+
+        AABB aabb(model->model()->aabb() * glm::translate(glm::mat4(1.0f), room->position()));
+        path.push_back(aabb.center());
+    }
+
+    if (path.empty()) {
+        glm::vec3 position(_module->info().entryPosition);
+        position.z += kBenchmarkCameraHeight;
+        path.push_back(position);
+    }
+
+    return move(path);
+}
+
+} // namespace game
+
+} // namespace reone
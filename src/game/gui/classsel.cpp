@@ -56,6 +56,7 @@ static map<ClassType, int> g_classDescStrRefs {
 };
 
 ClassSelectionGui::ClassSelectionGui(const GraphicsOptions &opts) : GUI(opts) {
+    _useRenderCache = true;
 }
 
 void ClassSelectionGui::load(GameVersion version) {
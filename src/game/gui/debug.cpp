@@ -71,6 +71,24 @@ void DebugGui::update(const DebugContext &ctx) {
 
         _controls.push_back(move(label));
     }
+
+    int y = 0;
+    for (auto &line : ctx.stats) {
+        Control::Extent extent(0, y, static_cast<int>(_font->measure(line)), static_cast<int>(_font->height()));
+
+        Control::Text text;
+        text.text = line;
+        text.font = _font;
+        text.color = glm::vec3(1.0f, 1.0f, 0.0f);
+        text.align = Control::TextAlign::LeftCenter;
+
+        unique_ptr<Label> label(new Label("stats" + to_string(y)));
+        label->setExtent(extent);
+        label->setText(text);
+
+        _controls.push_back(move(label));
+        y += extent.height;
+    }
 }
 
 } // namespace game
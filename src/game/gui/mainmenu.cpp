@@ -37,6 +37,7 @@ namespace game {
 MainMenu::MainMenu(const Options &opts) : GUI(opts.graphics), _opts(opts) {
     _resolutionX = 800;
     _resolutionY = 600;
+    _useRenderCache = true;
 }
 
 void MainMenu::load(GameVersion version) {
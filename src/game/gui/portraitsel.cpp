@@ -33,6 +33,7 @@ namespace reone {
 namespace game {
 
 PortraitSelectionGui::PortraitSelectionGui(const GraphicsOptions &opts) : GUI(opts) {
+    _useRenderCache = true;
 }
 
 void PortraitSelectionGui::load(GameVersion version) {
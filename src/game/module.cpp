@@ -332,16 +332,32 @@ void Module::toggleCameraType() {
     }
 }
 
+void Module::setFirstPersonCamera(const glm::vec3 &position, float heading) {
+    _firstPersonCamera->setPosition(position);
+    _firstPersonCamera->setHeading(heading);
+
+    if (_cameraType == CameraType::FirstPerson) return;
+
+    _cameraType = CameraType::FirstPerson;
+
+    if (_onCameraChanged) {
+        _onCameraChanged(_cameraType);
+    }
+}
+
 void Module::cycleDebugMode(bool forward) {
     switch (_debugMode) {
         case DebugMode::None:
-            _debugMode = forward ? DebugMode::GameObjects : DebugMode::ModelNodes;
+            _debugMode = forward ? DebugMode::GameObjects : DebugMode::Profiler;
             break;
         case DebugMode::GameObjects:
             _debugMode = forward ? DebugMode::ModelNodes : DebugMode::None;
             break;
         case DebugMode::ModelNodes:
-            _debugMode = forward ? DebugMode::None : DebugMode::GameObjects;
+            _debugMode = forward ? DebugMode::Profiler : DebugMode::GameObjects;
+            break;
+        case DebugMode::Profiler:
+            _debugMode = forward ? DebugMode::None : DebugMode::ModelNodes;
             break;
     }
 
@@ -361,6 +377,7 @@ void Module::update(float dt, GuiContext &guiCtx) {
     ctx.cameraPosition = camera->position();
     ctx.projection = camera->projection();
     ctx.view = camera->view();
+    ctx.animLod = _opts.animLod;
 
     _area->update(ctx, guiCtx);
 }
@@ -55,6 +55,13 @@ public:
     bool handle(const SDL_Event &event);
     void update(float dt, GuiContext &guiCtx);
     void update3rdPersonCameraHeading();
+
+    /**
+     * Switches to the first person camera and places it at the specified
+     * position. Used to fly scripted camera paths.
+     */
+    void setFirstPersonCamera(const glm::vec3 &position, float heading);
+
     void saveTo(GameState &state) const;
 
     // Getters
@@ -106,7 +106,7 @@ void MultiplayerArea::executeLoadCreature(const Command &cmd) {
 
     landObject(*creature);
 
-    _objects[ObjectType::Creature].push_back(move(creature));
+    add(creature);
 }
 
 void MultiplayerArea::executeSetPlayerRole(const Command &cmd) {
@@ -17,171 +17,605 @@
 
 #include "navmesh.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/format.hpp>
+
 #include "glm/gtx/norm.hpp"
 
 #include "../core/log.h"
+#include "../core/profiler.h"
 
 using namespace std;
 
 using namespace reone::render;
 
+namespace fs = boost::filesystem;
+
 namespace reone {
 
 namespace game {
 
-static const float kCellSize = 2.0f;
-static const float kTestDistance = 16.0f;
+static const float kNodeGridCellSize = 4.0f;
+static const float kMaxNodeGridCellCount = 65536.0f;
+static const int kMaxExpandedNodeCount = 1 << 17;
+
+static const char kCacheSignature[] = "RNAV";
+static const uint32_t kCacheVersion = 2;
+static const float kStitchTolerance = 0.01f;
+static const float kObstacleTestHeight = 2.0f;
+static const float kObstacleTestDepth = 0.5f;
 
 NavMesh::WalkmeshWrapper::WalkmeshWrapper(const shared_ptr<Walkmesh> &walkmesh, const glm::mat4 &transform) :
-    walkmesh(walkmesh), transform(transform) {
+    walkmesh(walkmesh), transform(transform), inverseTransform(glm::inverse(transform)) {
 }
 
-NavMesh::Edge::Edge(uint16_t toIndex, float length) : toIndex(toIndex), length(length) {
+NavMesh::Edge::Edge(uint32_t toIndex, float length) : toIndex(toIndex), length(length) {
 }
 
 void NavMesh::add(const shared_ptr<Walkmesh> &walkmesh, const glm::mat4 &transform) {
     _walkmeshes.push_back(WalkmeshWrapper(walkmesh, transform));
 }
 
-void NavMesh::compute(const atomic_bool &cancel) {
-    vector<glm::vec3> candidates;
-    glm::vec3 size;
-
-    for (auto &walkmesh : _walkmeshes) {
-        AABB aabb(walkmesh.walkmesh->aabb() * walkmesh.transform);
-        const glm::vec3 &min = aabb.min();
-        const glm::vec3 &max = aabb.max();
-        const glm::vec3 &center = aabb.center();
-        size = aabb.size();
-
-        int xCellCount = static_cast<int>(glm::floor(size.x / kCellSize));
-        if (xCellCount % 2 != 0) xCellCount++;
-        int xccHalf = xCellCount / 2;
-
-        int yCellCount = static_cast<int>(glm::floor(size.y / kCellSize));
-        if (yCellCount % 2 != 0) yCellCount++;
-        int yccHalf = yCellCount / 2;
-
-        if (xCellCount > 1000 || yCellCount > 1000) {
-            warn("Walkmesh ignored because of high cell count");
-            continue;
-        }
+void NavMesh::addObstacle(const shared_ptr<Walkmesh> &walkmesh, const glm::mat4 &transform) {
+    _obstacles.push_back(WalkmeshWrapper(walkmesh, transform));
+}
+
+static AABB getTransformedBounds(const AABB &aabb, const glm::mat4 &transform) {
+    // Must also cover rotated walkmeshes, so all corners are transformed
 
-        for (int i = -xccHalf; i <= xccHalf; ++i) {
-            float x = center.x + i * kCellSize;
-            for (int j = -yccHalf; j <= yccHalf; ++j) {
-                float y = center.y + j * kCellSize;
-                candidates.push_back(glm::vec3(x, y, center.z));
+    AABB bounds;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner(
+            (i & 1) ? aabb.max().x : aabb.min().x,
+            (i & 2) ? aabb.max().y : aabb.min().y,
+            (i & 4) ? aabb.max().z : aabb.min().z);
+
+        bounds.expand(glm::vec3(transform * glm::vec4(corner, 1.0f)));
+    }
+
+    return move(bounds);
+}
+
+typedef array<int32_t, 3> WeldCell;
+typedef pair<uint32_t, uint32_t> StitchKey;
+
+/**
+ * Merges point with a previously welded vertex within kStitchTolerance of it.
+ * Cells are as large as the tolerance, so only the neighbouring cells need to
+ * be searched.
+ *
+ * @return index of the welded vertex
+ */
+static uint32_t weldVertex(const glm::vec3 &point, map<WeldCell, vector<uint32_t>> &cells, vector<glm::vec3> &welded) {
+    glm::ivec3 cell(glm::floor(point / kStitchTolerance));
+    uint32_t nearest = kNavMeshInvalidNode;
+    float nearestDist2 = kStitchTolerance * kStitchTolerance;
+
+    for (int x = cell.x - 1; x <= cell.x + 1; ++x) {
+        for (int y = cell.y - 1; y <= cell.y + 1; ++y) {
+            for (int z = cell.z - 1; z <= cell.z + 1; ++z) {
+                auto maybeCell = cells.find(WeldCell { x, y, z });
+                if (maybeCell == cells.end()) continue;
+
+                for (uint32_t index : maybeCell->second) {
+                    float dist2 = glm::distance2(point, welded[index]);
+                    if (dist2 <= nearestDist2) {
+                        nearest = index;
+                        nearestDist2 = dist2;
+                    }
+                }
             }
         }
     }
+    if (nearest != kNavMeshInvalidNode) return nearest;
+
+    uint32_t index = static_cast<uint32_t>(welded.size());
+    welded.push_back(point);
+    cells[WeldCell { cell.x, cell.y, cell.z }].push_back(index);
+
+    return index;
+}
+
+void NavMesh::compute(const atomic_bool &cancel) {
+    PROFILE_SCOPE("NavMesh::compute");
+
+    // Discard the result of a previous computation
+
+    _computed = false;
+    _vertices.clear();
+    _edgeOffsets.clear();
+    _edges.clear();
+    _cellOffsets.clear();
+    _cellNodes.clear();
+    _gridMin = glm::vec2(0.0f);
+    _gridCellSize = 0.0f;
+    _gridWidth = 0;
+    _gridHeight = 0;
+
+    AABBBatch obstacleBounds;
+    for (auto &obstacle : _obstacles) {
+        obstacleBounds.add(getTransformedBounds(obstacle.walkmesh->aabb(), obstacle.transform));
+    }
+    vector<int> obstacleIndices(_obstacles.size());
+
+    // Every unobstructed walkable face becomes a node
 
-    glm::vec3 adjusted;
-    glm::vec3 intersection;
-    float z = 0.0f;
+    vector<vector<uint32_t>> faceNodes(_walkmeshes.size());
 
-    for (auto &can : candidates) {
+    for (size_t i = 0; i < _walkmeshes.size(); ++i) {
         if (cancel.load()) return;
 
-        for (auto &walkmesh : _walkmeshes) {
-            adjusted = glm::inverse(walkmesh.transform) * glm::vec4(can, 1.0f);
-            if (walkmesh.walkmesh->findObstacle(adjusted, adjusted + glm::vec3(0.0f, 0.0f, -100.0f), intersection)) break;
+        const WalkmeshWrapper &walkmesh = _walkmeshes[i];
+        const vector<glm::vec3> &vertices = walkmesh.walkmesh->vertices();
+        const vector<uint32_t> &indices = walkmesh.walkmesh->indices();
+
+        faceNodes[i].assign(indices.size() / 3, kNavMeshInvalidNode);
+
+        for (uint32_t face : walkmesh.walkmesh->walkableFaces()) {
+            const uint32_t *faceIndices = &indices[3 * face];
+            glm::vec3 centroid((vertices[faceIndices[0]] + vertices[faceIndices[1]] + vertices[faceIndices[2]]) / 3.0f);
+            centroid = walkmesh.transform * glm::vec4(centroid, 1.0f);
+
+            if (isObstructed(centroid, obstacleBounds, obstacleIndices)) continue;
+
+            faceNodes[i][face] = static_cast<uint32_t>(_vertices.size());
+            _vertices.push_back(centroid);
+        }
+    }
+
+    // Link nodes of adjacent faces. Faces of different walkmeshes are linked
+    // when their boundary edges coincide, within a tolerance.
+
+    vector<pair<uint32_t, uint32_t>> links;
+    map<StitchKey, uint32_t> boundaryEdges;
+    map<WeldCell, vector<uint32_t>> weldCells;
+    vector<glm::vec3> weldedVertices;
+    int stitchCount = 0;
+
+    for (size_t i = 0; i < _walkmeshes.size(); ++i) {
+        if (cancel.load()) return;
 
-            if (walkmesh.walkmesh->findElevationAt(adjusted, z)) {
-                _vertices.push_back(glm::vec3(adjusted.x, adjusted.y, z));
-                break;
+        const WalkmeshWrapper &walkmesh = _walkmeshes[i];
+        const vector<glm::vec3> &vertices = walkmesh.walkmesh->vertices();
+        const vector<uint32_t> &indices = walkmesh.walkmesh->indices();
+        const vector<int> &adjacentFaces = walkmesh.walkmesh->adjacentFaces();
+
+        for (uint32_t face : walkmesh.walkmesh->walkableFaces()) {
+            uint32_t node = faceNodes[i][face];
+            if (node == kNavMeshInvalidNode) continue;
+
+            for (int j = 0; j < 3; ++j) {
+                int adjacentFace = adjacentFaces[3 * face + j];
+                if (adjacentFace != -1) {
+                    uint32_t adjacentNode = faceNodes[i][adjacentFace];
+                    if (adjacentNode != kNavMeshInvalidNode && node < adjacentNode) {
+                        links.push_back(make_pair(node, adjacentNode));
+                    }
+                    continue;
+                }
+                glm::vec3 a(walkmesh.transform * glm::vec4(vertices[indices[3 * face + j]], 1.0f));
+                glm::vec3 b(walkmesh.transform * glm::vec4(vertices[indices[3 * face + (j + 1) % 3]], 1.0f));
+
+                // Boundary edges of adjacent rooms must match regardless of winding
+
+                uint32_t weldedA = weldVertex(a, weldCells, weldedVertices);
+                uint32_t weldedB = weldVertex(b, weldCells, weldedVertices);
+                StitchKey key(min(weldedA, weldedB), max(weldedA, weldedB));
+
+                auto maybeEdge = boundaryEdges.find(key);
+                if (maybeEdge == boundaryEdges.end()) {
+                    boundaryEdges.insert(make_pair(key, node));
+                    continue;
+                }
+                if (maybeEdge->second != node) {
+                    links.push_back(make_pair(node, maybeEdge->second));
+                    ++stitchCount;
+                }
+                boundaryEdges.erase(maybeEdge);
             }
         }
     }
 
-    int vertexCount = static_cast<int>(_vertices.size());
+    // Store edges of every node contiguously
+
+    uint32_t nodeCount = static_cast<uint32_t>(_vertices.size());
+    _edgeOffsets.assign(nodeCount + 1, 0);
 
-    for (int i = 0; i < vertexCount - 1; ++i) {
-        for (int j = i + 1; j < vertexCount; ++j) {
-            float length = glm::distance2(glm::vec2(_vertices[i]), glm::vec2(_vertices[j]));
-            if (length > 2.0f * kCellSize * kCellSize) continue;
+    for (auto &link : links) {
+        ++_edgeOffsets[link.first + 1];
+        ++_edgeOffsets[link.second + 1];
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        _edgeOffsets[i + 1] += _edgeOffsets[i];
+    }
+    _edges.assign(2 * links.size(), Edge(0, 0.0f));
+
+    vector<uint32_t> edgeCounts(nodeCount, 0);
+    for (auto &link : links) {
+        float length = glm::distance(_vertices[link.first], _vertices[link.second]);
+        _edges[_edgeOffsets[link.first] + edgeCounts[link.first]++] = Edge(link.second, length);
+        _edges[_edgeOffsets[link.second] + edgeCounts[link.second]++] = Edge(link.first, length);
+    }
+
+    computeNodeGrid();
+
+    debug(boost::format("NavMesh: %d nodes, %d edges, %d stitched between walkmeshes") % nodeCount % links.size() % stitchCount);
+
+    _computed = true;
+}
 
-            _edges[i].push_back(Edge(j, length));
-            _edges[j].push_back(Edge(i, length));
+uint64_t NavMesh::getSourceHash() const {
+    // 64-bit FNV-1a of walkmesh geometry and transforms, in order of
+    // addition. All hashed values are 32-bit, so words are hashed instead of
+    // bytes.
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    auto hashWords = [&hash](const void *data, size_t size) {
+        const uint32_t *words = static_cast<const uint32_t *>(data);
+        for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+            hash ^= words[i];
+            hash *= 0x100000001b3ull;
         }
+    };
+    auto hashVector = [&hashWords](const auto &values) {
+        uint32_t count = static_cast<uint32_t>(values.size());
+        hashWords(&count, sizeof(count));
+        if (count > 0) {
+            hashWords(&values[0], count * sizeof(values[0]));
+        }
+    };
+
+    for (auto walkmeshes : { &_walkmeshes, &_obstacles }) {
+        uint32_t count = static_cast<uint32_t>(walkmeshes->size());
+        hashWords(&count, sizeof(count));
+
+        for (auto &walkmesh : *walkmeshes) {
+            hashVector(walkmesh.walkmesh->vertices());
+            hashVector(walkmesh.walkmesh->indices());
+            hashVector(walkmesh.walkmesh->walkableFaces());
+            hashWords(&walkmesh.transform[0][0], sizeof(walkmesh.transform));
+        }
+    }
+
+    return hash;
+}
+
+bool NavMesh::load(const fs::path &path) {
+    ifstream cache(path.string(), ios::binary);
+    if (!cache) return false;
+
+    auto read = [&cache](void *data, size_t size) {
+        return size == 0 || static_cast<bool>(cache.read(static_cast<char *>(data), size));
+    };
+
+    char signature[4];
+    uint32_t version, nodeCount, edgeCount;
+    uint64_t hash;
+    if (!read(signature, sizeof(signature)) ||
+        strncmp(signature, kCacheSignature, sizeof(signature)) != 0 ||
+        !read(&version, sizeof(version)) ||
+        version != kCacheVersion ||
+        !read(&hash, sizeof(hash)) ||
+        hash != getSourceHash()) {
+
+        debug("NavMesh: cache is stale: " + path.string());
+        return false;
+    }
+
+    vector<glm::vec3> vertices;
+    vector<uint32_t> edgeOffsets;
+    vector<Edge> edges;
+
+    bool valid =
+        read(&nodeCount, sizeof(nodeCount)) &&
+        read(&edgeCount, sizeof(edgeCount)) &&
+        nodeCount < numeric_limits<uint32_t>::max();
+
+    // Counts are checked against the file size before allocating, so that a
+    // corrupted cache cannot request huge arrays
+
+    if (valid) {
+        streamoff position = cache.tellg();
+        cache.seekg(0, ios::end);
+        streamoff remaining = cache.tellg() - position;
+        cache.seekg(position);
+
+        uint64_t expected =
+            static_cast<uint64_t>(nodeCount) * sizeof(glm::vec3) +
+            (static_cast<uint64_t>(nodeCount) + 1) * sizeof(uint32_t) +
+            static_cast<uint64_t>(edgeCount) * sizeof(Edge);
+
+        valid = cache && remaining >= 0 && expected <= static_cast<uint64_t>(remaining);
+    }
+    if (valid) {
+        vertices.resize(nodeCount);
+        edgeOffsets.resize(nodeCount + 1);
+        edges.resize(edgeCount, Edge(0, 0.0f));
+
+        valid =
+            read(vertices.data(), nodeCount * sizeof(glm::vec3)) &&
+            read(edgeOffsets.data(), (nodeCount + 1) * sizeof(uint32_t)) &&
+            read(edges.data(), edgeCount * sizeof(Edge));
     }
 
+    // Indices are validated, so that a corrupted cache cannot break the search
+
+    valid = valid && edgeOffsets.front() == 0 && edgeOffsets.back() == edgeCount;
+    for (uint32_t i = 0; valid && i < nodeCount; ++i) {
+        valid = edgeOffsets[i] <= edgeOffsets[i + 1];
+    }
+    for (uint32_t i = 0; valid && i < edgeCount; ++i) {
+        valid = edges[i].toIndex < nodeCount;
+    }
+    if (!valid) {
+        warn("NavMesh: cache is corrupted: " + path.string());
+        return false;
+    }
+
+    _vertices = move(vertices);
+    _edgeOffsets = move(edgeOffsets);
+    _edges = move(edges);
+    computeNodeGrid();
+
     _computed = true;
+
+    return true;
 }
 
-const vector<glm::vec3> NavMesh::findPath(const glm::vec3 &from, const glm::vec3 &to) const {
+void NavMesh::save(const fs::path &path) const {
+    if (!_computed) return;
+
+    boost::system::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    ofstream cache(path.string(), ios::binary);
+    if (!cache) {
+        warn("NavMesh: failed to open cache for writing: " + path.string());
+        return;
+    }
+
+    auto write = [&cache](const void *data, size_t size) {
+        cache.write(static_cast<const char *>(data), size);
+    };
+
+    uint32_t version = kCacheVersion;
+    uint64_t hash = getSourceHash();
+    uint32_t nodeCount = static_cast<uint32_t>(_vertices.size());
+    uint32_t edgeCount = static_cast<uint32_t>(_edges.size());
+
+    write(kCacheSignature, 4);
+    write(&version, sizeof(version));
+    write(&hash, sizeof(hash));
+    write(&nodeCount, sizeof(nodeCount));
+    write(&edgeCount, sizeof(edgeCount));
+    write(_vertices.data(), nodeCount * sizeof(glm::vec3));
+    write(_edgeOffsets.data(), (nodeCount + 1) * sizeof(uint32_t));
+    write(_edges.data(), edgeCount * sizeof(Edge));
+
+    if (!cache) {
+        warn("NavMesh: failed to write cache: " + path.string());
+    }
+}
+
+bool NavMesh::isObstructed(const glm::vec3 &position, const AABBBatch &obstacleBounds, vector<int> &obstacleIndices) const {
+    Ray verticalLine;
+    verticalLine.origin = position;
+    verticalLine.dir = glm::vec3(0.0f, 0.0f, -1.0f);
+    verticalLine.minDistance = -numeric_limits<float>::max();
+
+    int obstacleCount = intersectRayBoxes(verticalLine, obstacleBounds, obstacleIndices.data());
+    glm::vec3 intersection(0.0f);
+
+    for (int i = 0; i < obstacleCount; ++i) {
+        const WalkmeshWrapper &obstacle = _obstacles[obstacleIndices[i]];
+        glm::vec3 from(obstacle.inverseTransform * glm::vec4(position + glm::vec3(0.0f, 0.0f, kObstacleTestHeight), 1.0f));
+        glm::vec3 to(obstacle.inverseTransform * glm::vec4(position - glm::vec3(0.0f, 0.0f, kObstacleTestDepth), 1.0f));
+
+        if (obstacle.walkmesh->findObstacle(from, to, intersection)) return true;
+    }
+
+    return false;
+}
+
+/**
+ * Per-thread state of the path search, reused between searches. Arrays are
+ * indexed by node and only hold values for nodes stamped with the current
+ * search.
+ */
+struct FindPathContext {
+    uint32_t search { 0 };
+    vector<uint32_t> stamps;
+    vector<float> gScores;
+    vector<uint32_t> parents;
+    vector<uint8_t> closed;
+    vector<pair<float, uint32_t>> openSet; /**< binary heap of f-scores */
+
+    void begin(size_t nodeCount) {
+        if (stamps.size() < nodeCount) {
+            stamps.resize(nodeCount, 0);
+            gScores.resize(nodeCount);
+            parents.resize(nodeCount);
+            closed.resize(nodeCount);
+        }
+        if (++search == 0) {
+            fill(stamps.begin(), stamps.end(), 0);
+            search = 1;
+        }
+        openSet.clear();
+    }
+};
+
+static thread_local FindPathContext g_findPathContext;
+
+const vector<glm::vec3> NavMesh::findPath(const glm::vec3 &from, const glm::vec3 &to, int *expandedNodeCount) const {
+    PROFILE_SCOPE("NavMesh::findPath");
+
+    if (expandedNodeCount) {
+        *expandedNodeCount = 0;
+    }
     if (!_computed) {
         return vector<glm::vec3> { from, to };
     }
-    uint16_t fromIdx = getNearestVertex(from);
-    uint16_t toIdx = getNearestVertex(to);
-    if (fromIdx == 0xffff || toIdx == 0xffff) {
+    uint32_t fromIdx = getNearestNode(from);
+    uint32_t toIdx = getNearestNode(to);
+    if (fromIdx == kNavMeshInvalidNode || toIdx == kNavMeshInvalidNode) {
         return vector<glm::vec3> { from, to };
     }
 
-    FindPathContext ctx;
-    ctx.distToOrigin = { { fromIdx, make_pair(fromIdx, 0.0f) } };
-    ctx.queue.push(fromIdx);
+    FindPathContext &ctx = g_findPathContext;
+    ctx.begin(_vertices.size());
+
+    auto compareScores = [](const pair<float, uint32_t> &left, const pair<float, uint32_t> &right) {
+        return left.first > right.first;
+    };
+    auto openNode = [&](uint32_t idx, float gScore, uint32_t parent) {
+        ctx.stamps[idx] = ctx.search;
+        ctx.gScores[idx] = gScore;
+        ctx.parents[idx] = parent;
+        ctx.closed[idx] = 0;
+        ctx.openSet.push_back(make_pair(gScore + glm::distance(_vertices[idx], _vertices[toIdx]), idx));
+        push_heap(ctx.openSet.begin(), ctx.openSet.end(), compareScores);
+    };
+    openNode(fromIdx, 0.0f, kNavMeshInvalidNode);
+
+    // Nodes may be pushed more than once, in which case only the entry with
+    // the lowest score is expanded
+
+    int expanded = 0;
+    bool found = false;
+
+    while (!ctx.openSet.empty() && expanded < kMaxExpandedNodeCount) {
+        pop_heap(ctx.openSet.begin(), ctx.openSet.end(), compareScores);
+        uint32_t idx = ctx.openSet.back().second;
+        ctx.openSet.pop_back();
+
+        if (ctx.closed[idx]) continue;
+        ctx.closed[idx] = 1;
+        ++expanded;
+
+        if (idx == toIdx) {
+            found = true;
+            break;
+        }
+        for (uint32_t i = _edgeOffsets[idx]; i < _edgeOffsets[idx + 1]; ++i) {
+            const Edge &edge = _edges[i];
+            float gScore = ctx.gScores[idx] + edge.length;
+
+            if (ctx.stamps[edge.toIndex] == ctx.search && (ctx.closed[edge.toIndex] || ctx.gScores[edge.toIndex] <= gScore)) continue;
 
-    while (!ctx.queue.empty()) {
-        uint16_t idx = ctx.queue.front();
-        ctx.queue.pop();
-        visit(idx, ctx);
+            openNode(edge.toIndex, gScore, idx);
+        }
+    }
+    if (expandedNodeCount) {
+        *expandedNodeCount = expanded;
     }
-    if (ctx.distToOrigin.find(toIdx) == ctx.distToOrigin.end()) {
+    if (!found) {
         return vector<glm::vec3> { from, to };
     }
 
-    uint16_t idx = toIdx;
     vector<glm::vec3> path;
-
-    while (true) {
-        path.insert(path.begin(), _vertices[idx]);
-        if (idx == fromIdx) break;
-
-        auto &pair = ctx.distToOrigin[idx];
-        idx = pair.first;
+    for (uint32_t idx = toIdx; idx != kNavMeshInvalidNode; idx = ctx.parents[idx]) {
+        path.push_back(_vertices[idx]);
     }
+    reverse(path.begin(), path.end());
 
     return move(path);
 }
 
-uint16_t NavMesh::getNearestVertex(const glm::vec3 &point) const {
-    uint16_t index = 0xffff;
-    float minDist = 0.0f;
+void NavMesh::computeNodeGrid() {
+    glm::vec2 min(numeric_limits<float>::max());
+    glm::vec2 max(-numeric_limits<float>::max());
 
-    for (int i = 0; i < _vertices.size(); ++i) {
-        float dist = glm::distance2(glm::vec2(point), glm::vec2(_vertices[i]));
+    for (auto &vertex : _vertices) {
+        min = glm::min(min, glm::vec2(vertex));
+        max = glm::max(max, glm::vec2(vertex));
+    }
+    if (_vertices.empty()) {
+        min = max = glm::vec2(0.0f);
+    }
 
-        if (index == 0xffff || dist < minDist) {
-            index = i;
-            minDist = dist;
-        }
+    // Cells are enlarged for very large areas, to keep the grid compact
+
+    glm::vec2 size(max - min);
+    _gridCellSize = glm::max(kNodeGridCellSize, glm::sqrt(size.x * size.y / kMaxNodeGridCellCount));
+    _gridMin = min;
+    _gridWidth = static_cast<int>(size.x / _gridCellSize) + 1;
+    _gridHeight = static_cast<int>(size.y / _gridCellSize) + 1;
+
+    vector<uint32_t> nodeCells(_vertices.size());
+    _cellOffsets.assign(_gridWidth * _gridHeight + 1, 0);
+
+    for (uint32_t i = 0; i < _vertices.size(); ++i) {
+        glm::ivec2 cell(getNodeGridCell(_vertices[i]));
+        nodeCells[i] = cell.y * _gridWidth + cell.x;
+        ++_cellOffsets[nodeCells[i] + 1];
+    }
+    for (size_t i = 1; i < _cellOffsets.size(); ++i) {
+        _cellOffsets[i] += _cellOffsets[i - 1];
     }
 
-    return index;
+    vector<uint32_t> cellCounts(_gridWidth * _gridHeight, 0);
+    _cellNodes.resize(_vertices.size());
+
+    for (uint32_t i = 0; i < _vertices.size(); ++i) {
+        _cellNodes[_cellOffsets[nodeCells[i]] + cellCounts[nodeCells[i]]++] = i;
+    }
 }
 
-void NavMesh::visit(uint16_t index, FindPathContext &ctx) const {
-    if (ctx.visited.find(index) != ctx.visited.end()) return;
+glm::ivec2 NavMesh::getNodeGridCell(const glm::vec3 &point) const {
+    glm::ivec2 cell(glm::floor((glm::vec2(point) - _gridMin) / _gridCellSize));
+    return glm::clamp(cell, glm::ivec2(0), glm::ivec2(_gridWidth - 1, _gridHeight - 1));
+}
 
-    float dist = ctx.distToOrigin[index].second;
-    if (dist > kTestDistance) return;
+uint32_t NavMesh::getNearestNode(const glm::vec3 &point) const {
+    if (!_computed || _vertices.empty()) return kNavMeshInvalidNode;
 
-    auto edges = _edges.find(index);
-    if (edges != _edges.end()) {
-        for (auto &edge : edges->second) {
-            auto it = ctx.distToOrigin.find(edge.toIndex);
-            if (it == ctx.distToOrigin.end() || it->second.second > dist + edge.length) {
-                ctx.distToOrigin[edge.toIndex] = make_pair(index, dist + edge.length);
-            }
-            if (ctx.visited.find(edge.toIndex) == ctx.visited.end()) {
-                ctx.queue.push(edge.toIndex);
+    uint32_t nearest = kNavMeshInvalidNode;
+    float nearestDist2 = numeric_limits<float>::max();
+    glm::ivec2 center(getNodeGridCell(point));
+    int maxRadius = glm::max(_gridWidth, _gridHeight);
+
+    // Visit rings of cells around the cell containing point. Nodes beyond
+    // ring r are at least r cells away from point in the XY plane.
+
+    for (int radius = 0; radius <= maxRadius; ++radius) {
+        for (int y = center.y - radius; y <= center.y + radius; ++y) {
+            if (y < 0 || y >= _gridHeight) continue;
+
+            bool edgeRow = y == center.y - radius || y == center.y + radius;
+            int step = edgeRow ? 1 : 2 * radius;
+
+            for (int x = center.x - radius; x <= center.x + radius; x += glm::max(step, 1)) {
+                if (x < 0 || x >= _gridWidth) continue;
+
+                int cell = y * _gridWidth + x;
+                for (uint32_t i = _cellOffsets[cell]; i < _cellOffsets[cell + 1]; ++i) {
+                    uint32_t node = _cellNodes[i];
+                    float dist2 = glm::distance2(point, _vertices[node]);
+                    if (dist2 < nearestDist2) {
+                        nearest = node;
+                        nearestDist2 = dist2;
+                    }
+                }
             }
         }
+        float minDist = radius * _gridCellSize;
+        if (nearest != kNavMeshInvalidNode && nearestDist2 <= minDist * minDist) break;
     }
 
-    ctx.visited.insert(index);
+    return nearest;
+}
+
+bool NavMesh::isComputed() const {
+    return _computed;
 }
 
 } // namespace game
@@ -18,11 +18,11 @@
 #pragma once
 
 #include <atomic>
-#include <map>
+#include <cstdint>
 #include <memory>
-#include <mutex>
-#include <set>
-#include <queue>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
 
 #include "../render/walkmesh.h"
 
@@ -30,46 +30,107 @@ namespace reone {
 
 namespace game {
 
+static const uint32_t kNavMeshInvalidNode = 0xffffffff;
+
+/**
+ * Navigation graph over walkable walkmesh faces. Every walkable face is a
+ * node, positioned at the face centroid. Nodes are connected across shared
+ * edges, both within a walkmesh and between walkmeshes of adjacent rooms.
+ * Faces under obstacles, e.g. placeables, are excluded.
+ */
 class NavMesh {
 public:
     NavMesh() = default;
 
+    /**
+     * Adds a walkmesh, whose walkable faces become nodes of the graph.
+     */
     void add(const std::shared_ptr<render::Walkmesh> &walkmesh, const glm::mat4 &transform);
+
+    /**
+     * Adds a walkmesh, whose non-walkable faces exclude nodes below them.
+     */
+    void addObstacle(const std::shared_ptr<render::Walkmesh> &walkmesh, const glm::mat4 &transform);
+
     void compute(const std::atomic_bool &cancel);
 
-    const std::vector<glm::vec3> findPath(const glm::vec3 &from, const glm::vec3 &to) const;
+    /**
+     * Loads the computed mesh from a cache file, unless it was computed from
+     * different walkmeshes or transforms.
+     *
+     * @return true if the mesh was loaded
+     */
+    bool load(const boost::filesystem::path &path);
+
+    void save(const boost::filesystem::path &path) const;
+
+    /**
+     * Finds the shortest path between nodes nearest to from and to using A*.
+     * Falls back to a straight line if either node is not found, the nodes
+     * are not connected or the search exceeds its node limit.
+     *
+     * @param expandedNodeCount if not null, receives the number of nodes
+     *                          expanded by the search
+     */
+    const std::vector<glm::vec3> findPath(const glm::vec3 &from, const glm::vec3 &to, int *expandedNodeCount = nullptr) const;
+
+    /**
+     * @return index of the node nearest to point, or kNavMeshInvalidNode
+     */
+    uint32_t getNearestNode(const glm::vec3 &point) const;
+
+    /**
+     * @return hash of walkmeshes and transforms the mesh is computed from
+     */
+    uint64_t getSourceHash() const;
+
+    bool isComputed() const;
 
 private:
     struct WalkmeshWrapper {
         std::shared_ptr<render::Walkmesh> walkmesh;
         glm::mat4 transform;
+        glm::mat4 inverseTransform;
 
         WalkmeshWrapper(const std::shared_ptr<render::Walkmesh> &walkmesh, const glm::mat4 &transform);
     };
 
     struct Edge {
-        uint16_t toIndex { 0 };
+        uint32_t toIndex { 0 };
         float length { 0 };
 
-        Edge(uint16_t toIndex, float length);
-    };
-
-    struct FindPathContext {
-        std::map<uint16_t, std::pair<uint16_t, float>> distToOrigin;
-        std::set<uint16_t> visited;
-        std::queue<uint16_t> queue;
+        Edge(uint32_t toIndex, float length);
     };
 
     std::vector<WalkmeshWrapper> _walkmeshes;
+    std::vector<WalkmeshWrapper> _obstacles;
+
     std::vector<glm::vec3> _vertices;
-    std::map<uint16_t, std::vector<Edge>> _edges;
+    std::vector<uint32_t> _edgeOffsets; /**< edges of node i are in [_edgeOffsets[i], _edgeOffsets[i + 1]) */
+    std::vector<Edge> _edges;
+
+    // Uniform grid over nodes in the XY plane, for nearest node lookup
+
+    glm::vec2 _gridMin { 0.0f };
+    float _gridCellSize { 0.0f };
+    int _gridWidth { 0 };
+    int _gridHeight { 0 };
+    std::vector<uint32_t> _cellOffsets; /**< nodes of cell i are in [_cellOffsets[i], _cellOffsets[i + 1]) */
+    std::vector<uint32_t> _cellNodes;
+
     std::atomic_bool _computed { false };
 
     NavMesh(const NavMesh &) = delete;
     NavMesh &operator=(const NavMesh &) = delete;
 
-    uint16_t getNearestVertex(const glm::vec3 &point) const;
-    void visit(uint16_t index, FindPathContext &ctx) const;
+    /**
+     * @return true if the node at position is covered by an obstacle
+     */
+    bool isObstructed(const glm::vec3 &position, const render::AABBBatch &obstacleBounds, std::vector<int> &obstacleIndices) const;
+
+    void computeNodeGrid();
+
+    glm::ivec2 getNodeGridCell(const glm::vec3 &point) const;
 };
 
 } // namespace game
@@ -381,11 +381,10 @@ void Creature::setPath(const glm::vec3 &dest, vector<glm::vec3> &&points, uint32
     path->timeFound = timeFound;
 
     _path = move(path);
-    _pathUpdating = false;
 }
 
-void Creature::setPathUpdating() {
-    _pathUpdating = true;
+void Creature::setRoomFace(const RoomFace &face) {
+    _roomFace = face;
 }
 
 Gender Creature::gender() const {
@@ -425,10 +424,6 @@ shared_ptr<Creature::Path> &Creature::path() {
     return _path;
 }
 
-bool Creature::isPathUpdating() const {
-    return _pathUpdating;
-}
-
 float Creature::walkSpeed() const {
     return _walkSpeed;
 }
@@ -437,6 +432,10 @@ float Creature::runSpeed() const {
     return _runSpeed;
 }
 
+const RoomFace &Creature::roomFace() const {
+    return _roomFace;
+}
+
 } // namespace game
 
 } // namespace reone
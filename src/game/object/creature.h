@@ -17,13 +17,13 @@
 
 #pragma once
 
-#include <atomic>
 #include <queue>
 
 #include "../../resources/2dafile.h"
 #include "../../script/types.h"
 
 #include "../item.h"
+#include "../room.h"
 
 #include "spatial.h"
 
@@ -114,7 +114,7 @@ public:
     virtual void setMovementType(MovementType type);
     virtual void setTalking(bool talking);
     void setPath(const glm::vec3 &dest, std::vector<glm::vec3> &&points, uint32_t timeFound);
-    void setPathUpdating();
+    void setRoomFace(const RoomFace &face);
 
     // Getters
     Gender gender() const;
@@ -126,10 +126,14 @@ public:
     bool hasActions() const;
     const Action &currentAction() const;
     std::shared_ptr<Path> &path();
-    bool isPathUpdating() const;
     float walkSpeed() const;
     float runSpeed() const;
 
+    /**
+     * @return walkable face the creature was last found standing on
+     */
+    const RoomFace &roomFace() const;
+
 protected:
     MovementType _movementType { MovementType::None };
     bool _talking { false };
@@ -148,9 +152,9 @@ private:
     std::string _conversation;
     std::list<Action> _actions;
     std::shared_ptr<Path> _path;
-    std::atomic_bool _pathUpdating { false };
     float _walkSpeed { 0.0f };
     float _runSpeed { 0.0f };
+    RoomFace _roomFace;
     std::map<ScriptType, std::string> _scripts;
 
     // Loading
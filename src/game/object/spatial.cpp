@@ -17,6 +17,7 @@
 
 #include "spatial.h"
 
+#include "glm/gtc/matrix_inverse.hpp"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtx/norm.hpp"
 
@@ -67,9 +68,19 @@ void SpatialObject::update(const UpdateContext &ctx) {
         _model->hide();
     }
     _model->setAlpha(alpha);
+    _model->setAnimationLOD(getAnimationLOD(ctx, distanceToCamera), ctx.animLod.reducedRate);
     _model->update(ctx.deltaTime);
 }
 
+AnimationLOD SpatialObject::getAnimationLOD(const UpdateContext &ctx, float distanceToCamera) const {
+    const AnimationLODOptions &opts = ctx.animLod;
+
+    if (distanceToCamera < opts.nearDistance * opts.nearDistance) return AnimationLOD::Full;
+    if (distanceToCamera < opts.farDistance * opts.farDistance) return AnimationLOD::Reduced;
+
+    return AnimationLOD::Frozen;
+}
+
 void SpatialObject::initGL() {
     if (!_model) return;
 
@@ -99,6 +110,40 @@ float SpatialObject::heading() const {
 const glm::mat4 &SpatialObject::transform() const {
     return _transform;
 }
+
+const glm::mat4 &SpatialObject::inverseTransform() const {
+    return _inverseTransform;
+}
+
+static void expandByTransformedBox(const AABB &box, const glm::mat4 &transform, AABB &bounds) {
+    // Transform every corner, so that bounds of rotated objects are conservative
+
+    const glm::vec3 &min = box.min();
+    const glm::vec3 &max = box.max();
+
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner(
+            (i & 1) ? max.x : min.x,
+            (i & 2) ? max.y : min.y,
+            (i & 4) ? max.z : min.z);
+
+        bounds.expand(glm::vec3(transform * glm::vec4(corner, 1.0f)));
+    }
+}
+
+AABB SpatialObject::getBounds() const {
+    AABB bounds(_position, _position);
+
+    if (_model) {
+        expandByTransformedBox(_model->model()->aabb(), _transform, bounds);
+    }
+    if (_walkmesh) {
+        expandByTransformedBox(_walkmesh->aabb(), _transform, bounds);
+    }
+
+    return move(bounds);
+}
+
 void SpatialObject::setPosition(const glm::vec3 &position) {
     _position = position;
     updateTransform();
@@ -107,6 +152,11 @@ void SpatialObject::setPosition(const glm::vec3 &position) {
 void SpatialObject::updateTransform() {
     _transform = glm::translate(glm::mat4(1.0f), _position);
     _transform *= glm::eulerAngleZ(_heading);
+    _inverseTransform = glm::affineInverse(_transform);
+
+    if (_spatialGrid) {
+        _spatialGrid->update(this, getBounds());
+    }
 }
 
 void SpatialObject::setHeading(float heading) {
@@ -114,6 +164,10 @@ void SpatialObject::setHeading(float heading) {
     updateTransform();
 }
 
+void SpatialObject::setSpatialGrid(SpatialGrid<SpatialObject> *grid) {
+    _spatialGrid = grid;
+}
+
 shared_ptr<ModelInstance> SpatialObject::model() const {
     return _model;
 }
@@ -25,6 +25,8 @@
 #include "../../render/modelinstance.h"
 #include "../../render/walkmesh.h"
 
+#include "../spatialgrid.h"
+
 namespace reone {
 
 namespace game {
@@ -48,10 +50,21 @@ public:
     const glm::vec3 &position() const;
     float heading() const;
     const glm::mat4 &transform() const;
+    const glm::mat4 &inverseTransform() const;
+
+    /**
+     * @return world space bounds of the model and the walkmesh
+     */
+    render::AABB getBounds() const;
 
     void setPosition(const glm::vec3 &position);
     void setHeading(float heading);
 
+    /**
+     * Sets the grid that must be updated when this object moves.
+     */
+    void setSpatialGrid(SpatialGrid<SpatialObject> *grid);
+
     std::shared_ptr<render::ModelInstance> model() const;
     std::shared_ptr<render::Walkmesh> walkmesh() const;
 
@@ -59,14 +72,19 @@ protected:
     glm::vec3 _position { 0.0f };
     float _heading { 0.0f };
     glm::mat4 _transform { 1.0f };
+    glm::mat4 _inverseTransform { 1.0f };
     std::shared_ptr<render::ModelInstance> _model;
     std::shared_ptr<render::Walkmesh> _walkmesh;
     float _drawDistance { kDefaultDrawDistance };
     float _fadeDistance { kDefaultFadeDistance };
+    SpatialGrid<SpatialObject> *_spatialGrid { nullptr };
 
     SpatialObject(uint32_t id);
 
     virtual void updateTransform();
+
+private:
+    render::AnimationLOD getAnimationLOD(const UpdateContext &ctx, float distanceToCamera) const;
 };
 
 } // namespace game
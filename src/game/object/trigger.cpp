@@ -21,14 +21,20 @@
 
 #include "../../resources/resources.h"
 
+#include "../script/util.h"
+
 using namespace std;
 
+using namespace reone::render;
 using namespace reone::resources;
 
 namespace reone {
 
 namespace game {
 
+static const float kTriggerHeight = 2.0f;
+static const float kTriggerDepth = 0.5f;
+
 Trigger::Trigger(uint32_t id) : SpatialObject(id) {
     _type = ObjectType::Trigger;
 }
@@ -60,10 +66,74 @@ void Trigger::load(const GffStruct &gffs) {
         float y = child.getFloat("PointY");
         float z = child.getFloat("PointZ");
 
-        _geometry.push_back(_transform * glm::vec4(x, y, z, 1.0f));
+        glm::vec3 point(_transform * glm::vec4(x, y, z, 1.0f));
+        _geometry.push_back(point);
+        _geometryBounds.expand(point);
+    }
+
+    string templResRef(gffs.getString("TemplateResRef"));
+    shared_ptr<GffStruct> utt(ResMan.findGFF(templResRef, ResourceType::TriggerBlueprint));
+    if (utt) {
+        loadBlueprint(*utt);
+    }
+
+    // Scripts of the instance take precedence over those of the blueprint
+    loadScripts(gffs);
+}
+
+void Trigger::loadBlueprint(const GffStruct &gffs) {
+    loadScripts(gffs);
+}
+
+void Trigger::loadScripts(const GffStruct &gffs) {
+    string onEnter(gffs.getString("ScriptOnEnter"));
+    if (!onEnter.empty()) {
+        _scripts[ScriptType::OnEnter] = move(onEnter);
+    }
+    string onExit(gffs.getString("ScriptOnExit"));
+    if (!onExit.empty()) {
+        _scripts[ScriptType::OnExit] = move(onExit);
+    }
+}
+
+void Trigger::runOnEnterScript(uint32_t enteredId) {
+    if (!_scripts[ScriptType::OnEnter].empty()) {
+        runScript(_scripts[ScriptType::OnEnter], _id, enteredId, -1);
     }
 }
 
+void Trigger::runOnExitScript(uint32_t exitedId) {
+    if (!_scripts[ScriptType::OnExit].empty()) {
+        runScript(_scripts[ScriptType::OnExit], _id, exitedId, -1);
+    }
+}
+
+bool Trigger::isIn(const glm::vec3 &point) const {
+    // Geometry lies on the floor, so the trigger extends from slightly below
+    // it to the height of a creature above it
+
+    if (point.z < _geometryBounds.min().z - kTriggerDepth ||
+        point.z > _geometryBounds.max().z + kTriggerHeight) return false;
+
+    // Count crossings of a ray cast from point along the X axis
+
+    bool in = false;
+    size_t count = _geometry.size();
+
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        const glm::vec3 &a = _geometry[i];
+        const glm::vec3 &b = _geometry[j];
+        if ((a.y > point.y) == (b.y > point.y)) continue;
+
+        float x = a.x + (point.y - a.y) * (b.x - a.x) / (b.y - a.y);
+        if (point.x < x) {
+            in = !in;
+        }
+    }
+
+    return in;
+}
+
 const string &Trigger::linkedToModule() const {
     return _linkedToModule;
 }
@@ -76,6 +146,10 @@ const vector<glm::vec3> &Trigger::geometry() const {
     return _geometry;
 }
 
+const AABB &Trigger::geometryBounds() const {
+    return _geometryBounds;
+}
+
 } // namespace game
 
 } // namespace reone
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "spatial.h"
 
 #include "../../resources/gfffile.h"
@@ -31,15 +33,35 @@ public:
 
     void load(const resources::GffStruct &gffs);
 
+    void runOnEnterScript(uint32_t enteredId);
+    void runOnExitScript(uint32_t exitedId);
+
+    /**
+     * @return true if point is inside the geometry polygon, projected onto
+     *         the XY plane, and within the height of the trigger above it
+     */
+    bool isIn(const glm::vec3 &point) const;
+
     const std::string &linkedToModule() const;
     const std::string &linkedTo() const;
     const std::vector<glm::vec3> &geometry() const;
+    const render::AABB &geometryBounds() const;
 
 private:
+    enum class ScriptType {
+        OnEnter,
+        OnExit
+    };
+
     std::string _transitionDestin;
     std::string _linkedToModule;
     std::string _linkedTo;
     std::vector<glm::vec3> _geometry;
+    render::AABB _geometryBounds;
+    std::map<ScriptType, std::string> _scripts;
+
+    void loadBlueprint(const resources::GffStruct &gffs);
+    void loadScripts(const resources::GffStruct &gffs);
 };
 
 } // namespace game
@@ -0,0 +1,218 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pathservice.h"
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+
+#include "glm/gtx/norm.hpp"
+
+#include "../core/jobs.h"
+#include "../core/log.h"
+#include "../core/profiler.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace game {
+
+static const int kMaxPathSolvesPerFrame = 4;
+static const float kCoalesceDistance = 2.0f;
+static const float kSameDestinationDistance = 0.1f;
+
+PathService::PathService(const NavMesh &navMesh) : _navMesh(navMesh) {
+}
+
+PathService::~PathService() {
+    _cancel = true;
+
+    unique_lock<mutex> lock(_mutex);
+    _solvesDone.wait(lock, [this]() { return _solvesActive == 0; });
+}
+
+void PathService::request(uint32_t objectId, const glm::vec3 &from, const glm::vec3 &to) {
+    ObjectRequests &requests = _requests[objectId];
+    if (requests.latestSerial != 0 &&
+        glm::distance2(requests.dest, to) <= kSameDestinationDistance * kSameDestinationDistance) return;
+
+    Request request;
+    request.objectId = objectId;
+    request.serial = _nextSerial++;
+    request.from = from;
+    request.to = to;
+
+    // Paths of cancelled requests may still be in flight and must not be
+    // delivered to a new request
+    if (requests.latestSerial == 0) {
+        requests.deliveredSerial = request.serial;
+    }
+    requests.latestSerial = request.serial;
+    requests.dest = to;
+
+    auto maybePending = find_if(_pending.begin(), _pending.end(), [&objectId](const Request &pending) {
+        return pending.objectId == objectId;
+    });
+    if (maybePending != _pending.end()) {
+        *maybePending = request;
+    } else {
+        _pending.push_back(request);
+    }
+}
+
+void PathService::cancel(uint32_t objectId) {
+    auto maybeRequests = _requests.find(objectId);
+    if (maybeRequests == _requests.end()) return;
+
+    _requests.erase(maybeRequests);
+
+    auto pendingEnd = remove_if(_pending.begin(), _pending.end(), [&objectId](const Request &pending) {
+        return pending.objectId == objectId;
+    });
+    _pending.erase(pendingEnd, _pending.end());
+}
+
+void PathService::update(const CompletionHandler &handler) {
+    PROFILE_SCOPE("PathService::update");
+
+    vector<Result> completed;
+    {
+        lock_guard<mutex> lock(_mutex);
+        swap(completed, _completed);
+    }
+    for (auto &result : completed) {
+        auto maybeRequests = _requests.find(result.objectId);
+        if (maybeRequests == _requests.end() || maybeRequests->second.deliveredSerial > result.serial) continue;
+
+        // A cancelled solve never yields a path, so the latest request must
+        // not keep blocking new requests to the same destination
+        if (result.cancelled) {
+            if (maybeRequests->second.latestSerial == result.serial) {
+                _requests.erase(maybeRequests);
+            }
+            continue;
+        }
+
+        // Paths of earlier requests are still delivered, so that an object,
+        // whose destination keeps changing, is not left without a path
+        if (maybeRequests->second.latestSerial == result.serial) {
+            _requests.erase(maybeRequests);
+        } else {
+            maybeRequests->second.deliveredSerial = result.serial;
+        }
+        handler(result.objectId, result.dest, move(result.points));
+    }
+
+    // Group pending requests, oldest first, with requests that start and
+    // end near them
+
+    int solveCount = 0;
+    vector<bool> grouped(_pending.size(), false);
+
+    for (size_t i = 0; i < _pending.size() && solveCount < kMaxPathSolvesPerFrame; ++i) {
+        if (grouped[i]) continue;
+
+        const Request &leader = _pending[i];
+        vector<Request> group { leader };
+        grouped[i] = true;
+
+        for (size_t j = i + 1; j < _pending.size(); ++j) {
+            if (grouped[j]) continue;
+
+            const Request &request = _pending[j];
+            if (glm::distance2(leader.from, request.from) > kCoalesceDistance * kCoalesceDistance ||
+                glm::distance2(leader.to, request.to) > kCoalesceDistance * kCoalesceDistance) continue;
+
+            group.push_back(request);
+            grouped[j] = true;
+        }
+
+        {
+            lock_guard<mutex> lock(_mutex);
+            ++_solvesActive;
+        }
+        ++solveCount;
+
+        TheJobExecutor.enqueue([this, group](const atomic_bool &cancel) {
+            solve(group, cancel);
+
+            lock_guard<mutex> lock(_mutex);
+            if (--_solvesActive == 0) {
+                _solvesDone.notify_all();
+            }
+        });
+    }
+
+    vector<Request> pending;
+    for (size_t i = 0; i < _pending.size(); ++i) {
+        if (!grouped[i]) {
+            pending.push_back(_pending[i]);
+        }
+    }
+    swap(pending, _pending);
+}
+
+void PathService::solve(const vector<Request> &group, const atomic_bool &cancel) {
+    if (cancel.load() || _cancel.load()) {
+        lock_guard<mutex> lock(_mutex);
+
+        for (auto &request : group) {
+            Result result;
+            result.objectId = request.objectId;
+            result.serial = request.serial;
+            result.dest = request.to;
+            result.cancelled = true;
+
+            _completed.push_back(move(result));
+        }
+        return;
+    }
+
+    const Request &leader = group.front();
+    int expandedNodeCount = 0;
+    vector<glm::vec3> points(_navMesh.findPath(leader.from, leader.to, &expandedNodeCount));
+
+#ifdef DEBUG_PATH
+    vector<string> pointsStr;
+    pointsStr.reserve(points.size());
+
+    for (auto &point : points) {
+        pointsStr.push_back(str(boost::format("%.0f %.0f") % point.x % point.y));
+    }
+
+    debug(boost::format("Path: %d requests, %d nodes expanded: %s") % group.size() % expandedNodeCount % boost::join(pointsStr, " | "));
+#endif
+
+    lock_guard<mutex> lock(_mutex);
+
+    for (auto &request : group) {
+        Result result;
+        result.objectId = request.objectId;
+        result.serial = request.serial;
+        result.dest = request.to;
+        result.points = points;
+
+        _completed.push_back(move(result));
+    }
+}
+
+} // namespace game
+
+} // namespace reone
@@ -0,0 +1,121 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+#include "navmesh.h"
+
+namespace reone {
+
+namespace game {
+
+/**
+ * Solves path requests of objects on worker threads. Requests carry copies
+ * of start and goal positions, and paths are delivered on the main thread,
+ * so that workers never access objects.
+ *
+ * Requests with nearby starts and goals are solved once. At most
+ * kMaxPathSolvesPerFrame solves are dispatched per update.
+ *
+ * Paths are delivered in request order: a path is dropped if the path of a
+ * later request of the same object was already delivered.
+ */
+class PathService {
+public:
+    typedef std::function<void(uint32_t objectId, const glm::vec3 &dest, std::vector<glm::vec3> &&points)> CompletionHandler;
+
+    PathService(const NavMesh &navMesh);
+
+    /**
+     * Discards pending requests and waits for solves in progress.
+     */
+    ~PathService();
+
+    /**
+     * Requests a path for the object, replacing its previous request, unless
+     * that request is still outstanding and has nearly the same destination.
+     */
+    void request(uint32_t objectId, const glm::vec3 &from, const glm::vec3 &to);
+
+    /**
+     * Discards requests of the object, e.g. when it stops moving or is
+     * removed. Paths of discarded requests are never delivered.
+     */
+    void cancel(uint32_t objectId);
+
+    /**
+     * Delivers completed paths to the handler and dispatches pending
+     * requests. Must be called from the main thread.
+     */
+    void update(const CompletionHandler &handler);
+
+private:
+    struct Request {
+        uint32_t objectId { 0 };
+        uint32_t serial { 0 };
+        glm::vec3 from { 0.0f };
+        glm::vec3 to { 0.0f };
+    };
+
+    struct ObjectRequests {
+        uint32_t latestSerial { 0 }; /**< serial of the latest request */
+        uint32_t deliveredSerial { 0 }; /**< paths of earlier requests are dropped */
+        glm::vec3 dest { 0.0f }; /**< destination of the latest request */
+    };
+
+    struct Result {
+        uint32_t objectId { 0 };
+        uint32_t serial { 0 };
+        glm::vec3 dest { 0.0f };
+        std::vector<glm::vec3> points;
+        bool cancelled { false }; /**< solve was cancelled, points are empty */
+    };
+
+    const NavMesh &_navMesh;
+
+    // Main thread only
+
+    uint32_t _nextSerial { 1 };
+    std::map<uint32_t, ObjectRequests> _requests; /**< outstanding requests by object */
+    std::vector<Request> _pending;
+
+    // Shared with workers
+
+    std::mutex _mutex;
+    std::vector<Result> _completed;
+    std::condition_variable _solvesDone;
+    int _solvesActive { 0 }; /**< guarded by _mutex */
+    std::atomic_bool _cancel { false };
+
+    PathService(const PathService &) = delete;
+    PathService &operator=(const PathService &) = delete;
+
+    void solve(const std::vector<Request> &group, const std::atomic_bool &cancel);
+};
+
+} // namespace game
+
+} // namespace reone
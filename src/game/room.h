@@ -47,6 +47,14 @@ private:
     std::shared_ptr<render::Walkmesh> _walkmesh;
 };
 
+/**
+ * Walkable face of a room walkmesh that an object stands on.
+ */
+struct RoomFace {
+    const Room *room { nullptr };
+    int face { -1 };
+};
+
 } // namespace game
 
 } // namespace reone
@@ -0,0 +1,181 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/common.hpp"
+#include "glm/vec2.hpp"
+
+#include "../render/aabb.h"
+
+namespace reone {
+
+namespace game {
+
+/**
+ * Uniform grid over the XY plane, mapping cells to items whose bounds overlap
+ * them. Cells are allocated on demand, so the grid has no fixed extent.
+ *
+ * Queries do not modify the grid and may run concurrently with each other.
+ */
+template <class T>
+class SpatialGrid {
+public:
+    SpatialGrid(float cellSize) : _cellSize(cellSize) {
+    }
+
+    void add(T *item, const render::AABB &bounds) {
+        Entry &entry = _entries[item];
+        entry.item = item;
+        entry.min = bounds.min();
+        entry.max = bounds.max();
+        getCellRange(entry.min, entry.max, entry.cellMin, entry.cellMax);
+
+        insertIntoCells(entry);
+    }
+
+    /**
+     * Updates bounds of the item, adding it if necessary.
+     */
+    void update(T *item, const render::AABB &bounds) {
+        auto maybeEntry = _entries.find(item);
+        if (maybeEntry == _entries.end()) {
+            add(item, bounds);
+            return;
+        }
+        Entry &entry = maybeEntry->second;
+        entry.min = bounds.min();
+        entry.max = bounds.max();
+
+        glm::ivec2 cellMin, cellMax;
+        getCellRange(entry.min, entry.max, cellMin, cellMax);
+        if (cellMin == entry.cellMin && cellMax == entry.cellMax) return;
+
+        removeFromCells(entry);
+        entry.cellMin = cellMin;
+        entry.cellMax = cellMax;
+        insertIntoCells(entry);
+    }
+
+    void remove(T *item) {
+        auto maybeEntry = _entries.find(item);
+        if (maybeEntry == _entries.end()) return;
+
+        removeFromCells(maybeEntry->second);
+        _entries.erase(maybeEntry);
+    }
+
+    void clear() {
+        _cells.clear();
+        _entries.clear();
+    }
+
+    /**
+     * Calls fn once for every item whose bounds overlap the box in the XY
+     * plane, until fn returns true.
+     *
+     * @return true if fn returned true, false otherwise
+     */
+    template <class Fn>
+    bool query(const glm::vec3 &min, const glm::vec3 &max, Fn fn) const {
+        glm::ivec2 cellMin, cellMax;
+        getCellRange(min, max, cellMin, cellMax);
+
+        for (int y = cellMin.y; y <= cellMax.y; ++y) {
+            for (int x = cellMin.x; x <= cellMax.x; ++x) {
+                auto maybeCell = _cells.find(getCellKey(x, y));
+                if (maybeCell == _cells.end()) continue;
+
+                for (const Entry *entry : maybeCell->second) {
+                    // An item overlapping several cells of the box is only
+                    // reported from the first of them
+
+                    if (x != glm::max(cellMin.x, entry->cellMin.x) ||
+                        y != glm::max(cellMin.y, entry->cellMin.y)) continue;
+
+                    if (entry->max.x < min.x || entry->min.x > max.x ||
+                        entry->max.y < min.y || entry->min.y > max.y) continue;
+
+                    if (fn(entry->item)) return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Entry {
+        T *item { nullptr };
+        glm::vec3 min { 0.0f };
+        glm::vec3 max { 0.0f };
+        glm::ivec2 cellMin { 0 };
+        glm::ivec2 cellMax { 0 };
+    };
+
+    float _cellSize { 1.0f };
+    std::unordered_map<uint64_t, std::vector<Entry *>> _cells;
+    std::unordered_map<T *, Entry> _entries;
+
+    SpatialGrid(const SpatialGrid &) = delete;
+    SpatialGrid &operator=(const SpatialGrid &) = delete;
+
+    void getCellRange(const glm::vec3 &min, const glm::vec3 &max, glm::ivec2 &cellMin, glm::ivec2 &cellMax) const {
+        cellMin = glm::ivec2(glm::floor(glm::vec2(min) / _cellSize));
+        cellMax = glm::ivec2(glm::floor(glm::vec2(max) / _cellSize));
+    }
+
+    uint64_t getCellKey(int x, int y) const {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    void insertIntoCells(Entry &entry) {
+        for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+            for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+                _cells[getCellKey(x, y)].push_back(&entry);
+            }
+        }
+    }
+
+    void removeFromCells(Entry &entry) {
+        for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+            for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+                auto maybeCell = _cells.find(getCellKey(x, y));
+                if (maybeCell == _cells.end()) continue;
+
+                std::vector<Entry *> &cell = maybeCell->second;
+                auto it = std::find(cell.begin(), cell.end(), &entry);
+                if (it != cell.end()) {
+                    *it = cell.back();
+                    cell.pop_back();
+                }
+                if (cell.empty()) {
+                    _cells.erase(maybeCell);
+                }
+            }
+        }
+    }
+};
+
+} // namespace game
+
+} // namespace reone
@@ -26,6 +26,7 @@
 #include "glm/mat4x4.hpp"
 
 #include "../audio/types.h"
+#include "../core/types.h"
 #include "../net/types.h"
 #include "../render/texture.h"
 #include "../render/types.h"
@@ -118,13 +119,23 @@ enum InventorySlot {
 enum class DebugMode {
     None,
     GameObjects,
-    ModelNodes
+    ModelNodes,
+    Profiler
+};
+
+struct BenchmarkOptions {
+    bool enabled { false }; /**< run the rendering benchmark instead of the game */
+    std::string module; /**< module to load, or empty for the game's first module */
+    int frameCount { 0 };
 };
 
 struct Options {
     render::GraphicsOptions graphics;
     audio::AudioOptions audio;
     net::NetworkOptions network;
+    BenchmarkOptions benchmark;
+    ProfilerOptions profiler;
+    bool bakeNavMesh { false }; /**< compute and cache nav meshes of all modules instead of running the game */
     uint32_t debug { 0 };
 };
 
@@ -147,6 +158,15 @@ struct UpdateContext {
     glm::vec3 cameraPosition { 0.0f };
     glm::mat4 projection { 1.0f };
     glm::mat4 view { 1.0f };
+    render::AnimationLODOptions animLod;
+};
+
+/**
+ * CPU time spent on render lists during the last area update, in seconds.
+ */
+struct RenderListTimes {
+    float fill { 0.0f };
+    float sort { 0.0f };
 };
 
 struct CreatureState {
@@ -184,6 +204,7 @@ struct DebugObject {
 
 struct DebugContext {
     std::vector<DebugObject> objects;
+    std::vector<std::string> stats;
 };
 
 struct GuiContext {
@@ -21,13 +21,8 @@
 
 #include "glm/ext.hpp"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
 #include "../../core/log.h"
-#include "../../render/mesh/guiquad.h"
-#include "../../render/shaders.h"
+#include "../../render/guibatch.h"
 #include "../../resources/resources.h"
 
 #include "button.h"
@@ -46,6 +41,8 @@ namespace reone {
 
 namespace gui {
 
+static const size_t kMaxTextLayouts = 64;
+
 unique_ptr<Control> Control::makeControl(const GffStruct &gffs) {
     ControlType controlType = static_cast<ControlType>(gffs.getInt("CONTROLTYPE"));
     unique_ptr<Control> control;
@@ -225,11 +222,6 @@ void Control::initGL() {
 void Control::render(const glm::ivec2 &offset, const string &textOverride) const {
     if (!_visible) return;
 
-    ShaderManager &shaders = ShaderMan;
-    shaders.activate(ShaderProgram::BasicDiffuse);
-    shaders.setUniform("color", glm::vec3(1.0f));
-    shaders.setUniform("alpha", 1.0f);
-
     if (_focus && _hilight) {
         drawBorder(*_hilight, offset);
     } else if (_border) {
@@ -243,46 +235,24 @@ void Control::render(const glm::ivec2 &offset, const string &textOverride) const
 }
 
 void Control::drawBorder(const Border &border, const glm::ivec2 &offset) const {
-    ShaderManager &shaders = ShaderManager::instance();
-    GUIQuad &quad = GUIQuad::instance();
-
-    glActiveTexture(0);
+    GUIBatch &batch = GUIBatch::instance();
 
     if (border.fill) {
         int x = _extent.left + border.dimension + offset.x;
         int y = _extent.top + border.dimension + offset.y;
         int w = _extent.width - 2 * border.dimension;
         int h = _extent.height - 2 * border.dimension;
+
         glm::mat4 transform(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)));
         transform = glm::scale(transform, glm::vec3(w, h, 1.0f));
 
-        shaders.setUniform("model", transform);
-        border.fill->bind();
-
-        GLint blendSrcRgb, blendSrcAlpha, blendDstRgb, blendDstAlpha;
-        bool additive = border.fill->isAdditive();
-        if (additive) {
-            glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb);
-            glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
-            glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb);
-            glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
-            glBlendFunc(GL_ONE, GL_ONE);
-        }
-
-        quad.render(GL_TRIANGLES);
-
-        if (additive) {
-            glBlendFuncSeparate(blendSrcRgb, blendDstRgb, blendSrcAlpha, blendDstAlpha);
-        }
-
-        border.fill->unbind();
+        batch.addQuad(border.fill, transform, glm::vec3(1.0f), border.fill->isAdditive());
     }
     if (border.edge) {
         int verticalHeight = _extent.height - 2 * border.dimension;
         int horizonalWidth = _extent.width - 2 * border.dimension;
+
         glm::mat4 edgeTransform(1.0f);
-        shaders.setUniform("color", border.color);
-        border.edge->bind();
 
         if (verticalHeight > 0.0f) {
             int x = _extent.left + offset.x;
@@ -293,15 +263,13 @@ void Control::drawBorder(const Border &border, const glm::ivec2 &offset) const {
             edgeTransform = glm::scale(edgeTransform, glm::vec3(border.dimension, verticalHeight, 1.0f));
             edgeTransform = glm::rotate(edgeTransform, glm::half_pi<float>(), glm::vec3(0.0f, 0.0f, 1.0f));
             edgeTransform = glm::rotate(edgeTransform, glm::pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
-            shaders.setUniform("model", edgeTransform);
-            quad.render(GL_TRIANGLES);
+            batch.addQuad(border.edge, edgeTransform, border.color);
 
             // Right edge
             edgeTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x + _extent.width, y, 0.0f));
             edgeTransform = glm::scale(edgeTransform, glm::vec3(border.dimension, verticalHeight, 1.0f));
             edgeTransform = glm::rotate(edgeTransform, glm::half_pi<float>(), glm::vec3(0.0f, 0.0f, 1.0f));
-            shaders.setUniform("model", edgeTransform);
-            quad.render(GL_TRIANGLES);
+            batch.addQuad(border.edge, edgeTransform, border.color);
         }
 
         if (horizonalWidth > 0.0f) {
@@ -311,59 +279,48 @@ void Control::drawBorder(const Border &border, const glm::ivec2 &offset) const {
             // Top edge
             edgeTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
             edgeTransform = glm::scale(edgeTransform, glm::vec3(horizonalWidth, border.dimension, 1.0f));
-            shaders.setUniform("model", edgeTransform);
-            quad.render(GL_TRIANGLES);
+            batch.addQuad(border.edge, edgeTransform, border.color);
 
             // Bottom edge
             edgeTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x, y + _extent.height, 0.0f));
             edgeTransform = glm::scale(edgeTransform, glm::vec3(horizonalWidth, border.dimension, 1.0f));
             edgeTransform = glm::rotate(edgeTransform, glm::pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
-            shaders.setUniform("model", edgeTransform);
-            quad.render(GL_TRIANGLES);
+            batch.addQuad(border.edge, edgeTransform, border.color);
         }
-
-        border.edge->unbind();
     }
     if (border.corner) {
         int x = _extent.left + offset.x;
         int y = _extent.top + offset.y;
+
         glm::mat4 cornerTransform(1.0f);
-        border.corner->bind();
 
         // Top left corner
         cornerTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
         cornerTransform = glm::scale(cornerTransform, glm::vec3(border.dimension, border.dimension, 1.0f));
-        shaders.setUniform("model", cornerTransform);
-        quad.render(GL_TRIANGLES);
+        batch.addQuad(border.corner, cornerTransform, border.color);
 
         // Bottom left corner
         cornerTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x, y + _extent.height, 0.0f));
         cornerTransform = glm::scale(cornerTransform, glm::vec3(border.dimension, border.dimension, 1.0f));
         cornerTransform = glm::rotate(cornerTransform, glm::pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
-        shaders.setUniform("model", cornerTransform);
-        quad.render(GL_TRIANGLES);
+        batch.addQuad(border.corner, cornerTransform, border.color);
 
         // Top right corner
         cornerTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x + _extent.width, y, 0.0f));
         cornerTransform = glm::scale(cornerTransform, glm::vec3(border.dimension, border.dimension, 1.0f));
         cornerTransform = glm::rotate(cornerTransform, glm::half_pi<float>(), glm::vec3(0.0f, 0.0f, 1.0f));
-        shaders.setUniform("model", cornerTransform);
-        quad.render(GL_TRIANGLES);
+        batch.addQuad(border.corner, cornerTransform, border.color);
 
         // Bottom right corner
         cornerTransform = glm::translate(glm::mat4(1.0f), glm::vec3(x + _extent.width, y + _extent.height, 0.0f));
         cornerTransform = glm::scale(cornerTransform, glm::vec3(border.dimension, border.dimension, 1.0f));
         cornerTransform = glm::rotate(cornerTransform, glm::pi<float>(), glm::vec3(0.0f, 0.0f, 1.0f));
-        shaders.setUniform("model", cornerTransform);
-        quad.render(GL_TRIANGLES);
-
-        border.corner->unbind();
+        batch.addQuad(border.corner, cornerTransform, border.color);
     }
 }
 
 void Control::drawText(const string &text, const glm::ivec2 &offset) const {
-    float textWidth = _text.font->measure(text);
-    int lineCount = static_cast<int>(glm::ceil(textWidth / static_cast<float>(_extent.width)));
+    const TextLayout &layout = getTextLayout(text);
 
     TextGravity gravity;
     switch (_text.align) {
@@ -375,24 +332,39 @@ void Control::drawText(const string &text, const glm::ivec2 &offset) const {
             break;
     }
 
-    glm::ivec2 position;
+    glm::ivec2 position(layout.position);
     glm::vec3 color((_focus && _hilight) ? _hilight->color : _text.color);
 
-    if (lineCount == 1) {
-        getTextPosition(position, 1);
+    for (auto &line : layout.lines) {
         glm::mat4 transform(glm::translate(glm::mat4(1.0f), glm::vec3(position.x + offset.x, position.y + offset.y, 0.0f)));
-        _text.font->render(text, transform, color, gravity);
+        position.y += static_cast<int>(_text.font->height());
+        _text.font->render(line, transform, color, gravity);
+    }
+}
 
-    } else {
-        vector<string> lines(breakText(text, _extent.width));
-        getTextPosition(position, static_cast<int>(lines.size()));
+const Control::TextLayout &Control::getTextLayout(const string &text) const {
+    auto maybeLayout = _textLayouts.find(text);
+    if (maybeLayout != _textLayouts.end()) return maybeLayout->second;
 
-        for (auto &line : lines) {
-            glm::mat4 transform(glm::translate(glm::mat4(1.0f), glm::vec3(position.x + offset.x, position.y + offset.y, 0.0f)));
-            position.y += static_cast<int>(_text.font->height());
-            _text.font->render(line, transform, color, gravity);
-        }
+    if (_textLayouts.size() >= kMaxTextLayouts) {
+        _textLayouts.clear();
+    }
+
+    TextLayout layout;
+
+    float textWidth = _text.font->measure(text);
+    int lineCount = static_cast<int>(glm::ceil(textWidth / static_cast<float>(_extent.width)));
+
+    if (lineCount == 1) {
+        layout.lines.push_back(text);
+    } else {
+        layout.lines = breakText(text, _extent.width);
     }
+    getTextPosition(layout.position, static_cast<int>(layout.lines.size()));
+
+    auto pair = _textLayouts.insert(make_pair(text, move(layout)));
+
+    return pair.first->second;
 }
 
 vector<string> Control::breakText(const string &text, int maxWidth) const {
@@ -452,41 +424,81 @@ void Control::render3D(const glm::ivec2 &offset) const {
     model->render(transform);
 }
 
+void Control::collectTextures(vector<shared_ptr<Texture>> &textures) const {
+    for (auto &border : { _border, _hilight }) {
+        if (!border) continue;
+
+        textures.push_back(border->corner);
+        textures.push_back(border->edge);
+        textures.push_back(border->fill);
+    }
+    if (_text.font) {
+        textures.push_back(_text.font->texture());
+    }
+}
+
 void Control::stretch(float x, float y) {
     _extent.left = static_cast<int>(_extent.left * x);
     _extent.top = static_cast<int>(_extent.top * y);
     _extent.width = static_cast<int>(_extent.width * x);
     _extent.height = static_cast<int>(_extent.height * y);
     updateTransform();
+
+    _textLayouts.clear();
+    _dirty = true;
+}
+
+bool Control::isDirty() const {
+    return _dirty;
+}
+
+void Control::setDirty(bool dirty) {
+    _dirty = dirty;
 }
 
 void Control::setVisible(bool visible) {
+    if (_visible == visible) return;
+
     _visible = visible;
+    _dirty = true;
 }
 
 void Control::setFocus(bool focus) {
+    if (_focus == focus) return;
+
     _focus = focus;
+    _dirty = true;
 }
 
 void Control::setExtent(const Extent &extent) {
     _extent = extent;
     updateTransform();
+
+    _textLayouts.clear();
+    _dirty = true;
 }
 
 void Control::setBorder(const Border &border) {
     _border = make_shared<Border>(border);
+    _dirty = true;
 }
 
 void Control::setHilight(const Border &hilight) {
     _hilight = make_shared<Border>(hilight);
+    _dirty = true;
 }
 
 void Control::setText(const Text &text) {
     _text = text;
+    _textLayouts.clear();
+    _dirty = true;
 }
 
 void Control::setTextMessage(const string &text) {
+    if (_text.text == text) return;
+
     _text.text = text;
+    _dirty = true;
 }
 
 void Control::setScene3D(const Scene3D &scene) {
@@ -19,6 +19,9 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -94,6 +97,17 @@ public:
     virtual void update(float dt);
     virtual void stretch(float x, float y);
 
+    /**
+     * Appends textures, used to draw this control, to the specified vector.
+     */
+    virtual void collectTextures(std::vector<std::shared_ptr<render::Texture>> &textures) const;
+
+    /**
+     * @return true if appearance of this control has changed since it was last drawn
+     */
+    bool isDirty() const;
+
+    void setDirty(bool dirty);
     void setVisible(bool visible);
     virtual void setFocus(bool focus);
     virtual void setExtent(const Extent &extent);
@@ -126,6 +140,7 @@ protected:
     glm::mat4 _transform { 1.0f };
     bool _visible { true };
     bool _focus { false };
+    bool _dirty { true };
     std::function<void(const std::string &)> _onClick;
     std::function<void(const std::string &, const std::string &)> _onItemClicked;
 
@@ -136,6 +151,21 @@ protected:
     void drawText(const std::string &text, const glm::ivec2 &offset) const;
 
 private:
+    /**
+     * Text broken into lines, positioned relative to the control extent.
+     */
+    struct TextLayout {
+        std::vector<std::string> lines;
+        glm::ivec2 position { 0 };
+    };
+
+    /**
+     * Layouts of recently drawn strings, invalidated when the extent or the
+     * font changes. Keyed by string, as list boxes draw many strings using
+     * the same prototype control.
+     */
+    mutable std::unordered_map<std::string, TextLayout> _textLayouts;
+
     Control(const Control &) = delete;
     Control &operator=(const Control &) = delete;
 
@@ -146,6 +176,8 @@ private:
     void loadHilight(const resources::GffStruct &gffs);
     std::vector<std::string> breakText(const std::string &text, int maxWidth) const;
     void getTextPosition(glm::ivec2 &position, int lineCount) const;
+
+    const TextLayout &getTextLayout(const std::string &text) const;
 };
 
 } // namespace gui
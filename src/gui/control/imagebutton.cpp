@@ -17,9 +17,7 @@
 
 #include "imagebutton.h"
 
-#include "GL/glew.h"
-
-#include "../../render/mesh/guiquad.h"
+#include "../../render/guibatch.h"
 
 using namespace std;
 
@@ -36,14 +34,14 @@ void ImageButton::initGL() {
     if (_iconFrame) _iconFrame->initGL();
 }
 
+void ImageButton::collectTextures(vector<shared_ptr<Texture>> &textures) const {
+    Control::collectTextures(textures);
+    textures.push_back(_iconFrame);
+}
+
 void ImageButton::render(const glm::ivec2 &offset, const string &textOverride, const shared_ptr<Texture> &icon) const {
     if (!_visible) return;
 
-    ShaderManager &shaders = ShaderMan;
-    shaders.activate(ShaderProgram::BasicDiffuse);
-    shaders.setUniform("color", glm::vec3(1.0f));
-    shaders.setUniform("alpha", 1.0f);
-
     if (_focus && _hilight) {
         drawBorder(*_hilight, offset);
     } else if (_border) {
@@ -65,24 +63,13 @@ void ImageButton::drawIcon(const glm::ivec2 &offset, const shared_ptr<Texture> &
     transform = glm::translate(transform, glm::vec3(offset.x + _extent.left, offset.y + _extent.top, 0.0f));
     transform = glm::scale(transform, glm::vec3(_extent.height, _extent.height, 1.0f));
 
-    ShaderMan.setUniform("model", transform);
-    glActiveTexture(0);
-
-    if (_iconFrame) {
-        _iconFrame->bind();
-        TheGUIQuad.render(GL_TRIANGLES);
-        _iconFrame->unbind();
-    }
-
-    if (icon) {
-        icon->bind();
-        TheGUIQuad.render(GL_TRIANGLES);
-        icon->unbind();
-    }
+    if (_iconFrame) TheGUIBatch.addQuad(_iconFrame, transform);
+    if (icon) TheGUIBatch.addQuad(icon, transform);
 }
 
 void ImageButton::setIconFrame(const shared_ptr<Texture> &texture) {
     _iconFrame = texture;
+    _dirty = true;
 }
 
 } // namespace gui
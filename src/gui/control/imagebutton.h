@@ -28,6 +28,7 @@ public:
     ImageButton();
 
     void initGL() override;
+    void collectTextures(std::vector<std::shared_ptr<render::Texture>> &textures) const override;
     void render(const glm::ivec2 &offset, const std::string &textOverride, const std::shared_ptr<render::Texture> &icon) const;
 
     void setIconFrame(const std::shared_ptr<render::Texture> &texture);
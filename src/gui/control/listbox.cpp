@@ -17,11 +17,8 @@
 
 #include "listbox.h"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
 #include "../../core/log.h"
+#include "../../render/glapi.h"
 #include "../../render/mesh/guiquad.h"
 #include "../../render/shaders.h"
 #include "../../resources/resources.h"
@@ -60,11 +57,13 @@ void ListBox::updateItems() {
 void ListBox::clearItems() {
     _items.clear();
     _itemOffset = 0;
+    _dirty = true;
     updateItems();
 }
 
 void ListBox::add(const Item &item) {
     _items.push_back(item);
+    _dirty = true;
     updateItems();
 }
 
@@ -84,7 +83,12 @@ void ListBox::load(const GffStruct &gffs) {
 }
 
 bool ListBox::handleMouseMotion(int x, int y) {
-    _hilightedIndex = getItemIndex(y);
+    int itemIdx = getItemIndex(y);
+    if (_hilightedIndex != itemIdx) {
+        _hilightedIndex = itemIdx;
+        _dirty = true;
+    }
+
     return false;
 }
 
@@ -99,10 +103,16 @@ int ListBox::getItemIndex(int y) const {
 
 bool ListBox::handleMouseWheel(int x, int y) {
     if (y < 0) {
-        if (_items.size() - _itemOffset > _slotCount) _itemOffset++;
+        if (_items.size() - _itemOffset > _slotCount) {
+            _itemOffset++;
+            _dirty = true;
+        }
         return true;
     } else if (y > 0) {
-        if (_itemOffset > 0) _itemOffset--;
+        if (_itemOffset > 0) {
+            _itemOffset--;
+            _dirty = true;
+        }
         return true;
     }
 
@@ -128,6 +138,13 @@ void ListBox::initGL() {
     if (_scrollBar) _scrollBar->initGL();
 }
 
+void ListBox::collectTextures(vector<shared_ptr<Texture>> &textures) const {
+    Control::collectTextures(textures);
+
+    if (_protoItem) _protoItem->collectTextures(textures);
+    if (_scrollBar) _scrollBar->collectTextures(textures);
+}
+
 void ListBox::render(const glm::ivec2 &offset, const string &textOverride) const {
     if (!_visible) return;
 
@@ -46,6 +46,7 @@ public:
     bool handleMouseWheel(int x, int y) override;
     bool handleClick(int x, int y) override;
     void initGL() override;
+    void collectTextures(std::vector<std::shared_ptr<render::Texture>> &textures) const override;
     void render(const glm::ivec2 &offset, const std::string &textOverride) const override;
     void stretch(float x, float y) override;
 
@@ -17,12 +17,7 @@
 
 #include "scrollbar.h"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
-#include "../../render/mesh/guiquad.h"
-#include "../../render/shaders.h"
+#include "../../render/guibatch.h"
 #include "../../resources/resources.h"
 
 using namespace std;
@@ -51,29 +46,23 @@ void ScrollBar::initGL() {
     if (_dir.image) _dir.image->initGL();
 }
 
+void ScrollBar::collectTextures(vector<shared_ptr<Texture>> &textures) const {
+    Control::collectTextures(textures);
+    textures.push_back(_dir.image);
+}
+
 void ScrollBar::render(const glm::ivec2 &offset, const string &textOverride) const {
     if (!_dir.image) return;
 
-    ShaderMan.activate(ShaderProgram::BasicDiffuse);
-    ShaderMan.setUniform("color", glm::vec3(1.0f));
-    ShaderMan.setUniform("alpha", 1.0f);
-
-    glActiveTexture(0);
-    _dir.image->bind();
-
     if (_canScrollUp) drawUpArrow(offset);
     if (_canScrollDown) drawDownArrow(offset);
-
-    _dir.image->unbind();
 }
 
 void ScrollBar::drawUpArrow(const glm::vec2 &offset) const {
     glm::mat4 arrowTransform(glm::translate(glm::mat4(1.0f), glm::vec3(_extent.left + offset.x, _extent.top + offset.y, 0.0f)));
     arrowTransform = glm::scale(arrowTransform, glm::vec3(_extent.width, _extent.width, 1.0f));
 
-    ShaderMan.setUniform("model", arrowTransform);
-
-    GUIQuad::instance().render(GL_TRIANGLES);
+    TheGUIBatch.addQuad(_dir.image, arrowTransform);
 }
 
 void ScrollBar::drawDownArrow(const glm::vec2 &offset) const {
@@ -81,9 +70,7 @@ void ScrollBar::drawDownArrow(const glm::vec2 &offset) const {
     arrowTransform = glm::scale(arrowTransform, glm::vec3(_extent.width, _extent.width, 1.0f));
     arrowTransform = glm::rotate(arrowTransform, glm::pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
 
-    ShaderMan.setUniform("model", arrowTransform);
-
-    GUIQuad::instance().render(GL_TRIANGLES);
+    TheGUIBatch.addQuad(_dir.image, arrowTransform);
 }
 
 void ScrollBar::setCanScrollUp(bool scroll) {
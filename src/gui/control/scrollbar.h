@@ -29,6 +29,7 @@ public:
 
     void load(const resources::GffStruct &gffs) override;
     void initGL() override;
+    void collectTextures(std::vector<std::shared_ptr<render::Texture>> &textures) const override;
     void render(const glm::ivec2 &offset, const std::string &textOverride) const override;
 
     void setCanScrollUp(bool scroll);
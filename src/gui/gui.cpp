@@ -17,12 +17,10 @@
 
 #include "gui.h"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
 #include "../core/log.h"
 #include "../resources/resources.h"
+#include "../render/glapi.h"
+#include "../render/guibatch.h"
 #include "../render/mesh/guiquad.h"
 #include "../render/shaders.h"
 
@@ -84,6 +82,23 @@ void GUI::load(const string &resRef, BackgroundType background) {
         control->setOnClick(bind(&GUI::onClick, this, _1));
         _controls.push_back(move(control));
     }
+
+    buildAtlas(resRef);
+}
+
+void GUI::buildAtlas(const string &name) {
+    vector<shared_ptr<Texture>> textures;
+
+    if (_rootControl) _rootControl->collectTextures(textures);
+
+    for (auto &control : _controls) {
+        control->collectTextures(textures);
+    }
+
+    _atlas = make_unique<TextureAtlas>(name);
+    _atlas->build(textures);
+
+    debug(boost::format("GUI: %s: %d atlas pages") % name % _atlas->pageCount());
 }
 
 void GUI::positionRelativeToCenter(Control &control) {
@@ -169,7 +184,7 @@ bool GUI::handleKeyUp(SDL_Scancode key) {
 }
 
 void GUI::updateFocus(int x, int y) {
-    resetFocus();
+    shared_ptr<Control> focus;
 
     for (auto it = _controls.rbegin(); it != _controls.rend(); ++it) {
         shared_ptr<Control> control(*it);
@@ -177,12 +192,19 @@ void GUI::updateFocus(int x, int y) {
 
         const Control::Extent &extent = control->extent();
         if (extent.contains(x, y)) {
-            _focus = control;
-            _focus->setFocus(true);
-            onFocusChanged(_focus->tag(), true);
-            return;
+            focus = control;
+            break;
         }
     }
+    if (focus == _focus) return;
+
+    resetFocus();
+
+    if (focus) {
+        _focus = focus;
+        _focus->setFocus(true);
+        onFocusChanged(_focus->tag(), true);
+    }
 }
 
 void GUI::onFocusChanged(const string &control, bool focus) {
@@ -196,37 +218,94 @@ void GUI::update(float dt) {
 
 void GUI::initGL() {
     if (_background) _background->initGL();
+    if (_atlas) _atlas->initGL();
     if (_rootControl) _rootControl->initGL();
 
     for (auto &control : _controls) {
         control->initGL();
     }
+
+    if (_useRenderCache) {
+        _renderCache = make_unique<Framebuffer>(_gfxOpts.width, _gfxOpts.height);
+        _renderCache->initGL();
+        setDirty(true);
+    }
 }
 
-void GUI::render() const {
+void GUI::render() {
+    if (!_renderCache) {
+        drawControls();
+        return;
+    }
+    if (isDirty()) {
+        _renderCache->bind();
+        _renderCache->clear();
+
+        // Accumulate premultiplied colors, so that the cache can be composited as is
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        drawControls();
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        _renderCache->unbind();
+        setDirty(false);
+    }
+    drawRenderCache();
+}
+
+void GUI::drawControls() const {
+    TheGUIBatch.setAtlas(_atlas.get());
+
     if (_background) drawBackground();
     if (_rootControl) _rootControl->render(_rootOffset);
 
     for (auto &control : _controls) {
         control->render(_controlOffset);
     }
+
+    TheGUIBatch.flush();
+    TheGUIBatch.setAtlas(nullptr);
 }
 
-void GUI::drawBackground() const {
+void GUI::drawRenderCache() const {
     glm::mat4 transform(glm::scale(glm::mat4(1.0f), glm::vec3(_gfxOpts.width, _gfxOpts.height, 1.0f)));
 
-    ShaderManager &shaders = ShaderManager::instance();
+    ShaderManager &shaders = ShaderMan;
     shaders.activate(ShaderProgram::BasicDiffuse);
     shaders.setUniform("model", transform);
     shaders.setUniform("color", glm::vec3(1.0f));
     shaders.setUniform("alpha", 1.0f);
 
-    glActiveTexture(0);
-    _background->bind();
+    glActiveTexture(GL_TEXTURE0);
+    _renderCache->bindColorBuffer();
 
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     TheGUIQuad.render(GL_TRIANGLES);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    _renderCache->unbindColorBuffer();
+}
+
+bool GUI::isDirty() const {
+    if (_rootControl && _rootControl->isDirty()) return true;
+
+    for (auto &control : _controls) {
+        if (control->isDirty()) return true;
+    }
+
+    return false;
+}
+
+void GUI::setDirty(bool dirty) {
+    if (_rootControl) _rootControl->setDirty(dirty);
 
-    _background->unbind();
+    for (auto &control : _controls) {
+        control->setDirty(dirty);
+    }
+}
+
+void GUI::drawBackground() const {
+    glm::mat4 transform(glm::scale(glm::mat4(1.0f), glm::vec3(_gfxOpts.width, _gfxOpts.height, 1.0f)));
+    TheGUIBatch.addQuad(_background, transform);
 }
 
 void GUI::render3D() const {
@@ -23,6 +23,8 @@
 #include "glm/mat4x4.hpp"
 #include "glm/vec2.hpp"
 
+#include "../render/framebuffer.h"
+#include "../render/textureatlas.h"
 #include "../resources/gfffile.h"
 
 #include "control/control.h"
@@ -40,7 +42,7 @@ public:
     void update(float dt);
 
     virtual void initGL();
-    void render() const;
+    void render();
     void render3D() const;
 
     void resetFocus();
@@ -64,6 +66,7 @@ protected:
     std::shared_ptr<Control> _rootControl;
     std::vector<std::shared_ptr<Control>> _controls;
     std::shared_ptr<Control> _focus;
+    bool _useRenderCache { false }; /**< compose controls into an offscreen framebuffer, redrawn only when controls change */
 
     GUI(const render::GraphicsOptions &opts);
 
@@ -85,10 +88,20 @@ private:
     GUI(const GUI &) = delete;
     GUI &operator=(const GUI &) = delete;
 
+    std::unique_ptr<render::Framebuffer> _renderCache;
+    std::unique_ptr<render::TextureAtlas> _atlas;
+
     void positionRelativeToCenter(Control &control);
     void stretchControl(Control &control);
+    void buildAtlas(const std::string &name);
     void updateFocus(int x, int y);
     void drawBackground() const;
+    void drawControls() const;
+    void drawRenderCache() const;
+
+    bool isDirty() const;
+
+    void setDirty(bool dirty);
 };
 
 } // namespace gui
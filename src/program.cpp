@@ -21,6 +21,8 @@
 
 #include <boost/program_options.hpp>
 
+#include "SDL2/SDL.h"
+
 #include "core/log.h"
 #include "core/pathutil.h"
 #include "game/multiplayer/game.h"
@@ -42,6 +44,17 @@ static const int kDefaultMusicVolume = 85;
 static const int kDefaultSoundVolume = 85;
 static const int kDefaultMultiplayerPort = 2003;
 
+static fs::path getDefaultCachePath() {
+    // Per-user writable directory, e.g. ~/.local/share/reone/ on Linux
+    char *prefPath = SDL_GetPrefPath(nullptr, "reone");
+    if (!prefPath) return fs::current_path() / "cache";
+
+    fs::path path(fs::path(prefPath) / "cache");
+    SDL_free(prefPath);
+
+    return move(path);
+}
+
 Program::Program(int argc, char **argv) : _argc(argc), _argv(argv) {
 }
 
@@ -62,6 +75,11 @@ void Program::loadOptions() {
         ("width", po::value<int>()->default_value(800), "window width")
         ("height", po::value<int>()->default_value(600), "window height")
         ("fullscreen", po::value<bool>()->default_value(false), "enable fullscreen")
+        ("animlodnear", po::value<float>()->default_value(16.0f), "distance within which models are animated every frame")
+        ("animlodfar", po::value<float>()->default_value(48.0f), "distance beyond which models are not animated")
+        ("animlodrate", po::value<int>()->default_value(4), "animate models between near and far distance every Nth frame")
+        ("keepmeshdata", po::value<bool>()->default_value(false), "keep mesh data in memory after upload to GPU")
+        ("cachedir", po::value<string>(), "directory to store shader and nav mesh caches in")
         ("musicvol", po::value<int>()->default_value(kDefaultMusicVolume), "music volume in percents")
         ("soundvol", po::value<int>()->default_value(kDefaultSoundVolume), "sound volume in percents")
         ("port", po::value<int>()->default_value(kDefaultMultiplayerPort), "multiplayer port number")
@@ -70,7 +88,15 @@ void Program::loadOptions() {
     _cmdLineOpts.add(_commonOpts).add_options()
         ("help", "print this message")
         ("serve", "start multiplayer game")
-        ("join", po::value<string>()->implicit_value("127.0.0.1"), "join multiplayer game at specified IP address");
+        ("join", po::value<string>()->implicit_value("127.0.0.1"), "join multiplayer game at specified IP address")
+        ("benchmark", "run rendering benchmark")
+        ("headless", "run rendering benchmark without a window and GPU")
+        ("benchmodule", po::value<string>(), "module to load in benchmark mode")
+        ("benchframes", po::value<int>()->default_value(600), "number of frames to run in benchmark mode")
+        ("bakenavmesh", "compute and cache nav meshes of all modules without a window and GPU")
+        ("trace", po::value<string>(), "write Chrome trace of profiled scopes to specified file")
+        ("tracestart", po::value<float>()->default_value(0.0f), "start of the trace window in seconds since startup")
+        ("traceduration", po::value<float>()->default_value(10.0f), "duration of the trace window in seconds");
 
     po::parsed_options parsedCmdLineOpts = po::command_line_parser(_argc, _argv)
         .options(_cmdLineOpts)
@@ -84,14 +110,33 @@ void Program::loadOptions() {
 
     _help = _vars.count("help") > 0;
     _gamePath = _vars.count("game") ? _vars["game"].as<string>() : fs::current_path();
+    setCachePath(_vars.count("cachedir") ? fs::path(_vars["cachedir"].as<string>()) : getDefaultCachePath());
     _gameOpts.graphics.width = _vars["width"].as<int>();
     _gameOpts.graphics.height = _vars["height"].as<int>();
     _gameOpts.graphics.fullscreen = _vars["fullscreen"].as<bool>();
+    _gameOpts.graphics.animLod.nearDistance = _vars["animlodnear"].as<float>();
+    _gameOpts.graphics.animLod.farDistance = _vars["animlodfar"].as<float>();
+    _gameOpts.graphics.animLod.reducedRate = _vars["animlodrate"].as<int>();
+    _gameOpts.graphics.keepMeshData = _vars["keepmeshdata"].as<bool>();
     _gameOpts.audio.musicVolume = _vars["musicvol"].as<int>();
     _gameOpts.audio.soundVolume = _vars["soundvol"].as<int>();
     _gameOpts.network.host = _vars.count("join") ? _vars["join"].as<string>() : "";
     _gameOpts.network.port = _vars["port"].as<int>();
     _gameOpts.debug = _vars["debug"].as<int>();
+    _gameOpts.benchmark.enabled = _vars.count("benchmark") > 0 || _vars.count("headless") > 0;
+    _gameOpts.benchmark.module = _vars.count("benchmodule") ? _vars["benchmodule"].as<string>() : "";
+    _gameOpts.benchmark.frameCount = _vars["benchframes"].as<int>();
+    _gameOpts.profiler.traceFile = _vars.count("trace") ? _vars["trace"].as<string>() : "";
+    _gameOpts.profiler.traceStart = _vars["tracestart"].as<float>();
+    _gameOpts.profiler.traceDuration = _vars["traceduration"].as<float>();
+
+    _gameOpts.bakeNavMesh = _vars.count("bakenavmesh") > 0;
+
+    if (_vars.count("headless") || _gameOpts.bakeNavMesh) {
+        _gameOpts.graphics.headless = true;
+        _gameOpts.audio.musicVolume = 0;
+        _gameOpts.audio.soundVolume = 0;
+    }
 
     setDebugLevel(_gameOpts.debug);
 
@@ -0,0 +1,315 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "backend.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "glapi.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Stub for GL functions that have no observable effect in the null backend.
+ */
+template <class T>
+struct NullFunction;
+
+template <class R, class... Args>
+struct NullFunction<R (GLAPIENTRY *)(Args...)> {
+    static R GLAPIENTRY call(Args...) {
+        return R();
+    }
+};
+
+#define GL_NULL_FUNCTION(fn) fn = &NullFunction<decltype(fn)>::call
+
+// State that the renderer reads back from GL
+
+static GLfloat g_clearColor[4] { 0.0f, 0.0f, 0.0f, 0.0f };
+static GLint g_blendFunc[4] { GL_ONE, GL_ONE, GL_ZERO, GL_ZERO };
+
+// Null backend state. GL functions use the GLAPIENTRY calling convention,
+// which lambdas do not convert to, so stubs are plain functions.
+
+static RenderStats g_stats;
+static GLuint g_nextObjectId = 1;
+
+static void GLAPIENTRY nullGenObjects(GLsizei n, GLuint *ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        ids[i] = g_nextObjectId++;
+    }
+}
+
+static GLuint GLAPIENTRY nullCreateProgram() {
+    return g_nextObjectId++;
+}
+
+static GLuint GLAPIENTRY nullCreateShader(GLenum) {
+    return g_nextObjectId++;
+}
+
+static void GLAPIENTRY nullGetObjectiv(GLuint, GLenum pname, GLint *params) {
+    *params = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+
+static void GLAPIENTRY nullUseProgram(GLuint) {
+    ++g_stats.programChanges;
+}
+
+static void GLAPIENTRY nullUniform1i(GLint, GLint) {
+    ++g_stats.uniformUpdates;
+}
+
+static void GLAPIENTRY nullUniform1f(GLint, GLfloat) {
+    ++g_stats.uniformUpdates;
+}
+
+static void GLAPIENTRY nullUniform3f(GLint, GLfloat, GLfloat, GLfloat) {
+    ++g_stats.uniformUpdates;
+}
+
+static void GLAPIENTRY nullUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat *) {
+    ++g_stats.uniformUpdates;
+}
+
+static void GLAPIENTRY nullBindBuffer(GLenum, GLuint) {
+    ++g_stats.bufferBinds;
+}
+
+static void GLAPIENTRY nullBindVertexArray(GLuint) {
+    ++g_stats.vertexArrayBinds;
+}
+
+static void GLAPIENTRY nullBufferData(GLenum, GLsizeiptr size, const void *, GLenum) {
+    ++g_stats.bufferUploads;
+    g_stats.uploadedBytes += size;
+}
+
+static void GLAPIENTRY nullBufferSubData(GLenum, GLintptr, GLsizeiptr size, const void *) {
+    ++g_stats.bufferUploads;
+    g_stats.uploadedBytes += size;
+}
+
+static void GLAPIENTRY nullBindTexture(GLenum, GLuint) {
+    ++g_stats.textureBinds;
+}
+
+static void GLAPIENTRY nullTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void *) {
+    ++g_stats.textureUploads;
+}
+
+static void GLAPIENTRY nullCompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei size, const void *) {
+    ++g_stats.textureUploads;
+    g_stats.uploadedBytes += size;
+}
+
+static void GLAPIENTRY nullBindFramebuffer(GLenum, GLuint) {
+    ++g_stats.framebufferBinds;
+}
+
+static GLenum GLAPIENTRY nullCheckFramebufferStatus(GLenum) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void GLAPIENTRY nullToggleCapability(GLenum) {
+    ++g_stats.stateChanges;
+}
+
+static void GLAPIENTRY nullBlendFunc(GLenum src, GLenum dst) {
+    g_blendFunc[0] = g_blendFunc[1] = src;
+    g_blendFunc[2] = g_blendFunc[3] = dst;
+    ++g_stats.stateChanges;
+}
+
+static void GLAPIENTRY nullBlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    g_blendFunc[0] = srcRgb;
+    g_blendFunc[1] = srcAlpha;
+    g_blendFunc[2] = dstRgb;
+    g_blendFunc[3] = dstAlpha;
+    ++g_stats.stateChanges;
+}
+
+static void GLAPIENTRY nullClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    g_clearColor[0] = r;
+    g_clearColor[1] = g;
+    g_clearColor[2] = b;
+    g_clearColor[3] = a;
+}
+
+static void GLAPIENTRY nullGetFloatv(GLenum pname, GLfloat *params) {
+    if (pname == GL_COLOR_CLEAR_VALUE) {
+        memcpy(params, g_clearColor, sizeof(g_clearColor));
+    } else {
+        *params = 0.0f;
+    }
+}
+
+static void GLAPIENTRY nullGetIntegerv(GLenum pname, GLint *params) {
+    switch (pname) {
+        case GL_BLEND_SRC_RGB:
+            *params = g_blendFunc[0];
+            break;
+        case GL_BLEND_SRC_ALPHA:
+            *params = g_blendFunc[1];
+            break;
+        case GL_BLEND_DST_RGB:
+            *params = g_blendFunc[2];
+            break;
+        case GL_BLEND_DST_ALPHA:
+            *params = g_blendFunc[3];
+            break;
+        default:
+            *params = 0;
+            break;
+    }
+}
+
+static void GLAPIENTRY nullDrawArrays(GLenum, GLint, GLsizei) {
+    ++g_stats.drawCalls;
+}
+
+static void GLAPIENTRY nullDrawElementsBaseVertex(GLenum, GLsizei, GLenum, const void *, GLint) {
+    ++g_stats.drawCalls;
+}
+
+static void GLAPIENTRY nullDrawElementsInstancedBaseVertex(GLenum, GLsizei, GLenum, const void *, GLsizei, GLint) {
+    ++g_stats.drawCalls;
+}
+
+RenderBackend &RenderBackend::instance() {
+    static RenderBackend instance;
+    return instance;
+}
+
+void RenderBackend::init(RenderBackendType type) {
+    switch (type) {
+        case RenderBackendType::OpenGL:
+            glewInit();
+            break;
+        case RenderBackendType::Null:
+            initNull();
+            break;
+        default:
+            throw invalid_argument("Unsupported render backend type: " + to_string(static_cast<int>(type)));
+    }
+
+    _type = type;
+}
+
+void RenderBackend::initNull() {
+    // Objects
+
+    glGenBuffers = &nullGenObjects;
+    glGenFramebuffers = &nullGenObjects;
+    glGenTextures = &nullGenObjects;
+    glGenVertexArrays = &nullGenObjects;
+    glCreateProgram = &nullCreateProgram;
+    glCreateShader = &nullCreateShader;
+
+    GL_NULL_FUNCTION(glDeleteBuffers);
+    GL_NULL_FUNCTION(glDeleteFramebuffers);
+    GL_NULL_FUNCTION(glDeleteTextures);
+    GL_NULL_FUNCTION(glDeleteVertexArrays);
+    GL_NULL_FUNCTION(glDeleteProgram);
+    GL_NULL_FUNCTION(glDeleteShader);
+
+    // Shaders
+
+    GL_NULL_FUNCTION(glShaderSource);
+    GL_NULL_FUNCTION(glCompileShader);
+    GL_NULL_FUNCTION(glAttachShader);
+    GL_NULL_FUNCTION(glLinkProgram);
+    GL_NULL_FUNCTION(glGetShaderInfoLog);
+    GL_NULL_FUNCTION(glGetProgramInfoLog);
+    GL_NULL_FUNCTION(glGetProgramBinary);
+    GL_NULL_FUNCTION(glProgramBinary);
+    GL_NULL_FUNCTION(glProgramParameteri);
+    glGetShaderiv = &nullGetObjectiv;
+    glGetProgramiv = &nullGetObjectiv;
+    GL_NULL_FUNCTION(glGetUniformLocation);
+
+    glUseProgram = &nullUseProgram;
+    glUniform1i = &nullUniform1i;
+    glUniform1f = &nullUniform1f;
+    glUniform3f = &nullUniform3f;
+    glUniformMatrix4fv = &nullUniformMatrix4fv;
+
+    // Buffers and vertex arrays
+
+    glBindBuffer = &nullBindBuffer;
+    glBindVertexArray = &nullBindVertexArray;
+    glBufferData = &nullBufferData;
+    glBufferSubData = &nullBufferSubData;
+    GL_NULL_FUNCTION(glEnableVertexAttribArray);
+    GL_NULL_FUNCTION(glVertexAttribPointer);
+    GL_NULL_FUNCTION(glVertexAttribDivisor);
+
+    // Textures
+
+    glBindTexture = &nullBindTexture;
+    glTexImage2D = &nullTexImage2D;
+    glCompressedTexImage2D = &nullCompressedTexImage2D;
+    GL_NULL_FUNCTION(glActiveTexture);
+    GL_NULL_FUNCTION(glTexParameteri);
+    GL_NULL_FUNCTION(glTexBuffer);
+    GL_NULL_FUNCTION(glGenerateMipmap);
+
+    // Framebuffers
+
+    glBindFramebuffer = &nullBindFramebuffer;
+    glCheckFramebufferStatus = &nullCheckFramebufferStatus;
+    GL_NULL_FUNCTION(glFramebufferTexture2D);
+
+    // State
+
+    glEnable = &nullToggleCapability;
+    glDisable = &nullToggleCapability;
+    glBlendFunc = &nullBlendFunc;
+    glBlendFuncSeparate = &nullBlendFuncSeparate;
+    glClearColor = &nullClearColor;
+    glGetFloatv = &nullGetFloatv;
+    glGetIntegerv = &nullGetIntegerv;
+    GL_NULL_FUNCTION(glClear);
+
+    // Drawing
+
+    glDrawArrays = &nullDrawArrays;
+    glDrawElementsBaseVertex = &nullDrawElementsBaseVertex;
+    glDrawElementsInstancedBaseVertex = &nullDrawElementsInstancedBaseVertex;
+}
+
+void RenderBackend::resetStats() {
+    g_stats = RenderStats();
+}
+
+RenderBackendType RenderBackend::type() const {
+    return _type;
+}
+
+const RenderStats &RenderBackend::stats() const {
+    return g_stats;
+}
+
+} // namespace render
+
+} // namespace reone
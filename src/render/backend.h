@@ -0,0 +1,87 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace reone {
+
+namespace render {
+
+enum class RenderBackendType {
+    OpenGL,
+    Null
+};
+
+/**
+ * Counters of GL calls issued by the renderer. Only collected by the null
+ * backend.
+ */
+struct RenderStats {
+    int drawCalls { 0 };
+    int programChanges { 0 };
+    int uniformUpdates { 0 };
+    int textureBinds { 0 };
+    int vertexArrayBinds { 0 };
+    int bufferBinds { 0 };
+    int framebufferBinds { 0 };
+    int stateChanges { 0 }; /**< capability toggles and blend function changes */
+    int bufferUploads { 0 };
+    int textureUploads { 0 };
+    size_t uploadedBytes { 0 };
+};
+
+/**
+ * Selects the implementation of the GL API used by the renderer. The OpenGL
+ * backend forwards calls to the driver. The null backend requires no GL
+ * context: it replaces every GL function with a stub that only updates
+ * RenderStats, which allows to measure CPU cost of rendering on machines
+ * without a GPU.
+ *
+ * @see glapi.h
+ */
+class RenderBackend {
+public:
+    static RenderBackend &instance();
+
+    /**
+     * Loads GL functions of the specified backend. Must be called after a GL
+     * context is created, or instead of creating it for the null backend.
+     */
+    void init(RenderBackendType type);
+
+    void resetStats();
+
+    RenderBackendType type() const;
+    const RenderStats &stats() const;
+
+private:
+    RenderBackendType _type { RenderBackendType::OpenGL };
+
+    RenderBackend() = default;
+    RenderBackend(const RenderBackend &) = delete;
+    RenderBackend &operator=(const RenderBackend &) = delete;
+
+    void initNull();
+};
+
+#define TheRenderBackend render::RenderBackend::instance()
+
+} // namespace render
+
+} // namespace reone
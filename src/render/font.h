@@ -18,6 +18,10 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
 
 #include "texture.h"
 
@@ -38,6 +42,11 @@ public:
     void load(const std::shared_ptr<Texture> &texture);
     void initGL();
 
+    /**
+     * Appends glyphs of the text to the GUI batch.
+     *
+     * @see reone::render::GUIBatch
+     */
     void render(
         const std::string &text,
         const glm::mat4 &transform,
@@ -46,18 +55,18 @@ public:
 
     float measure(const std::string &text) const;
     float height() const;
+    std::shared_ptr<Texture> texture() const;
 
 private:
-    bool _glInited { false };
-    std::vector<float> _vertices;
-    std::vector<uint16_t> _indices;
-    int _glyphCount { 0 };
+    struct Glyph {
+        glm::vec2 uvTopLeft { 0.0f };
+        glm::vec2 uvBottomRight { 0.0f };
+        float width { 0.0f };
+    };
+
     float _height { 0.0f };
-    std::vector<float> _glyphWidths;
+    std::vector<Glyph> _glyphs;
     std::shared_ptr<Texture> _texture;
-    uint32_t _vertexBufferId { 0 };
-    uint32_t _indexBufferId { 0 };
-    uint32_t _vertexArrayId { 0 };
 };
 
 } // namespace render
@@ -0,0 +1,109 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "framebuffer.h"
+
+#include <stdexcept>
+
+#include "glapi.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+Framebuffer::Framebuffer(int width, int height) : _width(width), _height(height) {
+}
+
+Framebuffer::~Framebuffer() {
+    deinitGL();
+}
+
+void Framebuffer::initGL() {
+    if (_glInited) return;
+
+    glGenTextures(1, &_colorBufferId);
+    glBindTexture(GL_TEXTURE_2D, _colorBufferId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &_framebufferId);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorBufferId, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        glDeleteFramebuffers(1, &_framebufferId);
+        glDeleteTextures(1, &_colorBufferId);
+        throw runtime_error("Framebuffer: incomplete framebuffer: " + to_string(status));
+    }
+
+    _glInited = true;
+}
+
+void Framebuffer::deinitGL() {
+    if (!_glInited) return;
+
+    glDeleteFramebuffers(1, &_framebufferId);
+    glDeleteTextures(1, &_colorBufferId);
+
+    _glInited = false;
+}
+
+void Framebuffer::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId);
+}
+
+void Framebuffer::unbind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::clear() const {
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void Framebuffer::bindColorBuffer() const {
+    glBindTexture(GL_TEXTURE_2D, _colorBufferId);
+}
+
+void Framebuffer::unbindColorBuffer() const {
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+int Framebuffer::width() const {
+    return _width;
+}
+
+int Framebuffer::height() const {
+    return _height;
+}
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,70 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Offscreen render target with a single RGBA color buffer.
+ */
+class Framebuffer {
+public:
+    Framebuffer(int width, int height);
+    ~Framebuffer();
+
+    void initGL();
+    void deinitGL();
+
+    /**
+     * Redirects rendering into this framebuffer.
+     */
+    void bind() const;
+    void unbind() const;
+
+    /**
+     * Fills the color buffer with transparent black.
+     */
+    void clear() const;
+
+    /**
+     * Binds the color buffer to the active texture unit.
+     */
+    void bindColorBuffer() const;
+    void unbindColorBuffer() const;
+
+    int width() const;
+    int height() const;
+
+private:
+    bool _glInited { false };
+    int _width { 0 };
+    int _height { 0 };
+    uint32_t _framebufferId { 0 };
+    uint32_t _colorBufferId { 0 };
+
+    Framebuffer(const Framebuffer &) = delete;
+    Framebuffer &operator=(const Framebuffer &) = delete;
+};
+
+} // namespace render
+
+} // namespace reone
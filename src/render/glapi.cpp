@@ -0,0 +1,45 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// glapi.h is not included here, because its macros would hide the driver
+// functions that the pointers are initialized with
+
+#include "GL/glew.h"
+
+#include "SDL2/SDL_opengl.h"
+
+namespace reone {
+
+namespace render {
+
+decltype(&::glBindTexture) g_glBindTexture = &::glBindTexture;
+decltype(&::glBlendFunc) g_glBlendFunc = &::glBlendFunc;
+decltype(&::glClear) g_glClear = &::glClear;
+decltype(&::glClearColor) g_glClearColor = &::glClearColor;
+decltype(&::glDeleteTextures) g_glDeleteTextures = &::glDeleteTextures;
+decltype(&::glDisable) g_glDisable = &::glDisable;
+decltype(&::glDrawArrays) g_glDrawArrays = &::glDrawArrays;
+decltype(&::glEnable) g_glEnable = &::glEnable;
+decltype(&::glGenTextures) g_glGenTextures = &::glGenTextures;
+decltype(&::glGetFloatv) g_glGetFloatv = &::glGetFloatv;
+decltype(&::glGetIntegerv) g_glGetIntegerv = &::glGetIntegerv;
+decltype(&::glTexImage2D) g_glTexImage2D = &::glTexImage2D;
+decltype(&::glTexParameteri) g_glTexParameteri = &::glTexParameteri;
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,69 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ * GL API as seen by the renderer. Include this instead of GLEW headers.
+ *
+ * Functions introduced after GL 1.1 are already called through pointers
+ * loaded by GLEW. The remaining core functions are exported by the GL
+ * library directly, so here they are redirected through pointers as well.
+ * This allows RenderBackend to replace the whole API.
+ *
+ * @see reone::render::RenderBackend
+ */
+
+#pragma once
+
+#include "GL/glew.h"
+
+#include "SDL2/SDL_opengl.h"
+
+namespace reone {
+
+namespace render {
+
+extern decltype(&::glBindTexture) g_glBindTexture;
+extern decltype(&::glBlendFunc) g_glBlendFunc;
+extern decltype(&::glClear) g_glClear;
+extern decltype(&::glClearColor) g_glClearColor;
+extern decltype(&::glDeleteTextures) g_glDeleteTextures;
+extern decltype(&::glDisable) g_glDisable;
+extern decltype(&::glDrawArrays) g_glDrawArrays;
+extern decltype(&::glEnable) g_glEnable;
+extern decltype(&::glGenTextures) g_glGenTextures;
+extern decltype(&::glGetFloatv) g_glGetFloatv;
+extern decltype(&::glGetIntegerv) g_glGetIntegerv;
+extern decltype(&::glTexImage2D) g_glTexImage2D;
+extern decltype(&::glTexParameteri) g_glTexParameteri;
+
+} // namespace render
+
+} // namespace reone
+
+#define glBindTexture reone::render::g_glBindTexture
+#define glBlendFunc reone::render::g_glBlendFunc
+#define glClear reone::render::g_glClear
+#define glClearColor reone::render::g_glClearColor
+#define glDeleteTextures reone::render::g_glDeleteTextures
+#define glDisable reone::render::g_glDisable
+#define glDrawArrays reone::render::g_glDrawArrays
+#define glEnable reone::render::g_glEnable
+#define glGenTextures reone::render::g_glGenTextures
+#define glGetFloatv reone::render::g_glGetFloatv
+#define glGetIntegerv reone::render::g_glGetIntegerv
+#define glTexImage2D reone::render::g_glTexImage2D
+#define glTexParameteri reone::render::g_glTexParameteri
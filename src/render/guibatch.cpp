@@ -0,0 +1,265 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "guibatch.h"
+
+#include <cstddef>
+
+#include "mesh/bufferarena.h"
+
+#include "glapi.h"
+#include "shaders.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const int kMaxCommandLookback = 16;
+static const int kVerticesPerQuad = 6;
+static const int kQuadVertexOrder[] = { 0, 1, 2, 2, 3, 0 };
+
+static const glm::vec2 kUnitQuadCorners[] = {
+    glm::vec2(0.0f, 0.0f),
+    glm::vec2(1.0f, 0.0f),
+    glm::vec2(1.0f, 1.0f),
+    glm::vec2(0.0f, 1.0f)
+};
+
+static const glm::vec2 kUnitQuadTexCoords[] = {
+    glm::vec2(0.0f, 1.0f),
+    glm::vec2(1.0f, 1.0f),
+    glm::vec2(1.0f, 0.0f),
+    glm::vec2(0.0f, 0.0f)
+};
+
+GUIBatch &GUIBatch::instance() {
+    static GUIBatch batch;
+    return batch;
+}
+
+void GUIBatch::initGL() {
+    if (_glInited) return;
+
+    glGenBuffers(1, &_vertexBufferId);
+    glGenVertexArrays(1, &_vertexArrayId);
+
+    TheBufferArena.unbind();
+    glBindVertexArray(_vertexArrayId);
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, color)));
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, texCoords)));
+
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, text)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    _glInited = true;
+}
+
+GUIBatch::~GUIBatch() {
+    deinitGL();
+}
+
+void GUIBatch::deinitGL() {
+    if (!_glInited) return;
+
+    glDeleteVertexArrays(1, &_vertexArrayId);
+    glDeleteBuffers(1, &_vertexBufferId);
+
+    _glInited = false;
+}
+
+void GUIBatch::addQuad(const shared_ptr<Texture> &texture, const glm::mat4 &transform, const glm::vec3 &color, bool additive) {
+    if (!texture) return;
+
+    Quad quad;
+    for (int i = 0; i < 4; ++i) {
+        Vertex &vertex = quad.vertices[i];
+        vertex.position = glm::vec2(transform * glm::vec4(kUnitQuadCorners[i], 0.0f, 1.0f));
+        vertex.texCoords = kUnitQuadTexCoords[i];
+        vertex.color = color;
+    }
+
+    add(texture, additive, quad);
+}
+
+void GUIBatch::setAtlas(const TextureAtlas *atlas) {
+    _atlas = atlas;
+}
+
+void GUIBatch::addGlyph(
+    const shared_ptr<Texture> &texture,
+    const glm::vec2 &topLeft,
+    const glm::vec2 &bottomRight,
+    const glm::vec2 &uvTopLeft,
+    const glm::vec2 &uvBottomRight,
+    const glm::vec3 &color) {
+
+    if (!texture) return;
+
+    Quad quad;
+    quad.vertices[0].position = topLeft;
+    quad.vertices[0].texCoords = uvTopLeft;
+    quad.vertices[1].position = glm::vec2(bottomRight.x, topLeft.y);
+    quad.vertices[1].texCoords = glm::vec2(uvBottomRight.x, uvTopLeft.y);
+    quad.vertices[2].position = bottomRight;
+    quad.vertices[2].texCoords = uvBottomRight;
+    quad.vertices[3].position = glm::vec2(topLeft.x, bottomRight.y);
+    quad.vertices[3].texCoords = glm::vec2(uvTopLeft.x, uvBottomRight.y);
+
+    for (auto &vertex : quad.vertices) {
+        vertex.color = color;
+        vertex.text = 1.0f;
+    }
+
+    add(texture, false, quad);
+}
+
+void GUIBatch::add(const shared_ptr<Texture> &texture, bool additive, Quad &quad) {
+    const TextureAtlas::Region *region = _atlas ? _atlas->find(texture.get()) : nullptr;
+    if (region) {
+        for (auto &vertex : quad.vertices) {
+            vertex.texCoords = glm::mix(region->uvMin, region->uvMax, vertex.texCoords);
+        }
+    }
+    const shared_ptr<Texture> &batchTexture = region ? region->page : texture;
+
+    glm::vec2 boundsMin(quad.vertices[0].position);
+    glm::vec2 boundsMax(quad.vertices[0].position);
+
+    for (int i = 1; i < 4; ++i) {
+        boundsMin = glm::min(boundsMin, quad.vertices[i].position);
+        boundsMax = glm::max(boundsMax, quad.vertices[i].position);
+    }
+
+    int commandIdx = findCommand(batchTexture.get(), additive, boundsMin, boundsMax);
+    if (commandIdx == -1) {
+        Command command;
+        command.texture = batchTexture;
+        command.additive = additive;
+        command.boundsMin = boundsMin;
+        command.boundsMax = boundsMax;
+
+        _commands.push_back(move(command));
+        commandIdx = static_cast<int>(_commands.size()) - 1;
+    }
+    Command &command = _commands[commandIdx];
+    command.boundsMin = glm::min(command.boundsMin, boundsMin);
+    command.boundsMax = glm::max(command.boundsMax, boundsMax);
+    command.quadCount++;
+
+    quad.command = commandIdx;
+    _quads.push_back(quad);
+}
+
+int GUIBatch::findCommand(const Texture *texture, bool additive, const glm::vec2 &boundsMin, const glm::vec2 &boundsMax) const {
+    int commandCount = static_cast<int>(_commands.size());
+    int lastIdx = max(0, commandCount - kMaxCommandLookback);
+
+    for (int i = commandCount - 1; i >= lastIdx; --i) {
+        const Command &command = _commands[i];
+        if (command.texture.get() == texture && command.additive == additive) return i;
+
+        // A quad cannot be moved below a quad it overlaps
+        bool overlaps =
+            boundsMin.x < command.boundsMax.x && boundsMax.x > command.boundsMin.x &&
+            boundsMin.y < command.boundsMax.y && boundsMax.y > command.boundsMin.y;
+
+        if (overlaps) break;
+    }
+
+    return -1;
+}
+
+void GUIBatch::flush() {
+    if (_quads.empty()) return;
+
+    // Group quads by command, preserving their relative order
+
+    vector<int> commandOffsets(_commands.size());
+    int offset = 0;
+    for (size_t i = 0; i < _commands.size(); ++i) {
+        commandOffsets[i] = offset;
+        offset += kVerticesPerQuad * _commands[i].quadCount;
+    }
+
+    _vertices.resize(offset);
+
+    for (auto &quad : _quads) {
+        int &vertexIdx = commandOffsets[quad.command];
+        for (int i = 0; i < kVerticesPerQuad; ++i) {
+            _vertices[vertexIdx++] = quad.vertices[kQuadVertexOrder[i]];
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
+    glBufferData(GL_ARRAY_BUFFER, _vertices.size() * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, _vertices.size() * sizeof(Vertex), &_vertices[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    TheBufferArena.unbind();
+    glBindVertexArray(_vertexArrayId);
+
+    ShaderManager &shaders = ShaderMan;
+    shaders.activate(ShaderProgram::GUI);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    int firstVertex = 0;
+    for (auto &command : _commands) {
+        int vertexCount = kVerticesPerQuad * command.quadCount;
+
+        GLint blendSrcRgb, blendSrcAlpha, blendDstRgb, blendDstAlpha;
+        if (command.additive) {
+            glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb);
+            glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+            glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb);
+            glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+            glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+        }
+
+        command.texture->bind();
+        glDrawArrays(GL_TRIANGLES, firstVertex, vertexCount);
+        command.texture->unbind();
+
+        if (command.additive) {
+            glBlendFuncSeparate(blendSrcRgb, blendDstRgb, blendSrcAlpha, blendDstAlpha);
+        }
+
+        firstVertex += vertexCount;
+    }
+
+    glBindVertexArray(0);
+
+    _quads.clear();
+    _commands.clear();
+}
+
+} // namespace render
+
+} // namespace reone
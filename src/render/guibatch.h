@@ -0,0 +1,125 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "texture.h"
+#include "textureatlas.h"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Accumulates textured GUI quads (fills, borders, icons and glyphs) and
+ * draws them from a single streaming vertex buffer, one draw call per
+ * texture run. Quads are reordered to join an earlier run with the same
+ * texture, unless that would change how overlapping quads are composited.
+ */
+class GUIBatch {
+public:
+    static GUIBatch &instance();
+
+    void initGL();
+    void deinitGL();
+
+    /**
+     * Appends a quad, whose corners are those of a unit quad transformed by
+     * the specified matrix. Matches the layout of GUIQuad.
+     */
+    void addQuad(
+        const std::shared_ptr<Texture> &texture,
+        const glm::mat4 &transform,
+        const glm::vec3 &color = glm::vec3(1.0f),
+        bool additive = false);
+
+    /**
+     * Appends a glyph quad. Only the alpha channel of the texture is sampled.
+     */
+    void addGlyph(
+        const std::shared_ptr<Texture> &texture,
+        const glm::vec2 &topLeft,
+        const glm::vec2 &bottomRight,
+        const glm::vec2 &uvTopLeft,
+        const glm::vec2 &uvBottomRight,
+        const glm::vec3 &color);
+
+    /**
+     * Draws all pending quads and clears the batch.
+     */
+    void flush();
+
+    /**
+     * Sets the atlas to look up textures of subsequently added quads in.
+     * Packed textures are replaced by their atlas pages.
+     */
+    void setAtlas(const TextureAtlas *atlas);
+
+private:
+    struct Vertex {
+        glm::vec2 position { 0.0f };
+        glm::vec2 texCoords { 0.0f };
+        glm::vec3 color { 1.0f };
+        float text { 0.0f };
+    };
+
+    struct Quad {
+        int command { 0 };
+        Vertex vertices[4];
+    };
+
+    struct Command {
+        std::shared_ptr<Texture> texture;
+        bool additive { false };
+        glm::vec2 boundsMin { 0.0f };
+        glm::vec2 boundsMax { 0.0f };
+        int quadCount { 0 };
+    };
+
+    bool _glInited { false };
+    const TextureAtlas *_atlas { nullptr };
+    uint32_t _vertexBufferId { 0 };
+    uint32_t _vertexArrayId { 0 };
+    std::vector<Quad> _quads;
+    std::vector<Command> _commands;
+    std::vector<Vertex> _vertices;
+
+    GUIBatch() = default;
+    GUIBatch(const GUIBatch &) = delete;
+    ~GUIBatch();
+
+    GUIBatch &operator=(const GUIBatch &) = delete;
+
+    void add(const std::shared_ptr<Texture> &texture, bool additive, Quad &quad);
+
+    /**
+     * @return index of the command the quad can be appended to, or -1
+     */
+    int findCommand(const Texture *texture, bool additive, const glm::vec2 &boundsMin, const glm::vec2 &boundsMax) const;
+};
+
+#define TheGUIBatch render::GUIBatch::instance()
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,134 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "instancebuffer.h"
+
+#include <cstddef>
+
+#include "glapi.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const int kTransformLocation = 6;
+static const int kAlphaBonesLocation = 10;
+static const int kBonePaletteUnit = 5;
+
+InstanceBuffer &InstanceBuffer::instance() {
+    static InstanceBuffer buffer;
+    return buffer;
+}
+
+void InstanceBuffer::initGL() {
+    if (_glInited) return;
+
+    // Arena pages bind instance attributes for all meshes, so the buffer
+    // always holds at least one instance for non-instanced draws to fetch
+
+    InstanceData defaultInstance;
+
+    glGenBuffers(1, &_instanceBufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBufferId);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData), &defaultInstance, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &_boneBufferId);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, _boneBufferId);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &_boneTextureId);
+    glBindTexture(GL_TEXTURE_BUFFER, _boneTextureId);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _boneBufferId);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    _glInited = true;
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    deinitGL();
+}
+
+void InstanceBuffer::deinitGL() {
+    if (!_glInited) return;
+
+    glDeleteTextures(1, &_boneTextureId);
+    glDeleteBuffers(1, &_boneBufferId);
+    glDeleteBuffers(1, &_instanceBufferId);
+
+    _glInited = false;
+}
+
+void InstanceBuffer::bindAttributes() const {
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBufferId);
+
+    for (int i = 0; i < 4; ++i) {
+        int location = kTransformLocation + i;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void *>(offsetof(InstanceData, transform) + i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glEnableVertexAttribArray(kAlphaBonesLocation);
+    glVertexAttribPointer(kAlphaBonesLocation, 2, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void *>(offsetof(InstanceData, alpha)));
+    glVertexAttribDivisor(kAlphaBonesLocation, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::setInstances(const vector<InstanceData> &instances) {
+    if (instances.empty()) return;
+
+    GLsizeiptr size = instances.size() * sizeof(InstanceData);
+
+    // Orphan the previous storage so that the driver does not have to wait for pending draw calls
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBufferId);
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, &instances[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::setBonePalette(const vector<glm::mat4> &bones) {
+    if (bones.empty()) return;
+
+    GLsizeiptr size = bones.size() * sizeof(glm::mat4);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, _boneBufferId);
+    glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, &bones[0]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void InstanceBuffer::bindBonePalette() const {
+    glActiveTexture(GL_TEXTURE0 + kBonePaletteUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, _boneTextureId);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void InstanceBuffer::unbindBonePalette() const {
+    glActiveTexture(GL_TEXTURE0 + kBonePaletteUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+} // namespace render
+
+} // namespace reone
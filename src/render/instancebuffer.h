@@ -0,0 +1,80 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Per-instance attributes of an instanced draw call.
+ */
+struct InstanceData {
+    glm::mat4 transform { 1.0f };
+    float alpha { 1.0f };
+    float bonesOffset { 0.0f }; /**< index of the first bone of this instance in the bone palette */
+};
+
+/**
+ * Shared streaming buffers for instanced rendering: a vertex buffer with
+ * per-instance attributes and a texture buffer holding bone matrices of
+ * all skinned instances in a batch.
+ */
+class InstanceBuffer {
+public:
+    static InstanceBuffer &instance();
+
+    void initGL();
+    void deinitGL();
+
+    /**
+     * Binds per-instance attributes to the currently bound vertex array.
+     * Until instances are set, the attributes hold a single instance with
+     * identity transform and full opacity.
+     */
+    void bindAttributes() const;
+
+    void setInstances(const std::vector<InstanceData> &instances);
+    void setBonePalette(const std::vector<glm::mat4> &bones);
+
+    void bindBonePalette() const;
+    void unbindBonePalette() const;
+
+private:
+    bool _glInited { false };
+    uint32_t _instanceBufferId { 0 };
+    uint32_t _boneBufferId { 0 };
+    uint32_t _boneTextureId { 0 };
+
+    InstanceBuffer() = default;
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    ~InstanceBuffer();
+
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+};
+
+#define TheInstanceBuffer render::InstanceBuffer::instance()
+
+} // namespace render
+
+} // namespace reone
@@ -17,10 +17,7 @@
 
 #include "aabb.h"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
+#include "../glapi.h"
 #include "../shaders.h"
 
 using namespace std;
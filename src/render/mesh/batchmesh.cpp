@@ -0,0 +1,97 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "batchmesh.h"
+
+#include "glm/ext.hpp"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const int kStride = 10;
+static const size_t kMaxVertexCount = 0x10000;
+
+static Mesh::VertexOffsets g_offsets = { 0, 3 * sizeof(float), 6 * sizeof(float), 8 * sizeof(float), -1, -1, kStride * sizeof(float) };
+
+BatchMesh::BatchMesh() {
+    _offsets = g_offsets;
+}
+
+void BatchMesh::initGL() {
+    if (_glInited) return;
+
+    computeAABB();
+    Mesh::initGL();
+}
+
+bool BatchMesh::append(const Mesh &mesh, const glm::mat4 &transform) {
+    const vector<float> &vertices = mesh.vertices();
+    const VertexOffsets &offsets = mesh.offsets();
+
+    int stride = offsets.stride / sizeof(float);
+    size_t vertexCount = vertices.size() / stride;
+    size_t baseVertex = _vertices.size() / kStride;
+
+    if (baseVertex + vertexCount > kMaxVertexCount) return false;
+
+    glm::mat3 normalTransform(glm::transpose(glm::inverse(glm::mat3(transform))));
+    _vertices.reserve(_vertices.size() + kStride * vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float *pv = &vertices[i * stride];
+
+        glm::vec3 position(transform * glm::vec4(glm::make_vec3(pv + offsets.vertexCoords / sizeof(float)), 1.0f));
+        glm::vec3 normal(0.0f);
+        glm::vec2 texCoords1(0.0f);
+        glm::vec2 texCoords2(0.0f);
+
+        if (offsets.normals != -1) {
+            normal = glm::normalize(normalTransform * glm::make_vec3(pv + offsets.normals / sizeof(float)));
+        }
+        if (offsets.texCoords1 != -1) {
+            texCoords1 = glm::make_vec2(pv + offsets.texCoords1 / sizeof(float));
+        }
+        if (offsets.texCoords2 != -1) {
+            texCoords2 = glm::make_vec2(pv + offsets.texCoords2 / sizeof(float));
+        }
+
+        _vertices.insert(_vertices.end(), { position.x, position.y, position.z });
+        _vertices.insert(_vertices.end(), { normal.x, normal.y, normal.z });
+        _vertices.insert(_vertices.end(), { texCoords1.x, texCoords1.y });
+        _vertices.insert(_vertices.end(), { texCoords2.x, texCoords2.y });
+    }
+
+    const vector<uint16_t> &indices = mesh.indices();
+    _indices.reserve(_indices.size() + indices.size());
+
+    for (uint16_t index : indices) {
+        _indices.push_back(static_cast<uint16_t>(baseVertex + index));
+    }
+
+    return true;
+}
+
+bool BatchMesh::empty() const {
+    return _indices.empty();
+}
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,53 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "glm/mat4x4.hpp"
+
+#include "mesh.h"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Mesh assembled at runtime from several meshes, with vertices
+ * transformed into world space.
+ *
+ * @see reone::render::StaticGeometry
+ */
+class BatchMesh : public Mesh {
+public:
+    BatchMesh();
+
+    void initGL();
+
+    /**
+     * Appends vertices and indices of the mesh, transformed by the
+     * specified matrix.
+     *
+     * @return false if the mesh does not fit into this batch
+     */
+    bool append(const Mesh &mesh, const glm::mat4 &transform);
+
+    bool empty() const;
+};
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,252 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bufferarena.h"
+
+#include <algorithm>
+
+#include "../glapi.h"
+#include "../instancebuffer.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const int kPageVertexBytes = 8 * 1024 * 1024;
+static const int kPageIndexCount = 1024 * 1024;
+
+static bool isSameLayout(const Mesh::VertexOffsets &left, const Mesh::VertexOffsets &right) {
+    return
+        left.vertexCoords == right.vertexCoords &&
+        left.normals == right.normals &&
+        left.texCoords1 == right.texCoords1 &&
+        left.texCoords2 == right.texCoords2 &&
+        left.boneWeights == right.boneWeights &&
+        left.boneIndices == right.boneIndices &&
+        left.stride == right.stride;
+}
+
+BufferArena &BufferArena::instance() {
+    static BufferArena arena;
+    return arena;
+}
+
+int BufferArena::allocateRange(vector<Range> &ranges, int size) {
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        if (it->size < size) continue;
+
+        int offset = it->offset;
+        it->offset += size;
+        it->size -= size;
+
+        if (it->size == 0) {
+            ranges.erase(it);
+        }
+
+        return offset;
+    }
+
+    return -1;
+}
+
+void BufferArena::freeRange(vector<Range> &ranges, int offset, int size) {
+    if (size == 0) return;
+
+    auto it = lower_bound(ranges.begin(), ranges.end(), offset, [](const Range &range, int offset) {
+        return range.offset < offset;
+    });
+    Range range;
+    range.offset = offset;
+    range.size = size;
+    it = ranges.insert(it, range);
+
+    auto next = it + 1;
+    if (next != ranges.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        ranges.erase(next);
+    }
+    if (it != ranges.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            ranges.erase(it);
+        }
+    }
+}
+
+BufferArena::~BufferArena() {
+    deinitGL();
+}
+
+void BufferArena::deinitGL() {
+    for (auto &page : _pages) {
+        glDeleteVertexArrays(1, &page->vertexArrayId);
+        glDeleteBuffers(1, &page->indexBufferId);
+        glDeleteBuffers(1, &page->vertexBufferId);
+    }
+    _pages.clear();
+    _boundPage = -1;
+}
+
+Mesh::BufferLocation BufferArena::allocate(const Mesh::VertexOffsets &offsets, const vector<float> &vertices, const vector<uint16_t> &indices) {
+    int floatsPerVertex = offsets.stride / sizeof(float);
+    int vertexCount = static_cast<int>(vertices.size()) / floatsPerVertex;
+    int indexCount = static_cast<int>(indices.size());
+
+    Mesh::BufferLocation location;
+    location.vertexCount = vertexCount;
+    location.indexCount = indexCount;
+
+    for (int i = 0; i < static_cast<int>(_pages.size()) && location.page == -1; ++i) {
+        Page &page = *_pages[i];
+        if (!isSameLayout(page.offsets, offsets)) continue;
+
+        int baseVertex = allocateRange(page.freeVertices, vertexCount);
+        if (baseVertex == -1) continue;
+
+        int firstIndex = allocateRange(page.freeIndices, indexCount);
+        if (firstIndex == -1) {
+            freeRange(page.freeVertices, baseVertex, vertexCount);
+            continue;
+        }
+
+        location.page = i;
+        location.baseVertex = baseVertex;
+        location.firstIndex = firstIndex;
+    }
+    if (location.page == -1) {
+        location.page = newPage(offsets, vertexCount, indexCount);
+
+        Page &page = *_pages[location.page];
+        location.baseVertex = allocateRange(page.freeVertices, vertexCount);
+        location.firstIndex = allocateRange(page.freeIndices, indexCount);
+    }
+
+    const Page &page = *_pages[location.page];
+    bindPage(location.page);
+
+    glBindBuffer(GL_ARRAY_BUFFER, page.vertexBufferId);
+    glBufferSubData(GL_ARRAY_BUFFER, location.baseVertex * offsets.stride, vertices.size() * sizeof(float), &vertices[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, location.firstIndex * sizeof(uint16_t), indices.size() * sizeof(uint16_t), &indices[0]);
+
+    return move(location);
+}
+
+int BufferArena::newPage(const Mesh::VertexOffsets &offsets, int vertexCount, int indexCount) {
+    auto page = make_unique<Page>();
+    page->offsets = offsets;
+    page->vertexCapacity = max(vertexCount, kPageVertexBytes / offsets.stride);
+    page->indexCapacity = max(indexCount, kPageIndexCount);
+
+    Range vertices;
+    vertices.size = page->vertexCapacity;
+    page->freeVertices.push_back(move(vertices));
+
+    Range indices;
+    indices.size = page->indexCapacity;
+    page->freeIndices.push_back(move(indices));
+
+    glGenBuffers(1, &page->vertexBufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, page->vertexBufferId);
+    glBufferData(GL_ARRAY_BUFFER, page->vertexCapacity * offsets.stride, nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &page->indexBufferId);
+    glGenVertexArrays(1, &page->vertexArrayId);
+    glBindVertexArray(page->vertexArrayId);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBufferId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, page->indexCapacity * sizeof(uint16_t), nullptr, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.vertexCoords));
+
+    if (offsets.normals != -1) {
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.normals));
+    }
+    if (offsets.texCoords1 != -1) {
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.texCoords1));
+    }
+    if (offsets.texCoords2 != -1) {
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.texCoords2));
+    }
+    if (offsets.boneWeights != -1) {
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.boneWeights));
+    }
+    if (offsets.boneIndices != -1) {
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, offsets.stride, reinterpret_cast<void *>(offsets.boneIndices));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    TheInstanceBuffer.bindAttributes();
+
+    _pages.push_back(move(page));
+
+    int index = static_cast<int>(_pages.size()) - 1;
+    _boundPage = index;
+
+    return index;
+}
+
+void BufferArena::free(const Mesh::BufferLocation &location) {
+    if (location.page < 0 || location.page >= static_cast<int>(_pages.size())) return;
+
+    Page &page = *_pages[location.page];
+    freeRange(page.freeVertices, location.baseVertex, location.vertexCount);
+    freeRange(page.freeIndices, location.firstIndex, location.indexCount);
+}
+
+void BufferArena::bind(const Mesh::BufferLocation &location) {
+    bindPage(location.page);
+}
+
+void BufferArena::unbind() {
+    if (_boundPage == -1) return;
+
+    glBindVertexArray(0);
+    _boundPage = -1;
+}
+
+void BufferArena::bindPage(int index) {
+    if (_boundPage == index) return;
+
+    glBindVertexArray(_pages[index]->vertexArrayId);
+    _boundPage = index;
+}
+
+bool BufferArena::keepClientData() const {
+    return _keepClientData;
+}
+
+int BufferArena::pageCount() const {
+    return static_cast<int>(_pages.size());
+}
+
+void BufferArena::setKeepClientData(bool keep) {
+    _keepClientData = keep;
+}
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,116 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mesh.h"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Shared vertex and index buffers, split into pages. All meshes of a
+ * page share a vertex layout and a vertex array object, so that meshes
+ * are drawn with base vertex offsets instead of separate buffers.
+ *
+ * @see reone::render::Mesh
+ */
+class BufferArena {
+public:
+    static BufferArena &instance();
+
+    void deinitGL();
+
+    /**
+     * Uploads vertices and indices into a page with a matching vertex
+     * layout, creating a new page if necessary.
+     */
+    Mesh::BufferLocation allocate(const Mesh::VertexOffsets &offsets, const std::vector<float> &vertices, const std::vector<uint16_t> &indices);
+
+    void free(const Mesh::BufferLocation &location);
+
+    /**
+     * Binds the vertex array object of the page, containing the specified location.
+     */
+    void bind(const Mesh::BufferLocation &location);
+
+    /**
+     * Unbinds the current page. Must be called before binding a vertex
+     * array object, not owned by the arena.
+     */
+    void unbind();
+
+    /**
+     * @return true if meshes must keep vertices and indices in client memory after upload
+     */
+    bool keepClientData() const;
+    int pageCount() const;
+
+    void setKeepClientData(bool keep);
+
+private:
+    struct Range {
+        int offset { 0 };
+        int size { 0 };
+    };
+
+    struct Page {
+        Mesh::VertexOffsets offsets;
+        int vertexCapacity { 0 };
+        int indexCapacity { 0 };
+        std::vector<Range> freeVertices;
+        std::vector<Range> freeIndices;
+        uint32_t vertexBufferId { 0 };
+        uint32_t indexBufferId { 0 };
+        uint32_t vertexArrayId { 0 };
+    };
+
+    std::vector<std::unique_ptr<Page>> _pages;
+    int _boundPage { -1 };
+    bool _keepClientData { false };
+
+    BufferArena() = default;
+    BufferArena(const BufferArena &) = delete;
+    ~BufferArena();
+
+    BufferArena &operator=(const BufferArena &) = delete;
+
+    /**
+     * Takes the first free range that is large enough.
+     *
+     * @return offset of the allocated range, or -1
+     */
+    static int allocateRange(std::vector<Range> &ranges, int size);
+
+    /**
+     * Returns a range to the sorted list of free ranges, merging it with adjacent ones.
+     */
+    static void freeRange(std::vector<Range> &ranges, int offset, int size);
+
+    int newPage(const Mesh::VertexOffsets &offsets, int vertexCount, int indexCount);
+    void bindPage(int index);
+};
+
+#define TheBufferArena render::BufferArena::instance()
+
+} // namespace render
+
+} // namespace reone
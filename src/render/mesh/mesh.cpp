@@ -19,11 +19,11 @@
 
 #include <cassert>
 
-#include "GL/glew.h"
+#include "glm/ext.hpp"
 
-#include "SDL2/SDL_opengl.h"
+#include "../glapi.h"
 
-#include "glm/ext.hpp"
+#include "bufferarena.h"
 
 namespace reone {
 
@@ -47,46 +47,14 @@ void Mesh::initGL() {
 
     assert(!_vertices.empty() && !_indices.empty());
 
-    glGenBuffers(1, &_vertexBufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
-    glBufferData(GL_ARRAY_BUFFER, _vertices.size() * sizeof(float), &_vertices[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glGenBuffers(1, &_indexBufferId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferId);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof(uint16_t), &_indices[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    BufferArena &arena = BufferArena::instance();
+    _location = arena.allocate(_offsets, _vertices, _indices);
 
-    glGenVertexArrays(1, &_vertexArrayId);
-    glBindVertexArray(_vertexArrayId);
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.vertexCoords));
-
-    if (_offsets.normals != -1) {
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.normals));
-    }
-    if (_offsets.texCoords1 != -1) {
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.texCoords1));
-    }
-    if (_offsets.texCoords2 != -1) {
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.texCoords2));
-    }
-    if (_offsets.boneWeights != -1) {
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.boneWeights));
-    }
-    if (_offsets.boneIndices != -1) {
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, _offsets.stride, reinterpret_cast<void *>(_offsets.boneIndices));
+    if (!_keepClientData && !arena.keepClientData()) {
+        _vertices = std::vector<float>();
+        _indices = std::vector<uint16_t>();
     }
 
-    glBindVertexArray(0);
-
     _glInited = true;
 }
 
@@ -97,33 +65,63 @@ Mesh::~Mesh() {
 void Mesh::deinitGL() {
     if (!_glInited) return;
 
-    glDeleteVertexArrays(1, &_vertexArrayId);
-    glDeleteBuffers(1, &_indexBufferId);
-    glDeleteBuffers(1, &_vertexBufferId);
+    BufferArena::instance().free(_location);
+    _location = BufferLocation();
 
     _glInited = false;
 }
 
 void Mesh::render(uint32_t mode) const {
-    render(mode, static_cast<int>(_indices.size()), 0);
+    render(mode, _location.indexCount, 0);
 }
 
 void Mesh::render(uint32_t mode, int count, int offset) const {
     assert(_glInited);
 
-    glBindVertexArray(_vertexArrayId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferId);
+    BufferArena::instance().bind(_location);
+
+    glDrawElementsBaseVertex(
+        mode,
+        count,
+        GL_UNSIGNED_SHORT,
+        reinterpret_cast<void *>(_location.firstIndex * sizeof(uint16_t) + offset),
+        _location.baseVertex);
+}
+
+void Mesh::renderInstanced(uint32_t mode, int instanceCount) const {
+    assert(_glInited);
 
-    glDrawElements(mode, count, GL_UNSIGNED_SHORT, reinterpret_cast<void *>(offset));
+    BufferArena::instance().bind(_location);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    glDrawElementsInstancedBaseVertex(
+        mode,
+        _location.indexCount,
+        GL_UNSIGNED_SHORT,
+        reinterpret_cast<void *>(_location.firstIndex * sizeof(uint16_t)),
+        instanceCount,
+        _location.baseVertex);
 }
 
 const AABB &Mesh::aabb() const {
     return _aabb;
 }
 
+const std::vector<float> &Mesh::vertices() const {
+    return _vertices;
+}
+
+const std::vector<uint16_t> &Mesh::indices() const {
+    return _indices;
+}
+
+const Mesh::VertexOffsets &Mesh::offsets() const {
+    return _offsets;
+}
+
+void Mesh::setKeepClientData(bool keep) {
+    _keepClientData = keep;
+}
+
 } // namespace render
 
 } // namespace reone
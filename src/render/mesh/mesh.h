@@ -34,7 +34,11 @@ namespace render {
 
 /**
  * Polygonal mesh, containing vertex and index data. Renders itself,
- * but does not manage textures and shaders.
+ * but does not manage textures and shaders. Vertex and index data is
+ * stored in shared buffers and, unless requested otherwise, released
+ * from client memory once uploaded.
+ *
+ * @see reone::render::BufferArena
  */
 class Mesh {
 public:
@@ -48,19 +52,40 @@ public:
         int stride { 0 };
     };
 
+    /**
+     * Location of mesh data inside the shared buffers.
+     */
+    struct BufferLocation {
+        int page { -1 };
+        int baseVertex { 0 };
+        int vertexCount { 0 };
+        int firstIndex { 0 };
+        int indexCount { 0 };
+    };
+
     void initGL();
     void deinitGL();
     void render(uint32_t mode) const;
+    void renderInstanced(uint32_t mode, int instanceCount) const;
 
     const AABB &aabb() const;
+    const std::vector<float> &vertices() const;
+    const std::vector<uint16_t> &indices() const;
+    const VertexOffsets &offsets() const;
+
+    /**
+     * Keeps vertex and index data in client memory after upload. Must be
+     * called before the mesh is uploaded.
+     */
+    void setKeepClientData(bool keep);
 
 protected:
     bool _glInited { false };
+    bool _keepClientData { false };
     std::vector<float> _vertices;
     std::vector<uint16_t> _indices;
     VertexOffsets _offsets;
-    uint32_t _indexBufferId { 0 };
-    uint32_t _vertexArrayId { 0 };
+    BufferLocation _location;
 
     Mesh() = default;
     virtual ~Mesh();
@@ -69,7 +94,6 @@ protected:
     void render(uint32_t mode, int count, int offset) const;
 
 private:
-    uint32_t _vertexBufferId { 0 };
     AABB _aabb;
 
     Mesh(const Mesh &) = delete;
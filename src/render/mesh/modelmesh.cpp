@@ -17,9 +17,7 @@
 
 #include "modelmesh.h"
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
+#include "../glapi.h"
 
 using namespace std;
 
@@ -43,6 +41,14 @@ void ModelMesh::initGL() {
 }
 
 void ModelMesh::render(const shared_ptr<Texture> &diffuseOverride) const {
+    draw(diffuseOverride, 0);
+}
+
+void ModelMesh::renderInstanced(int instanceCount, const shared_ptr<Texture> &diffuseOverride) const {
+    draw(diffuseOverride, instanceCount);
+}
+
+void ModelMesh::draw(const shared_ptr<Texture> &diffuseOverride, int instanceCount) const {
     const shared_ptr<Texture> &diffuse = diffuseOverride ? diffuseOverride : _diffuse;
     bool additive = false;
 
@@ -77,7 +83,11 @@ void ModelMesh::render(const shared_ptr<Texture> &diffuseOverride) const {
         glBlendFunc(GL_ONE, GL_ONE);
     }
 
-    Mesh::render(GL_TRIANGLES);
+    if (instanceCount > 0) {
+        Mesh::renderInstanced(GL_TRIANGLES, instanceCount);
+    } else {
+        Mesh::render(GL_TRIANGLES);
+    }
 
     if (additive) {
         glBlendFuncSeparate(blendSrcRgb, blendDstRgb, blendSrcAlpha, blendDstAlpha);
@@ -142,6 +152,10 @@ const shared_ptr<Texture> &ModelMesh::diffuseTexture() const {
     return _diffuse;
 }
 
+const shared_ptr<Texture> &ModelMesh::lightmapTexture() const {
+    return _lightmap;
+}
+
 } // namespace render
 
 } // namespace reone
@@ -45,6 +45,7 @@ public:
 
     void initGL();
     void render(const std::shared_ptr<Texture> &diffuseOverride = nullptr) const;
+    void renderInstanced(int instanceCount, const std::shared_ptr<Texture> &diffuseOverride = nullptr) const;
 
     bool shouldRender() const;
     bool isTransparent() const;
@@ -55,6 +56,7 @@ public:
     bool hasBumpmapTexture() const;
 
     const std::shared_ptr<Texture> &diffuseTexture() const;
+    const std::shared_ptr<Texture> &lightmapTexture() const;
 
 private:
     bool _render { false };
@@ -64,6 +66,8 @@ private:
     std::shared_ptr<Texture> _bumpyShiny;
     std::shared_ptr<Texture> _bumpmap;
 
+    void draw(const std::shared_ptr<Texture> &diffuseOverride, int instanceCount) const;
+
     friend class resources::MdlFile;
 };
 
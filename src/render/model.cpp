@@ -46,6 +46,7 @@ Model::Model(
 void Model::init(const shared_ptr<ModelNode> &node) {
     _nodeByNumber.insert(make_pair(node->nodeNumber(), node));
     _nodeByName.insert(make_pair(node->name(), node));
+    _nodeCount = glm::max(_nodeCount, node->index() + 1);
 
     shared_ptr<ModelMesh> mesh(node->mesh());
     if (mesh) {
@@ -74,6 +75,33 @@ shared_ptr<Animation> Model::findAnimation(const string &name, const Model **mod
     return nullptr;
 }
 
+const vector<AnimationChannel> &Model::getAnimationChannels(const Animation &anim) {
+    lock_guard<mutex> lock(_channelsMutex);
+
+    auto it = _channelsByAnim.find(&anim);
+    if (it != _channelsByAnim.end()) return it->second;
+
+    vector<bool> bound(_nodeCount, false);
+    vector<AnimationChannel> channels;
+    bindAnimationNode(*anim.rootNode(), bound, channels);
+
+    return _channelsByAnim.insert(make_pair(&anim, move(channels))).first->second;
+}
+
+void Model::bindAnimationNode(const ModelNode &animNode, vector<bool> &bound, vector<AnimationChannel> &channels) const {
+    shared_ptr<ModelNode> modelNode(findNodeByName(animNode.name()));
+    if (modelNode && !bound[modelNode->index()]) {
+        AnimationChannel channel;
+        channel.animNode = &animNode;
+        channel.modelNode = modelNode.get();
+        channels.push_back(move(channel));
+        bound[modelNode->index()] = true;
+    }
+    for (auto &child : animNode.children()) {
+        bindAnimationNode(*child, bound, channels);
+    }
+}
+
 shared_ptr<ModelNode> Model::findNodeByNumber(uint16_t number) const {
     auto it = _nodeByNumber.find(number);
     return it != _nodeByNumber.end() ? it->second : nullptr;
@@ -108,10 +136,23 @@ float Model::radiusXY() const {
     return _radiusXY;
 }
 
+int Model::nodeCount() const {
+    return _nodeCount;
+}
+
 void Model::setAnimationScale(float scale) {
     _animationScale = scale;
 }
 
+void Model::setKeepMeshData(bool keep) {
+    for (auto &pair : _nodeByNumber) {
+        shared_ptr<ModelMesh> mesh(pair.second->mesh());
+        if (mesh) {
+            mesh->setKeepClientData(keep);
+        }
+    }
+}
+
 } // namespace render
 
 } // namespace reone
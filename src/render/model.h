@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "aabb.h"
 #include "animation.h"
 
@@ -24,6 +26,14 @@ namespace reone {
 
 namespace render {
 
+/**
+ * Binds an animation node to a model node of the same name.
+ */
+struct AnimationChannel {
+    const ModelNode *animNode { nullptr };
+    const ModelNode *modelNode { nullptr };
+};
+
 /**
  * Tree-like data structure, representing a 3D model. Contains model nodes
  * and animations. Models are cached and reused between model instances.
@@ -46,15 +56,29 @@ public:
     std::shared_ptr<ModelNode> findNodeByNumber(uint16_t number) const;
     std::shared_ptr<ModelNode> findNodeByName(const std::string &name) const;
 
+    /**
+     * Returns channels of the specified animation bound to nodes of this
+     * model. Channels are computed once per animation and cached.
+     */
+    const std::vector<AnimationChannel> &getAnimationChannels(const Animation &anim);
+
     const std::string &name() const;
     const ModelNode &rootNode() const;
     float animationScale() const;
     std::shared_ptr<Model> superModel() const;
     const AABB &aabb() const;
     float radiusXY() const;
+    int nodeCount() const;
 
     void setAnimationScale(float scale);
 
+    /**
+     * Keeps vertex data of all meshes in client memory after upload, so
+     * that they can be merged into static geometry whenever the model is
+     * reused.
+     */
+    void setKeepMeshData(bool keep);
+
 private:
     std::string _name;
     std::shared_ptr<ModelNode> _rootNode;
@@ -65,11 +89,15 @@ private:
     AABB _aabb;
     float _radiusXY { 0.0f };
     float _animationScale { 1.0f };
+    int _nodeCount { 0 };
+    std::map<const Animation *, std::vector<AnimationChannel>> _channelsByAnim;
+    std::mutex _channelsMutex;
 
     Model(const Model &) = delete;
     Model &operator=(const Model &) = delete;
 
     void init(const std::shared_ptr<ModelNode> &node);
+    void bindAnimationNode(const ModelNode &animNode, std::vector<bool> &bound, std::vector<AnimationChannel> &channels) const;
 
     friend class resources::MdlFile;
 };
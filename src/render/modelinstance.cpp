@@ -18,15 +18,12 @@
 #include <stack>
 #include <stdexcept>
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
-
 #include "../core/log.h"
 #include "../resources/resources.h"
 
 #include "mesh/aabb.h"
 
+#include "glapi.h"
 #include "modelinstance.h"
 
 using namespace std;
@@ -37,8 +34,76 @@ namespace reone {
 
 namespace render {
 
+static glm::mat4 interpolateTransform(const glm::mat4 &left, const glm::mat4 &right, float factor) {
+    glm::quat orientation(glm::slerp(glm::quat_cast(left), glm::quat_cast(right), factor));
+    glm::vec3 position(glm::mix(glm::vec3(left[3]), glm::vec3(right[3]), factor));
+
+    glm::mat4 transform(glm::mat4_cast(orientation));
+    transform[3] = glm::vec4(position, 1.0f);
+
+    return move(transform);
+}
+
+static ShaderProgram getInstancedShaderProgram(ShaderProgram program) {
+    switch (program) {
+        case ShaderProgram::BasicDiffuse:
+            return ShaderProgram::InstancedDiffuse;
+        case ShaderProgram::BasicDiffuseEnvmap:
+            return ShaderProgram::InstancedDiffuseEnvmap;
+        case ShaderProgram::BasicDiffuseBumpyShiny:
+            return ShaderProgram::InstancedDiffuseBumpyShiny;
+        case ShaderProgram::BasicDiffuseLightmap:
+            return ShaderProgram::InstancedDiffuseLightmap;
+        case ShaderProgram::BasicDiffuseLightmapEnvmap:
+            return ShaderProgram::InstancedDiffuseLightmapEnvmap;
+        case ShaderProgram::BasicDiffuseLightmapBumpyShiny:
+            return ShaderProgram::InstancedDiffuseLightmapBumpyShiny;
+        case ShaderProgram::SkeletalDiffuse:
+            return ShaderProgram::SkeletalInstancedDiffuse;
+        case ShaderProgram::SkeletalDiffuseEnvmap:
+            return ShaderProgram::SkeletalInstancedDiffuseEnvmap;
+        case ShaderProgram::SkeletalDiffuseBumpyShiny:
+            return ShaderProgram::SkeletalInstancedDiffuseBumpyShiny;
+        case ShaderProgram::SkeletalDiffuseBumpmap:
+            return ShaderProgram::SkeletalInstancedDiffuseBumpmap;
+        default:
+            return ShaderProgram::None;
+    }
+}
+
 ModelInstance::ModelInstance(const shared_ptr<Model> &model) : _model(model) {
     assert(_model);
+
+    int nodeCount = _model->nodeCount();
+    _nodeTransforms.resize(nodeCount, glm::mat4(1.0f));
+    _boneTransforms.resize(nodeCount, glm::mat4(1.0f));
+    _skipNodes.resize(nodeCount);
+    _staticNodes.resize(nodeCount);
+    _animState.localTransforms.resize(nodeCount, glm::mat4(1.0f));
+    _animState.prevLocalTransforms.resize(nodeCount, glm::mat4(1.0f));
+    _animState.animatedNodes.resize(nodeCount);
+    _animState.prevAnimatedNodes.resize(nodeCount);
+
+    initNodeTransforms(_model->rootNode());
+}
+
+void ModelInstance::initNodeTransforms(const ModelNode &node) {
+    _nodeTransforms[node.index()] = node.absoluteTransform();
+
+    for (auto &child : node.children()) {
+        initNodeTransforms(*child);
+    }
+}
+
+void ModelInstance::initSkipNodes(const ModelNode &parentNode) {
+    const ModelNode *pn = &parentNode;
+    while (pn) {
+        shared_ptr<ModelNode> node(_model->findNodeByName(pn->name()));
+        if (node) {
+            _skipNodes.set(node->index());
+        }
+        pn = pn->parent();
+    }
 }
 
 void ModelInstance::animate(const string &parent, const string &anim, int flags, float speed) {
@@ -81,7 +146,10 @@ void ModelInstance::attach(const string &parentNode, const shared_ptr<Model> &mo
         warn("Parent node not found: " + parentNode);
         return;
     }
-    _attachedModels.insert(make_pair(parent->nodeNumber(), make_unique<ModelInstance>(model)));
+    auto attached = make_unique<ModelInstance>(model);
+    attached->initSkipNodes(*parent);
+
+    _attachedModels.insert(make_pair(parent->nodeNumber(), move(attached)));
 }
 
 void ModelInstance::changeTexture(const string &resRef) {
@@ -91,34 +159,64 @@ void ModelInstance::changeTexture(const string &resRef) {
 }
 
 void ModelInstance::update(float dt) {
-    doUpdate(dt, set<string>());
+    if (!_visible) return;
+
+    // Time not spent animating is accumulated, so that animations do not fall behind
+    _animLodDeltaTime += dt;
+
+    switch (_animLod) {
+        case AnimationLOD::Frozen:
+            // Time spent frozen is not replayed, animations resume where they stopped
+            _animLodDeltaTime = 0.0f;
+            _animLodFrame = 0;
+            _animLodPeriod = 0.0f;
+            return;
+        case AnimationLOD::Reduced:
+            // Between samples, blend the last two sampled poses. The rendered pose trails the animation by one sample.
+            if (++_animLodFrame < _animLodRate) {
+                if (_animLodPeriod > 0.0f) {
+                    interpolateAnimation(glm::min(1.0f, _animLodDeltaTime / _animLodPeriod));
+                }
+                return;
+            }
+            _animLodFrame = 0;
+            // Right after the model was frozen, there is no previous sample to blend from
+            doUpdate(_animLodDeltaTime, _animLodPeriod > 0.0f ? 0.0f : 1.0f);
+            _animLodPeriod = _animLodDeltaTime;
+            _animLodDeltaTime = 0.0f;
+            return;
+        default:
+            break;
+    }
+
+    doUpdate(_animLodDeltaTime);
+    _animLodDeltaTime = 0.0f;
 }
 
-void ModelInstance::doUpdate(float dt, const set<string> &skipNodes) {
+void ModelInstance::doUpdate(float dt, float blend) {
     if (!_visible) return;
 
     if (!_animState.nextAnimation.empty()) {
         startNextAnimation();
     }
     if (!_animState.name.empty()) {
-        advanceAnimation(dt, skipNodes);
+        advanceAnimation(dt);
     }
 
-    _nodeTransforms.clear();
-    _boneTransforms.clear();
-    updateNodeTansforms(_model->rootNode(), glm::mat4(1.0f));
+    updateNodeTansforms(_model->rootNode(), glm::mat4(1.0f), blend);
 
     for (auto &pair : _attachedModels) {
-        set<string> skipNodes;
-        shared_ptr<ModelNode> parent(_model->findNodeByNumber(pair.first));
+        pair.second->doUpdate(dt, blend);
+    }
+}
 
-        const ModelNode *pn = &*parent;
-        while (pn) {
-            skipNodes.insert(pn->name());
-            pn = pn->parent();
-        }
+void ModelInstance::interpolateAnimation(float blend) {
+    if (!_visible) return;
+
+    updateNodeTansforms(_model->rootNode(), glm::mat4(1.0f), blend);
 
-        pair.second->doUpdate(dt, skipNodes);
+    for (auto &pair : _attachedModels) {
+        pair.second->interpolateAnimation(blend);
     }
 }
 
@@ -127,19 +225,21 @@ void ModelInstance::startNextAnimation() {
     shared_ptr<Animation> anim(_model->findAnimation(_animState.nextAnimation, &model));
     if (!anim) return;
 
+    _animState.channels = &_model->getAnimationChannels(*anim);
     _animState.animation = move(anim);
     _animState.model = model;
     _animState.name = _animState.nextAnimation;
     _animState.flags = _animState.nextFlags;
     _animState.speed = _animState.nextSpeed;
     _animState.time = 0.0f;
-    _animState.localTransforms.clear();
+    _animState.cursors.assign(_animState.channels->size(), ModelNode::KeyframeCursor());
+    _animState.animatedNodes.reset();
 
     _animState.nextAnimation.clear();
     _animState.nextFlags = 0;
 }
 
-void ModelInstance::advanceAnimation(float dt, const set<string> &skipNodes) {
+void ModelInstance::advanceAnimation(float dt) {
     float length = _animState.animation->length();
     float time = _animState.time + _animState.speed * dt;
 
@@ -152,100 +252,111 @@ void ModelInstance::advanceAnimation(float dt, const set<string> &skipNodes) {
         }
     }
 
-    _animState.localTransforms.clear();
-    updateAnimTransforms(*_animState.animation->rootNode(), glm::mat4(1.0f), _animState.time, skipNodes);
+    // Keep the previous sample, so that reduced rate animation can be interpolated
+    swap(_animState.localTransforms, _animState.prevLocalTransforms);
+    _animState.animatedNodes.swap(_animState.prevAnimatedNodes);
+
+    updateAnimTransforms();
 }
 
-void ModelInstance::updateAnimTransforms(const ModelNode &animNode, const glm::mat4 &transform, float time, const set<string> &skipNodes) {
-    string name(animNode.name());
-    glm::mat4 absTransform(transform);
+void ModelInstance::updateAnimTransforms() {
+    float time = _animState.time;
+    float scale = _model->animationScale();
 
-    if (skipNodes.count(name) == 0) {
-        shared_ptr<ModelNode> refNode(_model->findNodeByName(name));
-        if (refNode) {
-            glm::mat4 localTransform(glm::translate(glm::mat4(1.0f), refNode->position()));
+    _animState.animatedNodes.reset();
 
-            glm::vec3 position;
-            if (animNode.getPosition(time, position, _model->animationScale())) {
-                localTransform = glm::translate(localTransform, move(position));
-            }
+    const vector<AnimationChannel> &channels = *_animState.channels;
 
-            glm::quat orientation;
-            if (animNode.getOrientation(time, orientation)) {
-                localTransform *= glm::mat4_cast(move(orientation));
-            } else {
-                localTransform *= glm::mat4_cast(refNode->orientation());
-            }
+    for (size_t i = 0; i < channels.size(); ++i) {
+        const AnimationChannel &channel = channels[i];
+        ModelNode::KeyframeCursor &cursor = _animState.cursors[i];
+        const ModelNode &animNode = *channel.animNode;
+        const ModelNode &refNode = *channel.modelNode;
+        int index = refNode.index();
+
+        if (_skipNodes[index]) continue;
+
+        glm::mat4 localTransform(glm::translate(glm::mat4(1.0f), refNode.position()));
 
-            absTransform *= localTransform;
-            _animState.localTransforms.insert(make_pair(name, localTransform));
+        glm::vec3 position;
+        if (animNode.getPosition(time, cursor, position, scale)) {
+            localTransform = glm::translate(localTransform, move(position));
         }
-    }
 
-    for (auto &child : animNode.children()) {
-        updateAnimTransforms(*child, absTransform, time, skipNodes);
+        glm::quat orientation;
+        if (animNode.getOrientation(time, cursor, orientation)) {
+            localTransform *= glm::mat4_cast(move(orientation));
+        } else {
+            localTransform *= glm::mat4_cast(refNode.orientation());
+        }
+
+        _animState.localTransforms[index] = move(localTransform);
+        _animState.animatedNodes.set(index);
     }
 }
 
-void ModelInstance::updateNodeTansforms(const ModelNode &node, const glm::mat4 &transform) {
+void ModelInstance::updateNodeTansforms(const ModelNode &node, const glm::mat4 &transform, float blend) {
     glm::mat4 finalTransform(transform);
     bool animApplied = false;
+    int index = node.index();
 
-    if (!_animState.name.empty()) {
-        auto it = _animState.localTransforms.find(node.name());
-        if (it != _animState.localTransforms.end()) {
-            finalTransform *= it->second;
-            animApplied = true;
+    if (!_animState.name.empty() && _animState.animatedNodes[index]) {
+        if (blend < 1.0f && _animState.prevAnimatedNodes[index]) {
+            finalTransform *= interpolateTransform(_animState.prevLocalTransforms[index], _animState.localTransforms[index], blend);
+        } else {
+            finalTransform *= _animState.localTransforms[index];
         }
+        animApplied = true;
     }
     if (!animApplied) {
         finalTransform = glm::translate(finalTransform, node.position());
         finalTransform *= glm::mat4_cast(node.orientation());
     }
 
-    _nodeTransforms.insert(make_pair(node.nodeNumber(), finalTransform));
-    _boneTransforms.insert(make_pair(node.index(), finalTransform * node.absoluteTransformInverse()));
+    _nodeTransforms[index] = finalTransform;
+    _boneTransforms[index] = finalTransform * node.absoluteTransformInverse();
 
     for (auto &child : node.children()) {
-        updateNodeTansforms(*child, finalTransform);
+        updateNodeTansforms(*child, finalTransform, blend);
     }
 }
 
-void ModelInstance::fillRenderLists(const glm::mat4 &transform, RenderList &opaque, RenderList &transparent) {
+void ModelInstance::fillRenderLists(const glm::mat4 &transform, RenderQueue &queue) const {
     if (!_model || !_visible) return;
 
-    fillRenderLists(_model->rootNode(), transform, opaque, transparent);
+    fillRenderLists(_model->rootNode(), transform, queue);
 
     for (auto &pair : _attachedModels) {
         shared_ptr<ModelNode> parent(_model->findNodeByNumber(pair.first));
         if (!parent) continue;
 
         glm::mat4 finalTransform(transform * getNodeTransform(*parent));
-        pair.second->fillRenderLists(finalTransform, opaque, transparent);
+        pair.second->fillRenderLists(finalTransform, queue);
     }
 }
 
-void ModelInstance::fillRenderLists(const ModelNode &node, const glm::mat4 &transform, RenderList &opaque, RenderList &transparent) {
-    glm::mat4 finalTransform(transform * getNodeTransform(node));
-
+void ModelInstance::fillRenderLists(const ModelNode &node, const glm::mat4 &transform, RenderQueue &queue) const {
     if (shouldRender(node)) {
         shared_ptr<ModelMesh> mesh(node.mesh());
+        glm::mat4 finalTransform(transform * getNodeTransform(node));
 
         RenderListItem item;
         item.model = this;
         item.node = &node;
-        item.transform = finalTransform;
+        item.transformIndex = static_cast<uint32_t>(queue.transforms.size());
         item.origin = finalTransform * glm::vec4(mesh->aabb().center(), 1.0f);
 
+        queue.transforms.push_back(finalTransform);
+
         if (mesh->isTransparent() || node.alpha() < 1.0f) {
-            transparent.push_back(move(item));
+            queue.transparent.push_back(move(item));
         } else {
-            opaque.push_back(move(item));
+            queue.opaque.push_back(move(item));
         }
     }
 
     for (auto &child : node.children()) {
-        fillRenderLists(*child, transform, opaque, transparent);
+        fillRenderLists(*child, transform, queue);
     }
 }
 
@@ -253,16 +364,86 @@ bool ModelInstance::shouldRender(const ModelNode &node) const {
     shared_ptr<ModelMesh> mesh(node.mesh());
     if (!mesh) return false;
 
-    return mesh->shouldRender() && (mesh->hasDiffuseTexture() || _textureOverride);
+    return
+        mesh->shouldRender() &&
+        (mesh->hasDiffuseTexture() || _textureOverride) &&
+        !_staticNodes[node.index()];
+}
+
+vector<const ModelNode *> ModelInstance::extractStaticNodes() {
+    vector<const ModelNode *> nodes;
+    if (_textureOverride || !_attachedModels.empty()) return move(nodes);
+
+    if (!_animState.nextAnimation.empty()) {
+        startNextAnimation();
+    }
+    boost::dynamic_bitset<> animatedNodes(_model->nodeCount());
+    if (_animState.channels) {
+        for (auto &channel : *_animState.channels) {
+            if (channel.animNode->isAnimated()) {
+                animatedNodes.set(channel.modelNode->index());
+            }
+        }
+    }
+    if (!_animState.name.empty()) {
+        updateAnimTransforms();
+    }
+    updateNodeTansforms(_model->rootNode(), glm::mat4(1.0f));
+    extractStaticNodes(_model->rootNode(), animatedNodes, false, nodes);
+
+    // When nothing is left to render, the model instance need not be updated anymore
+    _static = true;
+    stack<const ModelNode *> stack;
+    stack.push(&_model->rootNode());
+
+    while (!stack.empty()) {
+        const ModelNode &node = *stack.top();
+        stack.pop();
+
+        if (shouldRender(node)) {
+            _static = false;
+            break;
+        }
+        for (auto &child : node.children()) {
+            stack.push(&*child);
+        }
+    }
+
+    return move(nodes);
+}
+
+void ModelInstance::extractStaticNodes(const ModelNode &node, const boost::dynamic_bitset<> &animatedNodes, bool animated, vector<const ModelNode *> &nodes) {
+    animated = animated || animatedNodes[node.index()];
+
+    if (!animated && isStaticMeshNode(node)) {
+        nodes.push_back(&node);
+        _staticNodes.set(node.index());
+    }
+    for (auto &child : node.children()) {
+        extractStaticNodes(*child, animatedNodes, animated, nodes);
+    }
+}
+
+bool ModelInstance::isStaticMeshNode(const ModelNode &node) const {
+    if (!shouldRender(node) || node.skin() || node.alpha() < 1.0f) return false;
+
+    shared_ptr<ModelMesh> mesh(node.mesh());
+
+    // Vertex data is only available before upload, unless kept by the model
+    return
+        !mesh->vertices().empty() &&
+        mesh->hasDiffuseTexture() &&
+        !mesh->isTransparent() &&
+        !mesh->hasEnvmapTexture() &&
+        !mesh->hasBumpyShinyTexture() &&
+        !mesh->hasBumpmapTexture();
 }
 
 glm::mat4 ModelInstance::getNodeTransform(const ModelNode &node) const {
     if (node.mesh() && node.skin()) {
         return node.absoluteTransform();
     }
-    auto it = _nodeTransforms.find(node.nodeNumber());
-
-    return it != _nodeTransforms.end() ? it->second : node.absoluteTransform();
+    return _nodeTransforms[node.index()];
 }
 
 void ModelInstance::initGL() {
@@ -302,57 +483,102 @@ void ModelInstance::render(const glm::mat4 &transform) const {
 
 void ModelInstance::render(const ModelNode &node, const glm::mat4 &transform, bool debug) const {
     shared_ptr<ModelMesh> mesh(node.mesh());
-    shared_ptr<ModelNode::Skin> skin(node.skin());
-    bool skeletal = skin && !_animState.name.empty();
-    ShaderProgram program = getShaderProgram(*mesh, skeletal);
+    bool skeletal = isSkeletal(node);
+    ShaderProgram program = getShaderProgram(*mesh, skeletal, false);
 
     ShaderManager &shaders = ShaderManager::instance();
     shaders.activate(program);
     shaders.setUniform("model", transform);
-    shaders.setUniform("color", glm::vec3(1.0f));
     shaders.setUniform("alpha", _alpha * node.alpha());
 
-    if (mesh->hasEnvmapTexture()) {
-        shaders.setUniform("envmap", 1);
-    }
-    if (mesh->hasLightmapTexture()) {
-        shaders.setUniform("lightmap", 2);
-    }
-    if (mesh->hasBumpyShinyTexture()) {
-        shaders.setUniform("bumpyShiny", 3);
+    setMeshUniforms(*mesh);
+
+    if (skeletal) {
+        shaders.setUniform("absTransform", node.absoluteTransform());
+        shaders.setUniform("absTransformInv", node.absoluteTransformInverse());
+
+        _bonePalette.clear();
+        getBoneTransforms(node, _bonePalette);
+
+        shaders.setUniform("bones", _bonePalette);
     }
-    if (mesh->hasBumpmapTexture()) {
-        shaders.setUniform("bumpmap", 4);
+
+    mesh->render(_textureOverride);
+
+    if (debug) {
+        AABBMesh::instance().render(mesh->aabb(), transform);
     }
+}
+
+void ModelInstance::renderInstanced(const ModelNode &node, const vector<InstanceData> &instances, const vector<glm::mat4> &bonePalette, bool debug) const {
+    shared_ptr<ModelMesh> mesh(node.mesh());
+    bool skeletal = isSkeletal(node);
+    ShaderProgram program = getShaderProgram(*mesh, skeletal, true);
+
+    ShaderManager &shaders = ShaderManager::instance();
+    shaders.activate(program);
+
+    setMeshUniforms(*mesh);
+
+    InstanceBuffer &instanceBuffer = InstanceBuffer::instance();
+    instanceBuffer.setInstances(instances);
 
     if (skeletal) {
         shaders.setUniform("absTransform", node.absoluteTransform());
         shaders.setUniform("absTransformInv", node.absoluteTransformInverse());
+        shaders.setUniform("bonePalette", 5);
 
-        const map<uint16_t, uint16_t> &nodeIdxByBoneIdx = skin->nodeIdxByBoneIdx;
-        vector<glm::mat4> bones(nodeIdxByBoneIdx.size(), glm::mat4(1.0f));
-
-        for (auto &pair : nodeIdxByBoneIdx) {
-            uint16_t boneIdx = pair.first;
-            uint16_t nodeIdx = pair.second;
+        instanceBuffer.setBonePalette(bonePalette);
+        instanceBuffer.bindBonePalette();
+    }
 
-            auto bone = _boneTransforms.find(nodeIdx);
-            if (bone == _boneTransforms.end()) continue;
+    mesh->renderInstanced(static_cast<int>(instances.size()), _textureOverride);
 
-            bones[boneIdx] = bone->second;
+    if (skeletal) {
+        instanceBuffer.unbindBonePalette();
+    }
+    if (debug) {
+        for (auto &instance : instances) {
+            AABBMesh::instance().render(mesh->aabb(), instance.transform);
         }
+    }
+}
+
+void ModelInstance::setMeshUniforms(const ModelMesh &mesh) const {
+    ShaderManager &shaders = ShaderManager::instance();
+    shaders.setUniform("color", glm::vec3(1.0f));
 
-        shaders.setUniform("bones", bones);
+    if (mesh.hasEnvmapTexture()) {
+        shaders.setUniform("envmap", 1);
+    }
+    if (mesh.hasLightmapTexture()) {
+        shaders.setUniform("lightmap", 2);
+    }
+    if (mesh.hasBumpyShinyTexture()) {
+        shaders.setUniform("bumpyShiny", 3);
+    }
+    if (mesh.hasBumpmapTexture()) {
+        shaders.setUniform("bumpmap", 4);
     }
+}
 
-    mesh->render(_textureOverride);
+bool ModelInstance::isSkeletal(const ModelNode &node) const {
+    return node.skin() && !_animState.name.empty();
+}
 
-    if (debug) {
-        AABBMesh::instance().render(mesh->aabb(), transform);
+void ModelInstance::getBoneTransforms(const ModelNode &node, vector<glm::mat4> &bones) const {
+    const vector<uint16_t> &nodeIdxByBoneIdx = node.skin()->nodeIdxByBoneIdx;
+    size_t boneCount = nodeIdxByBoneIdx.size();
+    size_t offset = bones.size();
+    bones.resize(offset + boneCount);
+
+    for (size_t i = 0; i < boneCount; ++i) {
+        uint16_t nodeIdx = nodeIdxByBoneIdx[i];
+        bones[offset + i] = nodeIdx < _boneTransforms.size() ? _boneTransforms[nodeIdx] : glm::mat4(1.0f);
     }
 }
 
-ShaderProgram ModelInstance::getShaderProgram(const ModelMesh &mesh, bool skeletal) const {
+ShaderProgram ModelInstance::getShaderProgram(const ModelMesh &mesh, bool skeletal, bool instanced) const {
     ShaderProgram program = ShaderProgram::None;
 
     bool hasEnvmap = mesh.hasEnvmapTexture();
@@ -386,6 +612,9 @@ ShaderProgram ModelInstance::getShaderProgram(const ModelMesh &mesh, bool skelet
         }
     }
 
+    if (instanced) {
+        program = getInstancedShaderProgram(program);
+    }
     if (program == ShaderProgram::None) {
         throw logic_error("Shader program not selected");
     }
@@ -421,6 +650,11 @@ void ModelInstance::setAlpha(float alpha) {
     }
 }
 
+void ModelInstance::setAnimationLOD(AnimationLOD lod, int reducedRate) {
+    _animLod = lod;
+    _animLodRate = reducedRate;
+}
+
 void ModelInstance::setDefaultAnimation(const string &name) {
     _defaultAnimation = name;
 }
@@ -455,6 +689,22 @@ bool ModelInstance::visible() const {
     return _visible;
 }
 
+bool ModelInstance::isStatic() const {
+    return _static;
+}
+
+AnimationLOD ModelInstance::animationLOD() const {
+    return _animLod;
+}
+
+float ModelInstance::alpha() const {
+    return _alpha;
+}
+
+const shared_ptr<Texture> &ModelInstance::textureOverride() const {
+    return _textureOverride;
+}
+
 } // namespace render
 
 } // namespace reone
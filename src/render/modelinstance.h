@@ -17,9 +17,10 @@
 
 #pragma once
 
-#include <set>
+#include <boost/dynamic_bitset.hpp>
 
 #include "aabb.h"
+#include "instancebuffer.h"
 #include "model.h"
 #include "renderlist.h"
 #include "shaders.h"
@@ -44,26 +45,62 @@ public:
     void render(const glm::mat4 &transform) const;
     void render(const ModelNode &node, const glm::mat4 &transform, bool debug) const;
 
+    /**
+     * Renders a mesh node of this model once per instance. All instances must
+     * share the node, texture override and skinning state of this model.
+     *
+     * @param bonePalette bone matrices of skinned instances, addressed by InstanceData::bonesOffset
+     */
+    void renderInstanced(const ModelNode &node, const std::vector<InstanceData> &instances, const std::vector<glm::mat4> &bonePalette, bool debug) const;
+
     void animate(const std::string &parent, const std::string &anim, int flags = 0, float speed = 1.0f);
     void animate(const std::string &anim, int flags = 0, float speed = 1.0f);
     void attach(const std::string &parentNode, const std::shared_ptr<Model> &model);
     void changeTexture(const std::string &resRef);
     void update(float dt);
-    void fillRenderLists(const glm::mat4 &transform, RenderList &opaque, RenderList &transparent);
+    void fillRenderLists(const glm::mat4 &transform, RenderQueue &queue) const;
     void playDefaultAnimation();
 
     void show();
     void hide();
 
     void setAlpha(float alpha);
+
+    /**
+     * @param reducedRate animation is advanced every Nth update when LOD is Reduced
+     */
+    void setAnimationLOD(AnimationLOD lod, int reducedRate = 1);
     void setDefaultAnimation(const std::string &name);
 
     glm::vec3 getNodeAbsolutePosition(const std::string &name) const;
+    glm::mat4 getNodeTransform(const ModelNode &node) const;
+
+    /**
+     * Excludes opaque mesh nodes, that are not affected by the current
+     * animation, from rendering and returns them, so that they could be
+     * rendered as static geometry.
+     */
+    std::vector<const ModelNode *> extractStaticNodes();
+
+    bool isSkeletal(const ModelNode &node) const;
+
+    /**
+     * Appends bone matrices of the skinned node to the specified vector.
+     */
+    void getBoneTransforms(const ModelNode &node, std::vector<glm::mat4> &bones) const;
 
     const std::string &name() const;
     std::shared_ptr<Model> model() const;
     bool visible() const;
 
+    /**
+     * @return true if all mesh nodes of this model instance were extracted as static geometry
+     */
+    bool isStatic() const;
+    AnimationLOD animationLOD() const;
+    float alpha() const;
+    const std::shared_ptr<Texture> &textureOverride() const;
+
 private:
     struct AnimationState {
         std::string nextAnimation;
@@ -75,12 +112,21 @@ private:
         std::shared_ptr<Animation> animation;
         const Model *model { nullptr };
         float time { 0.0f };
-        std::map<std::string, glm::mat4> localTransforms;
+        const std::vector<AnimationChannel> *channels { nullptr };
+        std::vector<ModelNode::KeyframeCursor> cursors; /**< indexed by channel */
+        std::vector<glm::mat4> localTransforms; /**< indexed by node index */
+        std::vector<glm::mat4> prevLocalTransforms; /**< previous sample, indexed by node index */
+        boost::dynamic_bitset<> animatedNodes; /**< indexed by node index */
+        boost::dynamic_bitset<> prevAnimatedNodes; /**< previous sample, indexed by node index */
     };
 
     std::shared_ptr<Model> _model;
-    std::map<uint16_t, glm::mat4> _nodeTransforms;
-    std::map<uint16_t, glm::mat4> _boneTransforms;
+    std::vector<glm::mat4> _nodeTransforms; /**< indexed by node index */
+    std::vector<glm::mat4> _boneTransforms; /**< indexed by node index */
+    mutable std::vector<glm::mat4> _bonePalette; /**< scratch bone matrices of the mesh being rendered */
+    boost::dynamic_bitset<> _skipNodes; /**< nodes animated by the parent model, indexed by node index */
+    boost::dynamic_bitset<> _staticNodes; /**< nodes rendered as static geometry, indexed by node index */
+    bool _static { false };
     AnimationState _animState;
     std::map<uint16_t, std::unique_ptr<ModelInstance>> _attachedModels;
     std::shared_ptr<Texture> _textureOverride;
@@ -88,16 +134,26 @@ private:
     bool _visible { true };
     float _alpha { 1.0f };
     bool _drawAABB { false };
-
-    void doUpdate(float dt, const std::set<std::string> &skipNodes);
+    AnimationLOD _animLod { AnimationLOD::Full };
+    int _animLodRate { 1 };
+    int _animLodFrame { 0 };
+    float _animLodDeltaTime { 0.0f };
+    float _animLodPeriod { 0.0f }; /**< time between the last two reduced rate samples */
+
+    void initNodeTransforms(const ModelNode &node);
+    void initSkipNodes(const ModelNode &parentNode);
+    void doUpdate(float dt, float blend = 1.0f);
+    void interpolateAnimation(float blend);
     void startNextAnimation();
-    void advanceAnimation(float dt, const std::set<std::string> &skipNodes);
-    void updateAnimTransforms(const ModelNode &animNode, const glm::mat4 &transform, float time, const std::set<std::string> &skipNodes);
-    void updateNodeTansforms(const ModelNode &node, const glm::mat4 &transform);
-    void fillRenderLists(const ModelNode &node, const glm::mat4 &transform, RenderList &opaque, RenderList &transparent);
+    void advanceAnimation(float dt);
+    void updateAnimTransforms();
+    void updateNodeTansforms(const ModelNode &node, const glm::mat4 &transform, float blend = 1.0f);
+    void fillRenderLists(const ModelNode &node, const glm::mat4 &transform, RenderQueue &queue) const;
     bool shouldRender(const ModelNode &node) const;
-    glm::mat4 getNodeTransform(const ModelNode &node) const;
-    ShaderProgram getShaderProgram(const ModelMesh &mesh, bool skeletal) const;
+    bool isStaticMeshNode(const ModelNode &node) const;
+    void extractStaticNodes(const ModelNode &node, const boost::dynamic_bitset<> &animatedNodes, bool animated, std::vector<const ModelNode *> &nodes);
+    void setMeshUniforms(const ModelMesh &mesh) const;
+    ShaderProgram getShaderProgram(const ModelMesh &mesh, bool skeletal, bool instanced) const;
 };
 
 } // namespace render
@@ -17,12 +17,16 @@
 
 #include "modelnode.h"
 
+#include <algorithm>
+
 using namespace std;
 
 namespace reone {
 
 namespace render {
 
+static const int kMaxCursorSteps = 2;
+
 ModelNode::ModelNode(int index, const ModelNode *parent) : _index(index), _parent(parent) {
 }
 
@@ -35,58 +39,78 @@ void ModelNode::initGL() {
     }
 }
 
+/**
+ * @return index of the first keyframe whose time is not less than the specified time, or the number of keyframes
+ */
+static int findKeyframe(const vector<float> &times, float time, int &cursor) {
+    int count = static_cast<int>(times.size());
+    int idx = glm::clamp(cursor, 0, count);
+
+    // When playing forward, the keyframe is usually at or right after the cursor
+    for (int i = 0; i < kMaxCursorSteps && idx < count && times[idx] < time; ++i) {
+        ++idx;
+    }
+    bool found = (idx == count || times[idx] >= time) && (idx == 0 || times[idx - 1] < time);
+    if (!found) {
+        idx = static_cast<int>(distance(times.begin(), lower_bound(times.begin(), times.end(), time)));
+    }
+    cursor = idx;
+
+    return idx;
+}
+
 bool ModelNode::getPosition(float time, glm::vec3 &position, float scale) const {
-    if (_positionFrames.empty()) return false;
+    KeyframeCursor cursor;
+    return getPosition(time, cursor, position, scale);
+}
 
-    const PositionKeyframe *left = &_positionFrames.front();
-    const PositionKeyframe *right = left;
+bool ModelNode::getPosition(float time, KeyframeCursor &cursor, glm::vec3 &position, float scale) const {
+    if (_positionTimes.empty()) return false;
 
-    for (auto it = _positionFrames.begin(); it != _positionFrames.end(); ++it) {
-        if (it->time >= time) {
-            right = &*it;
-            if (it != _positionFrames.begin()) left = &*(it - 1);
-            break;
-        }
-    }
+    int count = static_cast<int>(_positionTimes.size());
+    int right = findKeyframe(_positionTimes, time, cursor.position);
 
-    if (left == right) {
-        position = left->position * scale;
+    if (right == 0 || right == count) {
+        position = _positions[right == 0 ? 0 : count - 1] * scale;
         return true;
     }
 
-    float factor = (time - left->time) / (right->time - left->time);
+    int left = right - 1;
+    float factor = (time - _positionTimes[left]) / (_positionTimes[right] - _positionTimes[left]);
 
-    position = glm::mix(left->position, right->position, factor) * scale;
+    position = glm::mix(_positions[left], _positions[right], factor) * scale;
 
     return true;
 }
 
 bool ModelNode::getOrientation(float time, glm::quat &orientation) const {
-    if (_orientationFrames.empty()) return false;
+    KeyframeCursor cursor;
+    return getOrientation(time, cursor, orientation);
+}
 
-    const OrientationKeyframe *left = &_orientationFrames.front();
-    const OrientationKeyframe *right = left;
+bool ModelNode::getOrientation(float time, KeyframeCursor &cursor, glm::quat &orientation) const {
+    if (_orientationTimes.empty()) return false;
 
-    for (auto it = _orientationFrames.begin(); it != _orientationFrames.end(); ++it) {
-        if (it->time >= time) {
-            right = &*it;
-            if (it != _orientationFrames.begin()) left = &*(it - 1);
-            break;
-        }
-    }
+    int count = static_cast<int>(_orientationTimes.size());
+    int right = findKeyframe(_orientationTimes, time, cursor.orientation);
 
-    if (left == right) {
-        orientation = left->orientation;
+    if (right == 0 || right == count) {
+        orientation = _orientations[right == 0 ? 0 : count - 1];
         return true;
     }
 
-    float factor = (time - left->time) / (right->time - left->time);
+    int left = right - 1;
+    float factor = (time - _orientationTimes[left]) / (_orientationTimes[right] - _orientationTimes[left]);
 
-    orientation = glm::slerp(left->orientation, right->orientation, factor);
+    orientation = glm::slerp(_orientations[left], _orientations[right], factor);
 
     return true;
 }
 
+bool ModelNode::isAnimated() const {
+    return _positionTimes.size() > 1 || _orientationTimes.size() > 1;
+}
+
 int ModelNode::index() const {
     return _index;
 }
@@ -45,8 +45,17 @@ public:
         bool affectDynamic { false };
     };
 
+    /**
+     * Indices of the last sampled keyframes, kept by the caller between
+     * samples to make sequential playback O(1).
+     */
+    struct KeyframeCursor {
+        int position { 0 };
+        int orientation { 0 };
+    };
+
     struct Skin {
-        std::map<uint16_t, uint16_t> nodeIdxByBoneIdx;
+        std::vector<uint16_t> nodeIdxByBoneIdx; /**< node index per bone index, 0xffff if unused */
     };
 
     ModelNode(int index, const ModelNode *parent = nullptr);
@@ -54,7 +63,14 @@ public:
     void initGL();
 
     bool getPosition(float time, glm::vec3 &position, float scale = 1.0f) const;
+    bool getPosition(float time, KeyframeCursor &cursor, glm::vec3 &position, float scale = 1.0f) const;
     bool getOrientation(float time, glm::quat &orientation) const;
+    bool getOrientation(float time, KeyframeCursor &cursor, glm::quat &orientation) const;
+
+    /**
+     * @return true if position or orientation of this animation node changes over time
+     */
+    bool isAnimated() const;
 
     int index() const;
     const ModelNode *parent() const;
@@ -74,16 +90,6 @@ public:
     const std::vector<std::shared_ptr<ModelNode>> &children() const;
 
 private:
-    struct PositionKeyframe {
-        float time { 0.0f };
-        glm::vec3 position { 0.0f };
-    };
-
-    struct OrientationKeyframe {
-        float time { 0.0f };
-        glm::quat orientation { 1.0f, 0.0f, 0.0f, 0.0f };
-    };
-
     int _index { 0 };
     const ModelNode *_parent { nullptr };
     uint16_t _nodeNumber { 0 };
@@ -92,8 +98,10 @@ private:
     glm::quat _orientation { 1.0f, 0.0f, 0.0f, 0.0f };
     glm::mat4 _absTransform { 1.0f };
     glm::mat4 _absTransformInv { 1.0f };
-    std::vector<PositionKeyframe> _positionFrames;
-    std::vector<OrientationKeyframe> _orientationFrames;
+    std::vector<float> _positionTimes;
+    std::vector<glm::vec3> _positions;
+    std::vector<float> _orientationTimes;
+    std::vector<glm::quat> _orientations;
     glm::vec3 _color { 0.0f };
     float _alpha { 1.0f };
     float _radius { 0.0f };
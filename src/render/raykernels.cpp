@@ -0,0 +1,321 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "raykernels.h"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(REONE_RAY_KERNELS_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "glm/geometric.hpp"
+
+#include "../core/log.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const float kDeterminantEpsilon = numeric_limits<float>::epsilon();
+
+// Implemented in raykernels_sse.cpp and raykernels_avx2.cpp
+
+bool intersectRayTrianglesSSE(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit);
+void intersectRaysTrianglesSSE(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits);
+int intersectRayBoxesSSE(const Ray &ray, const AABBBatch &boxes, int *indices);
+bool intersectRayTrianglesAVX2(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit);
+void intersectRaysTrianglesAVX2(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits);
+int intersectRayBoxesAVX2(const Ray &ray, const AABBBatch &boxes, int *indices);
+
+typedef bool (*IntersectRayTrianglesFunc)(const Ray &, const TriangleBatch &, int, int, RayHit &);
+typedef void (*IntersectRaysTrianglesFunc)(const Ray *, int, const TriangleBatch &, RayHit *);
+typedef int (*IntersectRayBoxesFunc)(const Ray &, const AABBBatch &, int *);
+
+template <class T>
+static void appendPadded(vector<T> &arr, int index, T value) {
+    if (index % kRayKernelBatchAlignment == 0) {
+        arr.resize(index + kRayKernelBatchAlignment, T());
+    }
+    arr[index] = value;
+}
+
+void TriangleBatch::add(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2) {
+    glm::vec3 edge1(p1 - p0);
+    glm::vec3 edge2(p2 - p0);
+
+    // Padding has zero edges, so that it never intersects anything
+
+    appendPadded(v0x, count, p0.x);
+    appendPadded(v0y, count, p0.y);
+    appendPadded(v0z, count, p0.z);
+    appendPadded(e1x, count, edge1.x);
+    appendPadded(e1y, count, edge1.y);
+    appendPadded(e1z, count, edge1.z);
+    appendPadded(e2x, count, edge2.x);
+    appendPadded(e2y, count, edge2.y);
+    appendPadded(e2z, count, edge2.z);
+
+    ++count;
+}
+
+void TriangleBatch::clear() {
+    count = 0;
+
+    for (auto arr : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z }) {
+        arr->clear();
+    }
+}
+
+void AABBBatch::add(const AABB &aabb) {
+    const glm::vec3 &min = aabb.min();
+    const glm::vec3 &max = aabb.max();
+
+    appendPadded(minX, count, min.x);
+    appendPadded(minY, count, min.y);
+    appendPadded(minZ, count, min.z);
+    appendPadded(maxX, count, max.x);
+    appendPadded(maxY, count, max.y);
+    appendPadded(maxZ, count, max.z);
+
+    ++count;
+}
+
+void AABBBatch::clear() {
+    count = 0;
+
+    for (auto arr : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ }) {
+        arr->clear();
+    }
+}
+
+static bool intersectRayTrianglesScalar(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit) {
+    float nearest = numeric_limits<float>::infinity();
+    int nearestIdx = -1;
+
+    for (int i = begin; i < end; ++i) {
+        glm::vec3 v0(triangles.v0x[i], triangles.v0y[i], triangles.v0z[i]);
+        glm::vec3 edge1(triangles.e1x[i], triangles.e1y[i], triangles.e1z[i]);
+        glm::vec3 edge2(triangles.e2x[i], triangles.e2y[i], triangles.e2z[i]);
+
+        glm::vec3 p(glm::cross(ray.dir, edge2));
+        float det = glm::dot(edge1, p);
+        if (fabs(det) <= kDeterminantEpsilon) continue;
+
+        float invDet = 1.0f / det;
+        glm::vec3 s(ray.origin - v0);
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) continue;
+
+        glm::vec3 q(glm::cross(s, edge1));
+        float v = glm::dot(ray.dir, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) continue;
+
+        float distance = glm::dot(edge2, q) * invDet;
+        if (distance < ray.minDistance || distance > ray.maxDistance || distance >= nearest) continue;
+
+        nearest = distance;
+        nearestIdx = i;
+    }
+
+    if (nearestIdx == -1) return false;
+
+    hit.index = nearestIdx;
+    hit.distance = nearest;
+
+    return true;
+}
+
+static void intersectRaysTrianglesScalar(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits) {
+    for (int i = 0; i < rayCount; ++i) {
+        if (!intersectRayTrianglesScalar(rays[i], triangles, 0, triangles.count, hits[i])) {
+            hits[i] = RayHit();
+        }
+    }
+}
+
+static int intersectRayBoxesScalar(const Ray &ray, const AABBBatch &boxes, int *indices) {
+    glm::vec3 invDir(getSafeInverse(ray.dir.x), getSafeInverse(ray.dir.y), getSafeInverse(ray.dir.z));
+    int count = 0;
+
+    for (int i = 0; i < boxes.count; ++i) {
+        glm::vec3 t1((glm::vec3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]) - ray.origin) * invDir);
+        glm::vec3 t2((glm::vec3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]) - ray.origin) * invDir);
+
+        float entry = ray.minDistance;
+        float exit = ray.maxDistance;
+        for (int j = 0; j < 3; ++j) {
+            float near = t1[j] < t2[j] ? t1[j] : t2[j];
+            float far = t1[j] < t2[j] ? t2[j] : t1[j];
+            if (near > entry) entry = near;
+            if (far < exit) exit = far;
+        }
+        if (entry <= exit) {
+            indices[count++] = i;
+        }
+    }
+
+    return count;
+}
+
+static bool isSSESupported() {
+#ifdef REONE_RAY_KERNELS_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+#else
+    return false;
+#endif
+}
+
+static bool isAVX2Supported() {
+#ifdef REONE_RAY_KERNELS_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+
+    // Operating system must preserve YMM registers
+    if ((_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+static RayKernelSet getWidestRayKernelSet() {
+    RayKernelSet set = RayKernelSet::Scalar;
+    if (isAVX2Supported()) {
+        set = RayKernelSet::AVX2;
+    } else if (isSSESupported()) {
+        set = RayKernelSet::SSE;
+    }
+    return set;
+}
+
+static atomic<RayKernelSet> g_rayKernelSet { getWidestRayKernelSet() };
+static atomic<IntersectRayTrianglesFunc> g_intersectRayTriangles { nullptr };
+static atomic<IntersectRaysTrianglesFunc> g_intersectRaysTriangles { nullptr };
+static atomic<IntersectRayBoxesFunc> g_intersectRayBoxes { nullptr };
+
+static void selectRayKernels(RayKernelSet set) {
+    switch (set) {
+#ifdef REONE_RAY_KERNELS_X86
+        case RayKernelSet::AVX2:
+            g_intersectRayTriangles = &intersectRayTrianglesAVX2;
+            g_intersectRaysTriangles = &intersectRaysTrianglesAVX2;
+            g_intersectRayBoxes = &intersectRayBoxesAVX2;
+            break;
+        case RayKernelSet::SSE:
+            g_intersectRayTriangles = &intersectRayTrianglesSSE;
+            g_intersectRaysTriangles = &intersectRaysTrianglesSSE;
+            g_intersectRayBoxes = &intersectRayBoxesSSE;
+            break;
+#endif
+        default:
+            g_intersectRayTriangles = &intersectRayTrianglesScalar;
+            g_intersectRaysTriangles = &intersectRaysTrianglesScalar;
+            g_intersectRayBoxes = &intersectRayBoxesScalar;
+            break;
+    }
+    g_rayKernelSet = set;
+}
+
+static IntersectRayTrianglesFunc getIntersectRayTrianglesFunc() {
+    IntersectRayTrianglesFunc func = g_intersectRayTriangles.load(memory_order_relaxed);
+    if (!func) {
+        selectRayKernels(g_rayKernelSet);
+        func = g_intersectRayTriangles;
+    }
+    return func;
+}
+
+static IntersectRaysTrianglesFunc getIntersectRaysTrianglesFunc() {
+    IntersectRaysTrianglesFunc func = g_intersectRaysTriangles.load(memory_order_relaxed);
+    if (!func) {
+        selectRayKernels(g_rayKernelSet);
+        func = g_intersectRaysTriangles;
+    }
+    return func;
+}
+
+static IntersectRayBoxesFunc getIntersectRayBoxesFunc() {
+    IntersectRayBoxesFunc func = g_intersectRayBoxes.load(memory_order_relaxed);
+    if (!func) {
+        selectRayKernels(g_rayKernelSet);
+        func = g_intersectRayBoxes;
+    }
+    return func;
+}
+
+RayKernelSet getRayKernelSet() {
+    return g_rayKernelSet;
+}
+
+bool setRayKernelSet(RayKernelSet set) {
+    if ((set == RayKernelSet::AVX2 && !isAVX2Supported()) ||
+        (set == RayKernelSet::SSE && !isSSESupported())) {
+
+        warn("Ray kernels: instruction set not supported: " + to_string(static_cast<int>(set)));
+        return false;
+    }
+    selectRayKernels(set);
+
+    return true;
+}
+
+bool intersectRayTriangles(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit) {
+    if (begin >= end) return false;
+
+    return getIntersectRayTrianglesFunc()(ray, triangles, begin, end, hit);
+}
+
+void intersectRaysTriangles(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits) {
+    if (rayCount <= 0) return;
+
+    getIntersectRaysTrianglesFunc()(rays, rayCount, triangles, hits);
+}
+
+int intersectRayBoxes(const Ray &ray, const AABBBatch &boxes, int *indices) {
+    if (boxes.count == 0) return 0;
+
+    return getIntersectRayBoxesFunc()(ray, boxes, indices);
+}
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,138 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+#include "aabb.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define REONE_RAY_KERNELS_X86
+#endif
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Number of elements that batch arrays are padded to a multiple of. Equals
+ * the widest SIMD register, in floats.
+ */
+static const int kRayKernelBatchAlignment = 8;
+
+/**
+ * Triangles in structure of arrays layout. Every triangle is stored as its
+ * first vertex and two edges.
+ */
+struct TriangleBatch {
+    int count { 0 };
+    std::vector<float> v0x, v0y, v0z;
+    std::vector<float> e1x, e1y, e1z;
+    std::vector<float> e2x, e2y, e2z;
+
+    void add(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2);
+    void clear();
+};
+
+/**
+ * Axis-aligned boxes in structure of arrays layout.
+ */
+struct AABBBatch {
+    int count { 0 };
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void add(const AABB &aabb);
+    void clear();
+};
+
+/**
+ * Ray or line segment, as in origin + dir * distance, where distance is
+ * within [minDistance, maxDistance]. Direction need not be normalized.
+ */
+struct Ray {
+    glm::vec3 origin { 0.0f };
+    glm::vec3 dir { 0.0f };
+    float minDistance { 0.0f };
+    float maxDistance { std::numeric_limits<float>::max() };
+};
+
+struct RayHit {
+    int index { -1 }; /**< index of the nearest triangle, or -1 */
+    float distance { 0.0f };
+};
+
+/**
+ * @return reciprocal of value, which is finite even if value is zero, so that
+ *         multiplying it by zero does not produce NaN
+ */
+inline float getSafeInverse(float value) {
+    return 1.0f / (value != 0.0f ? value : std::numeric_limits<float>::min());
+}
+
+enum class RayKernelSet {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+/**
+ * @return instruction set used by the ray kernels, which is the widest one
+ *         supported by the CPU, unless overridden
+ */
+RayKernelSet getRayKernelSet();
+
+/**
+ * Overrides the instruction set used by the ray kernels, e.g. for
+ * benchmarking.
+ *
+ * @return false if the instruction set is not supported by the CPU
+ */
+bool setRayKernelSet(RayKernelSet set);
+
+/**
+ * Finds the nearest triangle with index in [begin, end), intersected by the
+ * ray. Both sides of triangles are tested.
+ *
+ * @return true if an intersection was found, false otherwise
+ */
+bool intersectRayTriangles(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit);
+
+/**
+ * For every ray, finds the nearest intersected triangle of the batch. Rays
+ * are tested in packets, one ray per SIMD lane, so that each triangle is
+ * loaded once per packet. Rays without an intersection get a default hit.
+ */
+void intersectRaysTriangles(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits);
+
+/**
+ * Finds boxes of the batch, intersected by the ray. Indices of boxes are
+ * written in ascending order.
+ *
+ * @param indices array with room for an index of every box in the batch
+ * @return number of intersected boxes
+ */
+int intersectRayBoxes(const Ray &ray, const AABBBatch &boxes, int *indices);
+
+} // namespace render
+
+} // namespace reone
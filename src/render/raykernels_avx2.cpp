@@ -0,0 +1,269 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "raykernels.h"
+
+#ifdef REONE_RAY_KERNELS_X86
+
+#include <algorithm>
+
+#include <immintrin.h>
+
+// Only functions in this file are compiled for AVX2, so that the rest of the
+// program runs on CPUs without it. They are called after a runtime check.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define REONE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define REONE_TARGET_AVX2
+#endif
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+REONE_TARGET_AVX2
+static inline __m256 dot(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+REONE_TARGET_AVX2
+bool intersectRayTrianglesAVX2(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit) {
+    const __m256 ox = _mm256_set1_ps(ray.origin.x);
+    const __m256 oy = _mm256_set1_ps(ray.origin.y);
+    const __m256 oz = _mm256_set1_ps(ray.origin.z);
+    const __m256 dx = _mm256_set1_ps(ray.dir.x);
+    const __m256 dy = _mm256_set1_ps(ray.dir.y);
+    const __m256 dz = _mm256_set1_ps(ray.dir.z);
+    const __m256 minDistance = _mm256_set1_ps(ray.minDistance);
+    const __m256 maxDistance = _mm256_set1_ps(ray.maxDistance);
+    const __m256 epsilon = _mm256_set1_ps(numeric_limits<float>::epsilon());
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i beginIdx = _mm256_set1_epi32(begin - 1);
+    const __m256i endIdx = _mm256_set1_epi32(end);
+
+    __m256 nearest = _mm256_set1_ps(numeric_limits<float>::infinity());
+    __m256i nearestIdx = _mm256_set1_epi32(-1);
+
+    // Start at an aligned index, so that loads never cross the padded end
+
+    for (int i = begin & ~7; i < end; i += 8) {
+        __m256 v0x = _mm256_loadu_ps(&triangles.v0x[i]);
+        __m256 v0y = _mm256_loadu_ps(&triangles.v0y[i]);
+        __m256 v0z = _mm256_loadu_ps(&triangles.v0z[i]);
+        __m256 e1x = _mm256_loadu_ps(&triangles.e1x[i]);
+        __m256 e1y = _mm256_loadu_ps(&triangles.e1y[i]);
+        __m256 e1z = _mm256_loadu_ps(&triangles.e1z[i]);
+        __m256 e2x = _mm256_loadu_ps(&triangles.e2x[i]);
+        __m256 e2y = _mm256_loadu_ps(&triangles.e2y[i]);
+        __m256 e2z = _mm256_loadu_ps(&triangles.e2z[i]);
+
+        // p = cross(dir, edge2)
+        __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+        __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+        __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+        __m256 det = dot(e1x, e1y, e1z, px, py, pz);
+        __m256 mask = _mm256_cmp_ps(_mm256_and_ps(det, absMask), epsilon, _CMP_GT_OQ);
+        __m256 invDet = _mm256_div_ps(one, det);
+
+        // s = origin - v0
+        __m256 sx = _mm256_sub_ps(ox, v0x);
+        __m256 sy = _mm256_sub_ps(oy, v0y);
+        __m256 sz = _mm256_sub_ps(oz, v0z);
+
+        __m256 u = _mm256_mul_ps(dot(sx, sy, sz, px, py, pz), invDet);
+        mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+
+        // q = cross(s, edge1)
+        __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+        __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+        __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+        __m256 v = _mm256_mul_ps(dot(dx, dy, dz, qx, qy, qz), invDet);
+        mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+
+        __m256 distance = _mm256_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), invDet);
+        mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(distance, minDistance, _CMP_GE_OQ), _mm256_cmp_ps(distance, maxDistance, _CMP_LE_OQ)));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(distance, nearest, _CMP_LT_OQ));
+
+        __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(i), lanes);
+        __m256i idxMask = _mm256_and_si256(_mm256_cmpgt_epi32(idx, beginIdx), _mm256_cmpgt_epi32(endIdx, idx));
+        mask = _mm256_and_ps(mask, _mm256_castsi256_ps(idxMask));
+
+        nearest = _mm256_blendv_ps(nearest, distance, mask);
+        nearestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(nearestIdx), _mm256_castsi256_ps(idx), mask));
+    }
+
+    alignas(32) float distances[8];
+    alignas(32) int indices[8];
+    _mm256_store_ps(distances, nearest);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(indices), nearestIdx);
+
+    int lane = -1;
+    for (int i = 0; i < 8; ++i) {
+        if (indices[i] == -1) continue;
+        if (lane == -1 || distances[i] < distances[lane] || (distances[i] == distances[lane] && indices[i] < indices[lane])) {
+            lane = i;
+        }
+    }
+    if (lane == -1) return false;
+
+    hit.index = indices[lane];
+    hit.distance = distances[lane];
+
+    return true;
+}
+
+REONE_TARGET_AVX2
+void intersectRaysTrianglesAVX2(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits) {
+    const __m256 epsilon = _mm256_set1_ps(numeric_limits<float>::epsilon());
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    // Rays are tested in packets of eight, one per lane, against every
+    // triangle in turn. A partial packet repeats its last ray.
+
+    for (int first = 0; first < rayCount; first += 8) {
+        alignas(32) float rayData[8][8];
+        for (int lane = 0; lane < 8; ++lane) {
+            const Ray &ray = rays[min(first + lane, rayCount - 1)];
+            rayData[0][lane] = ray.origin.x;
+            rayData[1][lane] = ray.origin.y;
+            rayData[2][lane] = ray.origin.z;
+            rayData[3][lane] = ray.dir.x;
+            rayData[4][lane] = ray.dir.y;
+            rayData[5][lane] = ray.dir.z;
+            rayData[6][lane] = ray.minDistance;
+            rayData[7][lane] = ray.maxDistance;
+        }
+        const __m256 ox = _mm256_load_ps(rayData[0]);
+        const __m256 oy = _mm256_load_ps(rayData[1]);
+        const __m256 oz = _mm256_load_ps(rayData[2]);
+        const __m256 dx = _mm256_load_ps(rayData[3]);
+        const __m256 dy = _mm256_load_ps(rayData[4]);
+        const __m256 dz = _mm256_load_ps(rayData[5]);
+        const __m256 minDistance = _mm256_load_ps(rayData[6]);
+        const __m256 maxDistance = _mm256_load_ps(rayData[7]);
+
+        __m256 nearest = _mm256_set1_ps(numeric_limits<float>::infinity());
+        __m256i nearestIdx = _mm256_set1_epi32(-1);
+
+        for (int i = 0; i < triangles.count; ++i) {
+            __m256 e1x = _mm256_set1_ps(triangles.e1x[i]);
+            __m256 e1y = _mm256_set1_ps(triangles.e1y[i]);
+            __m256 e1z = _mm256_set1_ps(triangles.e1z[i]);
+            __m256 e2x = _mm256_set1_ps(triangles.e2x[i]);
+            __m256 e2y = _mm256_set1_ps(triangles.e2y[i]);
+            __m256 e2z = _mm256_set1_ps(triangles.e2z[i]);
+
+            // p = cross(dir, edge2)
+            __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+            __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+            __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+            __m256 det = dot(e1x, e1y, e1z, px, py, pz);
+            __m256 mask = _mm256_cmp_ps(_mm256_and_ps(det, absMask), epsilon, _CMP_GT_OQ);
+            __m256 invDet = _mm256_div_ps(one, det);
+
+            // s = origin - v0
+            __m256 sx = _mm256_sub_ps(ox, _mm256_set1_ps(triangles.v0x[i]));
+            __m256 sy = _mm256_sub_ps(oy, _mm256_set1_ps(triangles.v0y[i]));
+            __m256 sz = _mm256_sub_ps(oz, _mm256_set1_ps(triangles.v0z[i]));
+
+            __m256 u = _mm256_mul_ps(dot(sx, sy, sz, px, py, pz), invDet);
+            mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+            if (_mm256_movemask_ps(mask) == 0) continue;
+
+            // q = cross(s, edge1)
+            __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+            __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+            __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+            __m256 v = _mm256_mul_ps(dot(dx, dy, dz, qx, qy, qz), invDet);
+            mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+
+            __m256 distance = _mm256_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), invDet);
+            mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(distance, minDistance, _CMP_GE_OQ), _mm256_cmp_ps(distance, maxDistance, _CMP_LE_OQ)));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(distance, nearest, _CMP_LT_OQ));
+
+            nearest = _mm256_blendv_ps(nearest, distance, mask);
+            nearestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(nearestIdx), _mm256_castsi256_ps(_mm256_set1_epi32(i)), mask));
+        }
+
+        alignas(32) float distances[8];
+        alignas(32) int indices[8];
+        _mm256_store_ps(distances, nearest);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(indices), nearestIdx);
+
+        for (int lane = 0; lane < 8 && first + lane < rayCount; ++lane) {
+            RayHit &hit = hits[first + lane];
+            hit = RayHit();
+            if (indices[lane] == -1) continue;
+
+            hit.index = indices[lane];
+            hit.distance = distances[lane];
+        }
+    }
+}
+
+REONE_TARGET_AVX2
+int intersectRayBoxesAVX2(const Ray &ray, const AABBBatch &boxes, int *indices) {
+    const __m256 ox = _mm256_set1_ps(ray.origin.x);
+    const __m256 oy = _mm256_set1_ps(ray.origin.y);
+    const __m256 oz = _mm256_set1_ps(ray.origin.z);
+    const __m256 invDx = _mm256_set1_ps(getSafeInverse(ray.dir.x));
+    const __m256 invDy = _mm256_set1_ps(getSafeInverse(ray.dir.y));
+    const __m256 invDz = _mm256_set1_ps(getSafeInverse(ray.dir.z));
+    const __m256 minDistance = _mm256_set1_ps(ray.minDistance);
+    const __m256 maxDistance = _mm256_set1_ps(ray.maxDistance);
+
+    int count = 0;
+
+    for (int i = 0; i < boxes.count; i += 8) {
+        __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.minX[i]), ox), invDx);
+        __m256 t2x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.maxX[i]), ox), invDx);
+        __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.minY[i]), oy), invDy);
+        __m256 t2y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.maxY[i]), oy), invDy);
+        __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.minZ[i]), oz), invDz);
+        __m256 t2z = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes.maxZ[i]), oz), invDz);
+
+        __m256 entry = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t1x, t2x), _mm256_min_ps(t1y, t2y)), _mm256_max_ps(_mm256_min_ps(t1z, t2z), minDistance));
+        __m256 exit = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t1x, t2x), _mm256_max_ps(t1y, t2y)), _mm256_min_ps(_mm256_max_ps(t1z, t2z), maxDistance));
+
+        int hits = _mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ));
+        for (int j = 0; hits != 0 && j < 8; ++j, hits >>= 1) {
+            if ((hits & 1) && i + j < boxes.count) {
+                indices[count++] = i + j;
+            }
+        }
+    }
+
+    return count;
+}
+
+} // namespace render
+
+} // namespace reone
+
+#endif
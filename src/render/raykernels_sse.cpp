@@ -0,0 +1,260 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "raykernels.h"
+
+#ifdef REONE_RAY_KERNELS_X86
+
+#include <algorithm>
+
+#include <emmintrin.h>
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static inline __m128 selectMask(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128i selectMask(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+bool intersectRayTrianglesSSE(const Ray &ray, const TriangleBatch &triangles, int begin, int end, RayHit &hit) {
+    const __m128 ox = _mm_set1_ps(ray.origin.x);
+    const __m128 oy = _mm_set1_ps(ray.origin.y);
+    const __m128 oz = _mm_set1_ps(ray.origin.z);
+    const __m128 dx = _mm_set1_ps(ray.dir.x);
+    const __m128 dy = _mm_set1_ps(ray.dir.y);
+    const __m128 dz = _mm_set1_ps(ray.dir.z);
+    const __m128 minDistance = _mm_set1_ps(ray.minDistance);
+    const __m128 maxDistance = _mm_set1_ps(ray.maxDistance);
+    const __m128 epsilon = _mm_set1_ps(numeric_limits<float>::epsilon());
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i beginIdx = _mm_set1_epi32(begin - 1);
+    const __m128i endIdx = _mm_set1_epi32(end);
+
+    __m128 nearest = _mm_set1_ps(numeric_limits<float>::infinity());
+    __m128i nearestIdx = _mm_set1_epi32(-1);
+
+    // Start at an aligned index, so that loads never cross the padded end
+
+    for (int i = begin & ~3; i < end; i += 4) {
+        __m128 v0x = _mm_loadu_ps(&triangles.v0x[i]);
+        __m128 v0y = _mm_loadu_ps(&triangles.v0y[i]);
+        __m128 v0z = _mm_loadu_ps(&triangles.v0z[i]);
+        __m128 e1x = _mm_loadu_ps(&triangles.e1x[i]);
+        __m128 e1y = _mm_loadu_ps(&triangles.e1y[i]);
+        __m128 e1z = _mm_loadu_ps(&triangles.e1z[i]);
+        __m128 e2x = _mm_loadu_ps(&triangles.e2x[i]);
+        __m128 e2y = _mm_loadu_ps(&triangles.e2y[i]);
+        __m128 e2z = _mm_loadu_ps(&triangles.e2z[i]);
+
+        // p = cross(dir, edge2)
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        __m128 mask = _mm_cmpgt_ps(_mm_and_ps(det, absMask), epsilon);
+        __m128 invDet = _mm_div_ps(one, det);
+
+        // s = origin - v0
+        __m128 sx = _mm_sub_ps(ox, v0x);
+        __m128 sy = _mm_sub_ps(oy, v0y);
+        __m128 sz = _mm_sub_ps(oz, v0z);
+
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+        mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+
+        // q = cross(s, edge1)
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+        mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+
+        __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+        mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(distance, minDistance), _mm_cmple_ps(distance, maxDistance)));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(distance, nearest));
+
+        __m128i idx = _mm_add_epi32(_mm_set1_epi32(i), lanes);
+        __m128i idxMask = _mm_and_si128(_mm_cmpgt_epi32(idx, beginIdx), _mm_cmplt_epi32(idx, endIdx));
+        mask = _mm_and_ps(mask, _mm_castsi128_ps(idxMask));
+
+        nearest = selectMask(mask, distance, nearest);
+        nearestIdx = selectMask(_mm_castps_si128(mask), idx, nearestIdx);
+    }
+
+    alignas(16) float distances[4];
+    alignas(16) int indices[4];
+    _mm_store_ps(distances, nearest);
+    _mm_store_si128(reinterpret_cast<__m128i *>(indices), nearestIdx);
+
+    int lane = -1;
+    for (int i = 0; i < 4; ++i) {
+        if (indices[i] == -1) continue;
+        if (lane == -1 || distances[i] < distances[lane] || (distances[i] == distances[lane] && indices[i] < indices[lane])) {
+            lane = i;
+        }
+    }
+    if (lane == -1) return false;
+
+    hit.index = indices[lane];
+    hit.distance = distances[lane];
+
+    return true;
+}
+
+void intersectRaysTrianglesSSE(const Ray *rays, int rayCount, const TriangleBatch &triangles, RayHit *hits) {
+    const __m128 epsilon = _mm_set1_ps(numeric_limits<float>::epsilon());
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    // Rays are tested in packets of four, one per lane, against every
+    // triangle in turn. A partial packet repeats its last ray.
+
+    for (int first = 0; first < rayCount; first += 4) {
+        alignas(16) float rayData[8][4];
+        for (int lane = 0; lane < 4; ++lane) {
+            const Ray &ray = rays[min(first + lane, rayCount - 1)];
+            rayData[0][lane] = ray.origin.x;
+            rayData[1][lane] = ray.origin.y;
+            rayData[2][lane] = ray.origin.z;
+            rayData[3][lane] = ray.dir.x;
+            rayData[4][lane] = ray.dir.y;
+            rayData[5][lane] = ray.dir.z;
+            rayData[6][lane] = ray.minDistance;
+            rayData[7][lane] = ray.maxDistance;
+        }
+        const __m128 ox = _mm_load_ps(rayData[0]);
+        const __m128 oy = _mm_load_ps(rayData[1]);
+        const __m128 oz = _mm_load_ps(rayData[2]);
+        const __m128 dx = _mm_load_ps(rayData[3]);
+        const __m128 dy = _mm_load_ps(rayData[4]);
+        const __m128 dz = _mm_load_ps(rayData[5]);
+        const __m128 minDistance = _mm_load_ps(rayData[6]);
+        const __m128 maxDistance = _mm_load_ps(rayData[7]);
+
+        __m128 nearest = _mm_set1_ps(numeric_limits<float>::infinity());
+        __m128i nearestIdx = _mm_set1_epi32(-1);
+
+        for (int i = 0; i < triangles.count; ++i) {
+            __m128 e1x = _mm_set1_ps(triangles.e1x[i]);
+            __m128 e1y = _mm_set1_ps(triangles.e1y[i]);
+            __m128 e1z = _mm_set1_ps(triangles.e1z[i]);
+            __m128 e2x = _mm_set1_ps(triangles.e2x[i]);
+            __m128 e2y = _mm_set1_ps(triangles.e2y[i]);
+            __m128 e2z = _mm_set1_ps(triangles.e2z[i]);
+
+            // p = cross(dir, edge2)
+            __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 mask = _mm_cmpgt_ps(_mm_and_ps(det, absMask), epsilon);
+            __m128 invDet = _mm_div_ps(one, det);
+
+            // s = origin - v0
+            __m128 sx = _mm_sub_ps(ox, _mm_set1_ps(triangles.v0x[i]));
+            __m128 sy = _mm_sub_ps(oy, _mm_set1_ps(triangles.v0y[i]));
+            __m128 sz = _mm_sub_ps(oz, _mm_set1_ps(triangles.v0z[i]));
+
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+            mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+            if (_mm_movemask_ps(mask) == 0) continue;
+
+            // q = cross(s, edge1)
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+            mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+
+            __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+            mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(distance, minDistance), _mm_cmple_ps(distance, maxDistance)));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(distance, nearest));
+
+            nearest = selectMask(mask, distance, nearest);
+            nearestIdx = selectMask(_mm_castps_si128(mask), _mm_set1_epi32(i), nearestIdx);
+        }
+
+        alignas(16) float distances[4];
+        alignas(16) int indices[4];
+        _mm_store_ps(distances, nearest);
+        _mm_store_si128(reinterpret_cast<__m128i *>(indices), nearestIdx);
+
+        for (int lane = 0; lane < 4 && first + lane < rayCount; ++lane) {
+            RayHit &hit = hits[first + lane];
+            hit = RayHit();
+            if (indices[lane] == -1) continue;
+
+            hit.index = indices[lane];
+            hit.distance = distances[lane];
+        }
+    }
+}
+
+int intersectRayBoxesSSE(const Ray &ray, const AABBBatch &boxes, int *indices) {
+    const __m128 ox = _mm_set1_ps(ray.origin.x);
+    const __m128 oy = _mm_set1_ps(ray.origin.y);
+    const __m128 oz = _mm_set1_ps(ray.origin.z);
+    const __m128 invDx = _mm_set1_ps(getSafeInverse(ray.dir.x));
+    const __m128 invDy = _mm_set1_ps(getSafeInverse(ray.dir.y));
+    const __m128 invDz = _mm_set1_ps(getSafeInverse(ray.dir.z));
+    const __m128 minDistance = _mm_set1_ps(ray.minDistance);
+    const __m128 maxDistance = _mm_set1_ps(ray.maxDistance);
+
+    int count = 0;
+
+    for (int i = 0; i < boxes.count; i += 4) {
+        __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.minX[i]), ox), invDx);
+        __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.maxX[i]), ox), invDx);
+        __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.minY[i]), oy), invDy);
+        __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.maxY[i]), oy), invDy);
+        __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.minZ[i]), oz), invDz);
+        __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes.maxZ[i]), oz), invDz);
+
+        __m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)), _mm_max_ps(_mm_min_ps(t1z, t2z), minDistance));
+        __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)), _mm_min_ps(_mm_max_ps(t1z, t2z), maxDistance));
+
+        int hits = _mm_movemask_ps(_mm_cmple_ps(entry, exit));
+        for (int j = 0; hits != 0 && j < 4; ++j, hits >>= 1) {
+            if ((hits & 1) && i + j < boxes.count) {
+                indices[count++] = i + j;
+            }
+        }
+    }
+
+    return count;
+}
+
+} // namespace render
+
+} // namespace reone
+
+#endif
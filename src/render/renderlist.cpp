@@ -29,15 +29,80 @@ namespace reone {
 
 namespace render {
 
+static const int kMinInstanceCount = 2;
+
+void RenderQueue::clear() {
+    transforms.clear();
+    opaque.clear();
+    transparent.clear();
+}
+
+void RenderList::append(const vector<RenderListItem> &items, uint32_t transformOffset) {
+    for (auto &item : items) {
+        push_back(item);
+        back().transformIndex += transformOffset;
+    }
+}
+
 void RenderList::sortByDistanceToCamera(const glm::vec3 &cameraPosition) {
     sort(begin(), end(), [&cameraPosition](const RenderListItem &left, const RenderListItem &right) {
         return glm::distance2(left.origin, cameraPosition) > glm::distance2(right.origin, cameraPosition);
     });
 }
 
-void RenderList::render(bool debug) const {
-    for (auto &item : *this) {
-        item.model->render(*item.node, item.transform, debug);
+void RenderList::sortByBatch(const glm::vec3 &cameraPosition) {
+    sort(begin(), end(), [&cameraPosition](const RenderListItem &left, const RenderListItem &right) {
+        if (left.node != right.node) return left.node < right.node;
+
+        const Texture *leftTexture = left.model->textureOverride().get();
+        const Texture *rightTexture = right.model->textureOverride().get();
+        if (leftTexture != rightTexture) return leftTexture < rightTexture;
+
+        return glm::distance2(left.origin, cameraPosition) < glm::distance2(right.origin, cameraPosition);
+    });
+}
+
+static bool isSameBatch(const RenderListItem &left, const RenderListItem &right) {
+    return
+        left.node == right.node &&
+        left.model->textureOverride() == right.model->textureOverride() &&
+        left.model->isSkeletal(*left.node) == right.model->isSkeletal(*right.node);
+}
+
+void RenderList::render(const vector<glm::mat4> &transforms, bool debug) const {
+    vector<InstanceData> instances;
+    vector<glm::mat4> bonePalette;
+
+    for (auto first = begin(); first != end();) {
+        auto last = first + 1;
+        while (last != end() && isSameBatch(*first, *last)) {
+            ++last;
+        }
+        if (distance(first, last) < kMinInstanceCount) {
+            for (auto it = first; it != last; ++it) {
+                it->model->render(*it->node, transforms[it->transformIndex], debug);
+            }
+            first = last;
+            continue;
+        }
+        bool skeletal = first->model->isSkeletal(*first->node);
+        instances.clear();
+        bonePalette.clear();
+
+        for (auto it = first; it != last; ++it) {
+            InstanceData instance;
+            instance.transform = transforms[it->transformIndex];
+            instance.alpha = it->model->alpha() * it->node->alpha();
+
+            if (skeletal) {
+                instance.bonesOffset = static_cast<float>(bonePalette.size());
+                it->model->getBoneTransforms(*it->node, bonePalette);
+            }
+            instances.push_back(move(instance));
+        }
+
+        first->model->renderInstanced(*first->node, instances, bonePalette, debug);
+        first = last;
     }
 }
 
@@ -22,6 +22,7 @@
 #include "glm/mat4x4.hpp"
 #include "glm/vec3.hpp"
 
+#include "instancebuffer.h"
 #include "types.h"
 
 namespace reone {
@@ -34,14 +35,43 @@ class ModelNode;
 struct RenderListItem {
     const ModelInstance *model { nullptr };
     const ModelNode *node { nullptr };
-    glm::mat4 transform { 1.0f };
+    uint32_t transformIndex { 0 }; /**< index into the transform array of the frame */
     glm::vec3 origin { 0.0f };
 };
 
+/**
+ * Render list items and transforms collected by a single worker. Queues are
+ * filled independently and then merged into render lists.
+ */
+struct RenderQueue {
+    std::vector<glm::mat4> transforms;
+    std::vector<RenderListItem> opaque;
+    std::vector<RenderListItem> transparent;
+
+    void clear();
+};
+
+/**
+ * List of mesh nodes to render. Consecutive items sharing a mesh node,
+ * texture override and skinning state are rendered in a single instanced
+ * draw call.
+ */
 class RenderList : public std::vector<RenderListItem> {
 public:
+    /**
+     * Appends items of the queue, offsetting their transform indices.
+     */
+    void append(const std::vector<RenderListItem> &items, uint32_t transformOffset);
+
     void sortByDistanceToCamera(const glm::vec3 &cameraPosition);
-    void render(bool debug) const;
+
+    /**
+     * Groups items that can be rendered in a single draw call, nearest first
+     * within a group. Only suitable for opaque items.
+     */
+    void sortByBatch(const glm::vec3 &cameraPosition);
+
+    void render(const std::vector<glm::mat4> &transforms, bool debug) const;
 };
 
 } // namespace render
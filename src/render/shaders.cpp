@@ -17,26 +17,38 @@
 
 #include "shaders.h"
 
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
 
-#include "GL/glew.h"
+#include "glm/ext.hpp"
 
-#include "SDL2/SDL_opengl.h"
+#include "../core/log.h"
+#include "../core/pathutil.h"
 
-#include "glm/ext.hpp"
+#include "backend.h"
+#include "glapi.h"
 
 using namespace std;
 
+namespace fs = boost::filesystem;
+
 namespace reone {
 
 namespace render {
 
+static const char kBinaryCacheFilename[] = "shaders.cache";
+static const char kBinaryCacheSignature[] = "RSHC";
+static const uint32_t kBinaryCacheVersion = 1;
+
 static const GLchar kBasicVertexShader[] = R"END(
 #version 330
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform float alpha;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -47,6 +59,7 @@ out vec3 fragPosition;
 out vec3 fragNormal;
 out vec2 fragTexCoords;
 out vec2 fragLightmapCoords;
+out float fragAlpha;
 
 void main() {
     gl_Position = projection * view * model * vec4(position, 1);
@@ -54,6 +67,36 @@ void main() {
     fragNormal = mat3(transpose(inverse(model))) * normal;
     fragTexCoords = texCoords;
     fragLightmapCoords = lightmapCoords;
+    fragAlpha = alpha;
+}
+)END";
+
+static const GLchar kBasicInstancedVertexShader[] = R"END(
+#version 330
+
+uniform mat4 projection;
+uniform mat4 view;
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoords;
+layout(location = 3) in vec2 lightmapCoords;
+layout(location = 6) in mat4 instanceModel;
+layout(location = 10) in vec2 instanceAlphaBones;
+
+out vec3 fragPosition;
+out vec3 fragNormal;
+out vec2 fragTexCoords;
+out vec2 fragLightmapCoords;
+out float fragAlpha;
+
+void main() {
+    gl_Position = projection * view * instanceModel * vec4(position, 1);
+    fragPosition = vec3(instanceModel * vec4(position, 1));
+    fragNormal = mat3(transpose(inverse(instanceModel))) * normal;
+    fragTexCoords = texCoords;
+    fragLightmapCoords = lightmapCoords;
+    fragAlpha = instanceAlphaBones.x;
 }
 )END";
 
@@ -68,6 +111,7 @@ uniform mat4 model;
 uniform mat4 absTransform;
 uniform mat4 absTransformInv;
 uniform mat4 bones[MAX_BONES];
+uniform float alpha;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -78,6 +122,7 @@ layout(location = 5) in vec4 boneIndices;
 out vec3 fragPosition;
 out vec3 fragNormal;
 out vec2 fragTexCoords;
+out float fragAlpha;
 
 void main() {
     float weight0 = boneWeights.x;
@@ -110,36 +155,108 @@ void main() {
     fragPosition = vec3(model * vec4(position, 1));
     fragNormal = mat3(transpose(inverse(model))) * normal;
     fragTexCoords = texCoords;
+    fragAlpha = alpha;
 }
 )END";
 
-static const GLchar kGUIVertexShader[] = R"END(
+static const GLchar kSkeletalInstancedVertexShader[] = R"END(
 #version 330
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
+uniform mat4 absTransform;
+uniform mat4 absTransformInv;
+uniform samplerBuffer bonePalette;
 
 layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texCoords;
+layout(location = 4) in vec4 boneWeights;
+layout(location = 5) in vec4 boneIndices;
+layout(location = 6) in mat4 instanceModel;
+layout(location = 10) in vec2 instanceAlphaBones;
 
+out vec3 fragPosition;
+out vec3 fragNormal;
 out vec2 fragTexCoords;
+out float fragAlpha;
+
+mat4 getBone(int index) {
+    int offset = 4 * (int(instanceAlphaBones.y) + index);
+    return mat4(
+        texelFetch(bonePalette, offset + 0),
+        texelFetch(bonePalette, offset + 1),
+        texelFetch(bonePalette, offset + 2),
+        texelFetch(bonePalette, offset + 3));
+}
 
 void main() {
-    gl_Position = projection * view * model * vec4(position, 1);
+    float weight0 = boneWeights.x;
+    float weight1 = boneWeights.y;
+    float weight2 = boneWeights.z;
+    float weight3 = boneWeights.w;
+
+    int index0 = int(boneIndices.x);
+    int index1 = int(boneIndices.y);
+    int index2 = int(boneIndices.z);
+    int index3 = int(boneIndices.w);
+
+    vec3 newPosition = vec3(0, 0, 0);
+    vec4 position4 = vec4(position, 1);
+
+    if (index0 != -1) {
+        newPosition += weight0 * (absTransformInv * getBone(index0) * absTransform * position4).xyz;
+    }
+    if (index1 != -1) {
+        newPosition += weight1 * (absTransformInv * getBone(index1) * absTransform * position4).xyz;
+    }
+    if (index2 != -1) {
+        newPosition += weight2 * (absTransformInv * getBone(index2) * absTransform * position4).xyz;
+    }
+    if (index3 != -1) {
+        newPosition += weight3 * (absTransformInv * getBone(index3) * absTransform * position4).xyz;
+    }
+
+    gl_Position = projection * view * instanceModel * vec4(newPosition, 1);
+    fragPosition = vec3(instanceModel * vec4(position, 1));
+    fragNormal = mat3(transpose(inverse(instanceModel))) * normal;
+    fragTexCoords = texCoords;
+    fragAlpha = instanceAlphaBones.x;
+}
+)END";
+
+static const GLchar kGUIVertexShader[] = R"END(
+#version 330
+
+uniform mat4 projection;
+uniform mat4 view;
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 texCoords;
+layout(location = 3) in float text;
+
+out vec3 fragColor;
+out vec2 fragTexCoords;
+out float fragText;
+
+void main() {
+    gl_Position = projection * view * vec4(position, 0, 1);
+    fragColor = color;
     fragTexCoords = texCoords;
+    fragText = text;
 }
 )END";
 
 static const GLchar kWhiteFragmentShader[] = R"END(
 #version 330
 
-uniform float alpha;
+in float fragAlpha;
 
 out vec4 color;
 
 void main() {
-    color = vec4(1, 1, 1, alpha);
+    color = vec4(1, 1, 1, fragAlpha);
 }
 )END";
 
@@ -148,15 +265,15 @@ static const GLchar kDiffuseFragmentShader[] = R"END(
 
 uniform sampler2D diffuse;
 uniform vec3 color;
-uniform float alpha;
 
+in float fragAlpha;
 in vec2 fragTexCoords;
 
 out vec4 fragColor;
 
 void main() {
     vec4 objectColor = texture(diffuse, fragTexCoords);
-    fragColor = vec4(objectColor.rgb * color, alpha * objectColor.a);
+    fragColor = vec4(objectColor.rgb * color, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -166,8 +283,8 @@ static const GLchar kDiffuseEnvmapFragmentShader[] = R"END(
 uniform sampler2D diffuse;
 uniform samplerCube envmap;
 uniform vec3 cameraPosition;
-uniform float alpha;
 
+in float fragAlpha;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoords;
@@ -183,7 +300,7 @@ void main() {
     vec4 objectColor = diffuseSample;
     objectColor += envmapSample * (1 - diffuseSample.a);
 
-    color = vec4(objectColor.rgb, alpha * objectColor.a);
+    color = vec4(objectColor.rgb, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -193,8 +310,8 @@ static const GLchar kDiffuseBumpyShinyFragmentShader[] = R"END(
 uniform sampler2D diffuse;
 uniform samplerCube bumpyShiny;
 uniform vec3 cameraPosition;
-uniform float alpha;
 
+in float fragAlpha;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoords;
@@ -210,7 +327,7 @@ void main() {
     vec4 objectColor = vec4(diffuseSample.rgb, 1);
     objectColor += bumpyShinySample * (1 - diffuseSample.a);
 
-    color = vec4(objectColor.rgb, alpha * objectColor.a);
+    color = vec4(objectColor.rgb, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -219,8 +336,8 @@ static const GLchar kDiffuseLightmapFragmentShader[] = R"END(
 
 uniform sampler2D diffuse;
 uniform sampler2D lightmap;
-uniform float alpha;
 
+in float fragAlpha;
 in vec2 fragTexCoords;
 in vec2 fragLightmapCoords;
 
@@ -231,7 +348,7 @@ void main() {
     vec4 lightmapSample = texture(lightmap, fragLightmapCoords);
 
     vec4 objectColor = vec4((diffuseSample.rgb * lightmapSample.rgb), diffuseSample.a);
-    color = vec4(objectColor.rgb, alpha * objectColor.a);
+    color = vec4(objectColor.rgb, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -242,8 +359,8 @@ uniform sampler2D diffuse;
 uniform sampler2D lightmap;
 uniform samplerCube envmap;
 uniform vec3 cameraPosition;
-uniform float alpha;
 
+in float fragAlpha;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoords;
@@ -262,7 +379,7 @@ void main() {
     vec4 objectColor = diffuseSample * lightmapSample;
     objectColor += envmapSample * (1 - diffuseSample.a);
 
-    color = vec4(objectColor.rgb, alpha * objectColor.a);
+    color = vec4(objectColor.rgb, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -273,8 +390,8 @@ uniform sampler2D diffuse;
 uniform sampler2D lightmap;
 uniform samplerCube bumpyShiny;
 uniform vec3 cameraPosition;
-uniform float alpha;
 
+in float fragAlpha;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoords;
@@ -293,7 +410,7 @@ void main() {
     vec4 objectColor = diffuseSample * lightmapSample;
     objectColor += bumpyShinySample * (1 - diffuseSample.a);
 
-    color = vec4(objectColor.rgb, alpha * objectColor.a);
+    color = vec4(objectColor.rgb, fragAlpha * objectColor.a);
 }
 )END";
 
@@ -303,8 +420,8 @@ static const GLchar kDiffuseBumpmapFragmentShader[] = R"END(
 uniform sampler2D diffuse;
 uniform sampler2D bumpmap;
 uniform vec3 cameraPosition;
-uniform float alpha;
 
+in float fragAlpha;
 in vec3 fragPosition;
 in vec3 fragNormal;
 in vec2 fragTexCoords;
@@ -317,22 +434,24 @@ void main() {
     vec4 bumpmapSample = texture(bumpmap, fragTexCoords);
 
     vec4 objectColor = diffuseSample;
-    color = vec4(objectColor.rgb, alpha);
+    color = vec4(objectColor.rgb, fragAlpha);
 }
 )END";
 
-static const GLchar kTextFragmentShader[] = R"END(
+static const GLchar kGUIFragmentShader[] = R"END(
 #version 330
 
-uniform sampler2D font;
-uniform vec3 textColor;
+uniform sampler2D diffuse;
 
+in vec3 fragColor;
 in vec2 fragTexCoords;
+in float fragText;
 
 out vec4 color;
 
 void main() {
-    color = vec4(textColor, texture(font, fragTexCoords).a);
+    vec4 texel = texture(diffuse, fragTexCoords);
+    color = fragText > 0.5 ? vec4(fragColor, texel.a) : vec4(texel.rgb * fragColor, texel.a);
 }
 )END";
 
@@ -342,18 +461,24 @@ ShaderManager &ShaderManager::instance() {
 }
 
 void ShaderManager::initGL() {
-    initShader(ShaderName::VertexBasic, GL_VERTEX_SHADER, kBasicVertexShader);
-    initShader(ShaderName::VertexSkeletal, GL_VERTEX_SHADER, kSkeletalVertexShader);
-    initShader(ShaderName::VertexGUI, GL_VERTEX_SHADER, kGUIVertexShader);
-    initShader(ShaderName::FragmentWhite, GL_FRAGMENT_SHADER, kWhiteFragmentShader);
-    initShader(ShaderName::FragmentDiffuse, GL_FRAGMENT_SHADER, kDiffuseFragmentShader);
-    initShader(ShaderName::FragmentDiffuseEnvmap, GL_FRAGMENT_SHADER, kDiffuseEnvmapFragmentShader);
-    initShader(ShaderName::FragmentDiffuseBumpyShiny, GL_FRAGMENT_SHADER, kDiffuseBumpyShinyFragmentShader);
-    initShader(ShaderName::FragmentDiffuseLightmap, GL_FRAGMENT_SHADER, kDiffuseLightmapFragmentShader);
-    initShader(ShaderName::FragmentDiffuseLightmapEnvmap, GL_FRAGMENT_SHADER, kDiffuseLightmapEnvmapFragmentShader);
-    initShader(ShaderName::FragmentDiffuseLightmapBumpyShiny, GL_FRAGMENT_SHADER, kDiffuseLightmapBumpyShinyFragmentShader);
-    initShader(ShaderName::FragmentDiffuseBumpmap, GL_FRAGMENT_SHADER, kDiffuseBumpmapFragmentShader);
-    initShader(ShaderName::FragmentText, GL_FRAGMENT_SHADER, kTextFragmentShader);
+    auto start = chrono::steady_clock::now();
+
+    addShader(ShaderName::VertexBasic, GL_VERTEX_SHADER, kBasicVertexShader);
+    addShader(ShaderName::VertexSkeletal, GL_VERTEX_SHADER, kSkeletalVertexShader);
+    addShader(ShaderName::VertexBasicInstanced, GL_VERTEX_SHADER, kBasicInstancedVertexShader);
+    addShader(ShaderName::VertexSkeletalInstanced, GL_VERTEX_SHADER, kSkeletalInstancedVertexShader);
+    addShader(ShaderName::VertexGUI, GL_VERTEX_SHADER, kGUIVertexShader);
+    addShader(ShaderName::FragmentWhite, GL_FRAGMENT_SHADER, kWhiteFragmentShader);
+    addShader(ShaderName::FragmentDiffuse, GL_FRAGMENT_SHADER, kDiffuseFragmentShader);
+    addShader(ShaderName::FragmentDiffuseEnvmap, GL_FRAGMENT_SHADER, kDiffuseEnvmapFragmentShader);
+    addShader(ShaderName::FragmentDiffuseBumpyShiny, GL_FRAGMENT_SHADER, kDiffuseBumpyShinyFragmentShader);
+    addShader(ShaderName::FragmentDiffuseLightmap, GL_FRAGMENT_SHADER, kDiffuseLightmapFragmentShader);
+    addShader(ShaderName::FragmentDiffuseLightmapEnvmap, GL_FRAGMENT_SHADER, kDiffuseLightmapEnvmapFragmentShader);
+    addShader(ShaderName::FragmentDiffuseLightmapBumpyShiny, GL_FRAGMENT_SHADER, kDiffuseLightmapBumpyShinyFragmentShader);
+    addShader(ShaderName::FragmentDiffuseBumpmap, GL_FRAGMENT_SHADER, kDiffuseBumpmapFragmentShader);
+    addShader(ShaderName::FragmentGUI, GL_FRAGMENT_SHADER, kGUIFragmentShader);
+
+    loadBinaryCache();
 
     initProgram(ShaderProgram::BasicWhite, ShaderName::VertexBasic, ShaderName::FragmentWhite);
     initProgram(ShaderProgram::BasicDiffuse, ShaderName::VertexBasic, ShaderName::FragmentDiffuse);
@@ -366,16 +491,47 @@ void ShaderManager::initGL() {
     initProgram(ShaderProgram::SkeletalDiffuseEnvmap, ShaderName::VertexSkeletal, ShaderName::FragmentDiffuseEnvmap);
     initProgram(ShaderProgram::SkeletalDiffuseBumpyShiny, ShaderName::VertexSkeletal, ShaderName::FragmentDiffuseBumpyShiny);
     initProgram(ShaderProgram::SkeletalDiffuseBumpmap, ShaderName::VertexSkeletal, ShaderName::FragmentDiffuseBumpmap);
-    initProgram(ShaderProgram::GUIText, ShaderName::VertexGUI, ShaderName::FragmentText);
+    initProgram(ShaderProgram::InstancedDiffuse, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuse);
+    initProgram(ShaderProgram::InstancedDiffuseEnvmap, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuseEnvmap);
+    initProgram(ShaderProgram::InstancedDiffuseBumpyShiny, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuseBumpyShiny);
+    initProgram(ShaderProgram::InstancedDiffuseLightmap, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuseLightmap);
+    initProgram(ShaderProgram::InstancedDiffuseLightmapEnvmap, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuseLightmapEnvmap);
+    initProgram(ShaderProgram::InstancedDiffuseLightmapBumpyShiny, ShaderName::VertexBasicInstanced, ShaderName::FragmentDiffuseLightmapBumpyShiny);
+    initProgram(ShaderProgram::SkeletalInstancedDiffuse, ShaderName::VertexSkeletalInstanced, ShaderName::FragmentDiffuse);
+    initProgram(ShaderProgram::SkeletalInstancedDiffuseEnvmap, ShaderName::VertexSkeletalInstanced, ShaderName::FragmentDiffuseEnvmap);
+    initProgram(ShaderProgram::SkeletalInstancedDiffuseBumpyShiny, ShaderName::VertexSkeletalInstanced, ShaderName::FragmentDiffuseBumpyShiny);
+    initProgram(ShaderProgram::SkeletalInstancedDiffuseBumpmap, ShaderName::VertexSkeletalInstanced, ShaderName::FragmentDiffuseBumpmap);
+    initProgram(ShaderProgram::GUI, ShaderName::VertexGUI, ShaderName::FragmentGUI);
+
+    if (_cacheDirty) {
+        saveBinaryCache();
+    }
+    _binaries.clear();
+
+    float time = chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+    info(boost::format("Shaders: %d programs initialized in %.1f ms, %d loaded from cache") % _programs.size() % time % _cachedProgramCount);
 }
 
-void ShaderManager::initShader(ShaderName name, unsigned int type, const char *source) {
-    GLuint shader = glCreateShader(type);
+void ShaderManager::addShader(ShaderName name, unsigned int type, const char *source) {
+    ShaderSource shaderSource;
+    shaderSource.type = type;
+    shaderSource.source = source;
+
+    _sources.insert(make_pair(name, shaderSource));
+}
+
+unsigned int ShaderManager::getShader(ShaderName name) {
+    auto maybeShader = _shaders.find(name);
+    if (maybeShader != _shaders.end()) return maybeShader->second;
+
+    const ShaderSource &source = _sources.find(name)->second;
+
+    GLuint shader = glCreateShader(source.type);
     GLint success;
     char log[512];
     GLsizei logSize;
 
-    glShaderSource(shader, 1, &source, nullptr);
+    glShaderSource(shader, 1, &source.source, nullptr);
     glCompileShader(shader);
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 
@@ -385,17 +541,30 @@ void ShaderManager::initShader(ShaderName name, unsigned int type, const char *s
     }
 
     _shaders.insert(make_pair(name, shader));
+
+    return shader;
 }
 
 void ShaderManager::initProgram(ShaderProgram program, ShaderName vertexShader, ShaderName fragmentShader) {
-    unsigned int vsOrdinal = _shaders.find(vertexShader)->second;
-    unsigned int fsOrdinal = _shaders.find(fragmentShader)->second;
-
+    uint64_t sourceHash = getSourceHash(vertexShader, fragmentShader);
     GLuint ordinal = glCreateProgram();
+
+    if (_cacheEnabled && loadProgramBinary(program, sourceHash, ordinal)) {
+        _programs.insert(make_pair(program, ordinal));
+        ++_cachedProgramCount;
+        return;
+    }
+
+    unsigned int vsOrdinal = getShader(vertexShader);
+    unsigned int fsOrdinal = getShader(fragmentShader);
+
     GLint success;
     char log[512];
     GLsizei logSize;
 
+    if (_cacheEnabled) {
+        glProgramParameteri(ordinal, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glAttachShader(ordinal, vsOrdinal);
     glAttachShader(ordinal, fsOrdinal);
     glLinkProgram(ordinal);
@@ -406,9 +575,210 @@ void ShaderManager::initProgram(ShaderProgram program, ShaderName vertexShader,
         throw runtime_error("Shaders: program linking failed: " + string(log, logSize));
     }
 
+    if (_cacheEnabled) {
+        saveProgramBinary(program, sourceHash, ordinal);
+    }
+
     _programs.insert(make_pair(program, ordinal));
 }
 
+uint64_t ShaderManager::getSourceHash(ShaderName vertexShader, ShaderName fragmentShader) const {
+    // 64-bit FNV-1a of both sources, including their terminating zeros
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (auto name : { vertexShader, fragmentShader }) {
+        const char *source = _sources.find(name)->second.source;
+        do {
+            hash ^= static_cast<uint8_t>(*source);
+            hash *= 0x100000001b3ull;
+        } while (*source++);
+    }
+
+    return hash;
+}
+
+void ShaderManager::loadBinaryCache() {
+    _cacheEnabled = false;
+    _cacheDirty = false;
+    _binaries.clear();
+    _cachedProgramCount = 0;
+
+    if (TheRenderBackend.type() != RenderBackendType::OpenGL || !GLEW_ARB_get_program_binary) return;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0) return;
+
+    _cacheEnabled = true;
+
+    // Binaries are only valid for the driver that produced them
+
+    _driverKey.clear();
+    for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte *value = glGetString(name);
+        if (value) {
+            _driverKey += reinterpret_cast<const char *>(value);
+        }
+        _driverKey += '\n';
+    }
+
+    fs::path cachePath(getCachePath() / kBinaryCacheFilename);
+
+    ifstream cache(cachePath.string(), ios::binary);
+    if (!cache) return;
+
+    cache.seekg(0, ios::end);
+    streamoff fileSize = cache.tellg();
+    cache.seekg(0);
+
+    auto read = [&cache](void *data, size_t size) {
+        return static_cast<bool>(cache.read(static_cast<char *>(data), size));
+    };
+
+    // Lengths are checked against the file size before allocating, so that
+    // a corrupted cache cannot request huge buffers
+    auto fits = [&cache, &fileSize](uint32_t length) {
+        streamoff position = cache.tellg();
+        return position >= 0 && length <= fileSize - position;
+    };
+
+    char signature[4];
+    uint32_t version, keyLength;
+    if (!read(signature, sizeof(signature)) ||
+        strncmp(signature, kBinaryCacheSignature, sizeof(signature)) != 0 ||
+        !read(&version, sizeof(version)) ||
+        version != kBinaryCacheVersion ||
+        !read(&keyLength, sizeof(keyLength)) ||
+        keyLength != _driverKey.size() ||
+        !fits(keyLength)) {
+
+        info("Shaders: binary cache is stale, programs will be compiled");
+        return;
+    }
+
+    string driverKey(keyLength, '\0');
+    if (!read(&driverKey[0], keyLength) || driverKey != _driverKey) {
+        info("Shaders: binary cache is stale, programs will be compiled");
+        return;
+    }
+
+    uint32_t programCount;
+    if (!read(&programCount, sizeof(programCount))) return;
+
+    for (uint32_t i = 0; i < programCount; ++i) {
+        uint32_t program, length;
+        ProgramBinary binary;
+
+        if (!read(&program, sizeof(program)) ||
+            !read(&binary.sourceHash, sizeof(binary.sourceHash)) ||
+            !read(&binary.format, sizeof(binary.format)) ||
+            !read(&length, sizeof(length)) ||
+            length == 0 ||
+            !fits(length)) {
+
+            warn("Shaders: binary cache is corrupted");
+            _binaries.clear();
+            return;
+        }
+        binary.data.resize(length);
+        if (!read(binary.data.data(), length)) {
+            warn("Shaders: binary cache is truncated");
+            _binaries.clear();
+            return;
+        }
+
+        _binaries[static_cast<ShaderProgram>(program)] = move(binary);
+    }
+}
+
+void ShaderManager::saveBinaryCache() {
+    fs::path cachePath(getCachePath() / kBinaryCacheFilename);
+
+    boost::system::error_code ec;
+    fs::create_directories(cachePath.parent_path(), ec);
+
+    ofstream cache(cachePath.string(), ios::binary);
+    if (!cache) {
+        warn("Shaders: failed to open binary cache for writing: " + cachePath.string());
+        return;
+    }
+
+    auto write = [&cache](const void *data, size_t size) {
+        cache.write(static_cast<const char *>(data), size);
+    };
+
+    uint32_t version = kBinaryCacheVersion;
+    uint32_t keyLength = static_cast<uint32_t>(_driverKey.size());
+    uint32_t programCount = static_cast<uint32_t>(_binaries.size());
+
+    write(kBinaryCacheSignature, 4);
+    write(&version, sizeof(version));
+    write(&keyLength, sizeof(keyLength));
+    write(_driverKey.c_str(), keyLength);
+    write(&programCount, sizeof(programCount));
+
+    for (auto &pair : _binaries) {
+        uint32_t program = static_cast<uint32_t>(pair.first);
+        uint32_t length = static_cast<uint32_t>(pair.second.data.size());
+
+        write(&program, sizeof(program));
+        write(&pair.second.sourceHash, sizeof(pair.second.sourceHash));
+        write(&pair.second.format, sizeof(pair.second.format));
+        write(&length, sizeof(length));
+        write(pair.second.data.data(), length);
+    }
+
+    if (!cache) {
+        warn("Shaders: failed to write binary cache: " + cachePath.string());
+        return;
+    }
+
+    debug(boost::format("Shaders: binary cache saved: %d programs") % programCount);
+}
+
+bool ShaderManager::loadProgramBinary(ShaderProgram program, uint64_t sourceHash, unsigned int ordinal) {
+    auto maybeBinary = _binaries.find(program);
+    if (maybeBinary == _binaries.end()) return false;
+
+    const ProgramBinary &binary = maybeBinary->second;
+    if (binary.sourceHash != sourceHash || binary.data.empty()) return false;
+
+    // Driver may reject a binary even if the key matches, e.g. after a
+    // configuration change, in which case the program is compiled from source
+
+    GLint success;
+    glProgramBinary(ordinal, binary.format, binary.data.data(), static_cast<GLsizei>(binary.data.size()));
+    glGetProgramiv(ordinal, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        debug("Shaders: program binary rejected by driver: " + to_string(static_cast<int>(program)));
+        return false;
+    }
+
+    return true;
+}
+
+void ShaderManager::saveProgramBinary(ShaderProgram program, uint64_t sourceHash, unsigned int ordinal) {
+    GLint length = 0;
+    glGetProgramiv(ordinal, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    ProgramBinary binary;
+    binary.sourceHash = sourceHash;
+    binary.data.resize(length);
+
+    GLenum format = 0;
+    glGetProgramBinary(ordinal, length, &length, &format, binary.data.data());
+    if (length <= 0) return;
+
+    binary.data.resize(length);
+    binary.format = format;
+
+    _binaries[program] = move(binary);
+    _cacheDirty = true;
+}
+
 ShaderManager::~ShaderManager() {
     deinitGL();
 }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -40,7 +41,17 @@ enum class ShaderProgram {
     SkeletalDiffuseEnvmap,
     SkeletalDiffuseBumpyShiny,
     SkeletalDiffuseBumpmap,
-    GUIText
+    InstancedDiffuse,
+    InstancedDiffuseEnvmap,
+    InstancedDiffuseBumpyShiny,
+    InstancedDiffuseLightmap,
+    InstancedDiffuseLightmapEnvmap,
+    InstancedDiffuseLightmapBumpyShiny,
+    SkeletalInstancedDiffuse,
+    SkeletalInstancedDiffuseEnvmap,
+    SkeletalInstancedDiffuseBumpyShiny,
+    SkeletalInstancedDiffuseBumpmap,
+    GUI
 };
 
 struct ShaderUniforms {
@@ -68,6 +79,8 @@ private:
     enum class ShaderName {
         VertexBasic,
         VertexSkeletal,
+        VertexBasicInstanced,
+        VertexSkeletalInstanced,
         VertexGUI,
         FragmentWhite,
         FragmentDiffuse,
@@ -77,22 +90,58 @@ private:
         FragmentDiffuseLightmapEnvmap,
         FragmentDiffuseLightmapBumpyShiny,
         FragmentDiffuseBumpmap,
-        FragmentText
+        FragmentGUI
     };
 
+    struct ShaderSource {
+        unsigned int type { 0 };
+        const char *source { nullptr };
+    };
+
+    /**
+     * Linked program binary, as returned by glGetProgramBinary.
+     */
+    struct ProgramBinary {
+        uint64_t sourceHash { 0 };
+        uint32_t format { 0 };
+        std::vector<char> data;
+    };
+
+    std::map<ShaderName, ShaderSource> _sources;
     std::map<ShaderName, unsigned int> _shaders;
     std::map<ShaderProgram, unsigned int> _programs;
     ShaderProgram _activeProgram { ShaderProgram::None };
     unsigned int _activeOrdinal { 0 };
 
+    // Program binary cache
+
+    bool _cacheEnabled { false };
+    bool _cacheDirty { false };
+    std::string _driverKey;
+    std::map<ShaderProgram, ProgramBinary> _binaries;
+    int _cachedProgramCount { 0 };
+
     ShaderManager() = default;
     ShaderManager(const ShaderManager &) = delete;
     ~ShaderManager();
 
     ShaderManager &operator=(const ShaderManager &) = delete;
 
-    void initShader(ShaderName name, unsigned int type, const char *source);
+    void addShader(ShaderName name, unsigned int type, const char *source);
     void initProgram(ShaderProgram program, ShaderName vertexShader, ShaderName fragmentShader);
+
+    /**
+     * Compiles the shader on first use.
+     */
+    unsigned int getShader(ShaderName name);
+
+    uint64_t getSourceHash(ShaderName vertexShader, ShaderName fragmentShader) const;
+
+    void loadBinaryCache();
+    void saveBinaryCache();
+    bool loadProgramBinary(ShaderProgram program, uint64_t sourceHash, unsigned int ordinal);
+    void saveProgramBinary(ShaderProgram program, uint64_t sourceHash, unsigned int ordinal);
+
     unsigned int getOrdinal(ShaderProgram program) const;
     void setUniform(unsigned int ordinal, const std::string &name, int value);
     void setUniform(unsigned int ordinal, const std::string &name, float value);
@@ -0,0 +1,97 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "staticgeometry.h"
+
+#include "glapi.h"
+#include "shaders.h"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+void StaticGeometry::add(ModelInstance &model, const glm::mat4 &transform) {
+    for (auto &node : model.extractStaticNodes()) {
+        add(*node->mesh(), transform * model.getNodeTransform(*node));
+    }
+}
+
+void StaticGeometry::add(const ModelMesh &mesh, const glm::mat4 &transform) {
+    const shared_ptr<Texture> &diffuse = mesh.diffuseTexture();
+    const shared_ptr<Texture> &lightmap = mesh.lightmapTexture();
+
+    // Only the last batch with the same textures may have room left
+    for (auto it = _batches.rbegin(); it != _batches.rend(); ++it) {
+        if (it->diffuse != diffuse || it->lightmap != lightmap) continue;
+        if (it->mesh->append(mesh, transform)) return;
+        break;
+    }
+
+    Batch batch;
+    batch.diffuse = diffuse;
+    batch.lightmap = lightmap;
+    batch.mesh = make_unique<BatchMesh>();
+    batch.mesh->append(mesh, transform);
+
+    _batches.push_back(move(batch));
+}
+
+void StaticGeometry::initGL() {
+    for (auto &batch : _batches) {
+        batch.mesh->initGL();
+    }
+}
+
+void StaticGeometry::render() const {
+    ShaderManager &shaders = ShaderManager::instance();
+
+    for (auto &batch : _batches) {
+        shaders.activate(batch.lightmap ? ShaderProgram::BasicDiffuseLightmap : ShaderProgram::BasicDiffuse);
+        shaders.setUniform("model", glm::mat4(1.0f));
+        shaders.setUniform("color", glm::vec3(1.0f));
+        shaders.setUniform("alpha", 1.0f);
+
+        glActiveTexture(GL_TEXTURE0);
+        batch.diffuse->bind();
+
+        if (batch.lightmap) {
+            shaders.setUniform("lightmap", 2);
+            glActiveTexture(GL_TEXTURE2);
+            batch.lightmap->bind();
+        }
+
+        batch.mesh->render(GL_TRIANGLES);
+
+        if (batch.lightmap) {
+            glActiveTexture(GL_TEXTURE2);
+            batch.lightmap->unbind();
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        batch.diffuse->unbind();
+    }
+}
+
+int StaticGeometry::batchCount() const {
+    return static_cast<int>(_batches.size());
+}
+
+} // namespace render
+
+} // namespace reone
@@ -0,0 +1,65 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mesh/batchmesh.h"
+
+#include "modelinstance.h"
+#include "texture.h"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Static, non-animated model meshes merged into a few large meshes,
+ * grouped by textures. Intended for area rooms.
+ *
+ * @see reone::render::BatchMesh
+ */
+class StaticGeometry {
+public:
+    /**
+     * Moves static mesh nodes of the model instance into batches. Moved
+     * nodes are no longer rendered by the model instance.
+     */
+    void add(ModelInstance &model, const glm::mat4 &transform);
+
+    void initGL();
+    void render() const;
+
+    int batchCount() const;
+
+private:
+    struct Batch {
+        std::shared_ptr<Texture> diffuse;
+        std::shared_ptr<Texture> lightmap;
+        std::unique_ptr<BatchMesh> mesh;
+    };
+
+    std::vector<Batch> _batches;
+
+    void add(const ModelMesh &mesh, const glm::mat4 &transform);
+};
+
+} // namespace render
+
+} // namespace reone
@@ -19,9 +19,7 @@
 
 #include <stdexcept>
 
-#include "GL/glew.h"
-
-#include "SDL2/SDL_opengl.h"
+#include "glapi.h"
 
 using namespace std;
 
@@ -94,6 +94,7 @@ private:
     friend class resources::CurFile;
     friend class resources::TgaFile;
     friend class resources::TpcFile;
+    friend class TextureAtlas;
 };
 
 } // namespace render
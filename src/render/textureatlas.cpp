@@ -0,0 +1,303 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "textureatlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include "glm/common.hpp"
+
+using namespace std;
+
+namespace reone {
+
+namespace render {
+
+static const int kPageSize = 1024;
+static const int kMaxTextureSize = 256;
+static const int kPadding = 1;
+
+static void unpackColor565(uint16_t color, uint8_t *rgba) {
+    rgba[0] = ((color >> 11) & 0x1f) * 255 / 31;
+    rgba[1] = ((color >> 5) & 0x3f) * 255 / 63;
+    rgba[2] = (color & 0x1f) * 255 / 31;
+    rgba[3] = 255;
+}
+
+/**
+ * Decodes a DXT color block into 16 RGBA pixels.
+ */
+static void decodeColorBlock(const uint8_t *block, bool dxt1, uint8_t *pixels) {
+    uint16_t color0 = block[0] | (block[1] << 8);
+    uint16_t color1 = block[2] | (block[3] << 8);
+
+    uint8_t palette[4][4];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+
+    if (!dxt1 || color0 > color1) {
+        for (int i = 0; i < 3; ++i) {
+            palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+            palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    } else {
+        for (int i = 0; i < 3; ++i) {
+            palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+            palette[3][i] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
+
+    for (int i = 0; i < 16; ++i) {
+        memcpy(&pixels[4 * i], palette[(indices >> (2 * i)) & 3], 4);
+    }
+}
+
+/**
+ * Decodes a DXT5 alpha block into alpha components of 16 RGBA pixels.
+ */
+static void decodeAlphaBlock(const uint8_t *block, uint8_t *pixels) {
+    uint8_t alpha[8];
+    alpha[0] = block[0];
+    alpha[1] = block[1];
+
+    if (alpha[0] > alpha[1]) {
+        for (int i = 1; i < 7; ++i) {
+            alpha[i + 1] = ((7 - i) * alpha[0] + i * alpha[1]) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            alpha[i + 1] = ((5 - i) * alpha[0] + i * alpha[1]) / 5;
+        }
+        alpha[6] = 0;
+        alpha[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        pixels[4 * i + 3] = alpha[(indices >> (3 * i)) & 7];
+    }
+}
+
+TextureAtlas::TextureAtlas(const string &name) : _name(name) {
+}
+
+void TextureAtlas::build(const vector<shared_ptr<Texture>> &textures) {
+    struct Entry {
+        shared_ptr<Texture> texture;
+        ByteArray pixels;
+        int width { 0 };
+        int height { 0 };
+    };
+
+    vector<Entry> entries;
+    set<const Texture *> visited;
+
+    for (auto &texture : textures) {
+        if (!texture || _regions.count(texture.get()) > 0) continue;
+        if (!visited.insert(texture.get()).second) continue;
+        if (texture->width() > kMaxTextureSize || texture->height() > kMaxTextureSize) continue;
+
+        Entry entry;
+        if (!getPixels(*texture, entry.pixels)) continue;
+
+        entry.texture = texture;
+        entry.width = texture->width();
+        entry.height = texture->height();
+
+        entries.push_back(move(entry));
+    }
+
+    // Shelf packing works best with textures sorted by height
+
+    sort(entries.begin(), entries.end(), [](const Entry &left, const Entry &right) {
+        return left.height > right.height;
+    });
+
+    shared_ptr<Texture> page;
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+
+    for (auto &entry : entries) {
+        int width = entry.width + 2 * kPadding;
+        int height = entry.height + 2 * kPadding;
+
+        if (page && shelfX + width > kPageSize) {
+            shelfX = 0;
+            shelfY += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (!page || shelfY + height > kPageSize) {
+            page = newPage();
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+        }
+
+        // Copy pixels, extruding edges into the padding to avoid bleeding
+
+        ByteArray &pagePixels = page->_layers.front().mipMaps.front().data;
+
+        for (int y = 0; y < height; ++y) {
+            int srcY = glm::clamp(y - kPadding, 0, entry.height - 1);
+            for (int x = 0; x < width; ++x) {
+                int srcX = glm::clamp(x - kPadding, 0, entry.width - 1);
+                const char *src = &entry.pixels[4 * (srcY * entry.width + srcX)];
+                char *dst = &pagePixels[4 * ((shelfY + y) * kPageSize + shelfX + x)];
+                memcpy(dst, src, 4);
+            }
+        }
+
+        Region region;
+        region.page = page;
+        region.uvMin = glm::vec2(shelfX + kPadding, shelfY + kPadding) / static_cast<float>(kPageSize);
+        region.uvMax = glm::vec2(shelfX + kPadding + entry.width, shelfY + kPadding + entry.height) / static_cast<float>(kPageSize);
+
+        _regions.insert(make_pair(entry.texture.get(), move(region)));
+
+        shelfX += width;
+        shelfHeight = max(shelfHeight, height);
+    }
+}
+
+bool TextureAtlas::getPixels(const Texture &texture, ByteArray &pixels) {
+    if (texture._layers.size() != 1 || texture._layers.front().mipMaps.empty()) return false;
+
+    const Texture::MipMap &mipMap = texture._layers.front().mipMaps.front();
+    int width = mipMap.width;
+    int height = mipMap.height;
+    int pixelCount = width * height;
+
+    if (pixelCount == 0 || width != texture._width || height != texture._height) return false;
+
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(&mipMap.data[0]);
+    int srcSize = static_cast<int>(mipMap.data.size());
+
+    pixels.resize(4 * pixelCount);
+    uint8_t *dst = reinterpret_cast<uint8_t *>(&pixels[0]);
+
+    switch (texture._pixelFormat) {
+        case PixelFormat::RGB:
+        case PixelFormat::BGR: {
+            if (srcSize < 3 * pixelCount) return false;
+            bool bgr = texture._pixelFormat == PixelFormat::BGR;
+            for (int i = 0; i < pixelCount; ++i) {
+                dst[4 * i + 0] = src[3 * i + (bgr ? 2 : 0)];
+                dst[4 * i + 1] = src[3 * i + 1];
+                dst[4 * i + 2] = src[3 * i + (bgr ? 0 : 2)];
+                dst[4 * i + 3] = 255;
+            }
+            return true;
+        }
+        case PixelFormat::RGBA:
+        case PixelFormat::BGRA: {
+            if (srcSize < 4 * pixelCount) return false;
+            bool bgra = texture._pixelFormat == PixelFormat::BGRA;
+            for (int i = 0; i < pixelCount; ++i) {
+                dst[4 * i + 0] = src[4 * i + (bgra ? 2 : 0)];
+                dst[4 * i + 1] = src[4 * i + 1];
+                dst[4 * i + 2] = src[4 * i + (bgra ? 0 : 2)];
+                dst[4 * i + 3] = src[4 * i + 3];
+            }
+            return true;
+        }
+        case PixelFormat::DXT1:
+        case PixelFormat::DXT5: {
+            bool dxt1 = texture._pixelFormat == PixelFormat::DXT1;
+            int blockSize = dxt1 ? 8 : 16;
+            int blocksX = (width + 3) / 4;
+            int blocksY = (height + 3) / 4;
+
+            if (srcSize < blockSize * blocksX * blocksY) return false;
+
+            uint8_t blockPixels[4 * 16];
+
+            for (int by = 0; by < blocksY; ++by) {
+                for (int bx = 0; bx < blocksX; ++bx) {
+                    const uint8_t *block = &src[blockSize * (by * blocksX + bx)];
+                    if (dxt1) {
+                        decodeColorBlock(block, true, blockPixels);
+                    } else {
+                        decodeColorBlock(block + 8, false, blockPixels);
+                        decodeAlphaBlock(block, blockPixels);
+                    }
+                    for (int y = 0; y < 4 && 4 * by + y < height; ++y) {
+                        for (int x = 0; x < 4 && 4 * bx + x < width; ++x) {
+                            memcpy(&dst[4 * ((4 * by + y) * width + 4 * bx + x)], &blockPixels[4 * (4 * y + x)], 4);
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+shared_ptr<Texture> TextureAtlas::newPage() {
+    string name(_name + "_atlas" + to_string(_pages.size()));
+
+    auto page = make_shared<Texture>(name, TextureType::GUI);
+    page->_pixelFormat = PixelFormat::RGBA;
+    page->_width = kPageSize;
+    page->_height = kPageSize;
+
+    Texture::MipMap mipMap;
+    mipMap.width = kPageSize;
+    mipMap.height = kPageSize;
+    mipMap.data.resize(4 * kPageSize * kPageSize, 0);
+
+    Texture::Layer layer;
+    layer.mipMaps.push_back(move(mipMap));
+    page->_layers.push_back(move(layer));
+
+    _pages.push_back(page);
+
+    return move(page);
+}
+
+void TextureAtlas::initGL() {
+    for (auto &page : _pages) {
+        page->initGL();
+    }
+}
+
+const TextureAtlas::Region *TextureAtlas::find(const Texture *texture) const {
+    auto maybeRegion = _regions.find(texture);
+    return maybeRegion != _regions.end() ? &maybeRegion->second : nullptr;
+}
+
+int TextureAtlas::pageCount() const {
+    return static_cast<int>(_pages.size());
+}
+
+} // namespace render
+
+} // namespace reone
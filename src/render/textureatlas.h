@@ -0,0 +1,87 @@
+/*
+ * Copyright  2020 Vsevolod Kremianskii
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+#include "texture.h"
+
+namespace reone {
+
+namespace render {
+
+/**
+ * Small GUI textures packed into a few large RGBA pages, so that quads
+ * using different textures can be drawn without rebinding.
+ *
+ * @see reone::render::GUIBatch
+ */
+class TextureAtlas {
+public:
+    /**
+     * Location of a packed texture within an atlas page.
+     */
+    struct Region {
+        std::shared_ptr<Texture> page;
+        glm::vec2 uvMin { 0.0f };
+        glm::vec2 uvMax { 0.0f };
+    };
+
+    TextureAtlas(const std::string &name);
+
+    /**
+     * Packs the specified textures into atlas pages. Textures that are too
+     * large or have an unsupported pixel format are skipped.
+     */
+    void build(const std::vector<std::shared_ptr<Texture>> &textures);
+
+    void initGL();
+
+    /**
+     * @return region of the packed texture, or nullptr if it was not packed
+     */
+    const Region *find(const Texture *texture) const;
+
+    int pageCount() const;
+
+private:
+    std::string _name;
+    std::vector<std::shared_ptr<Texture>> _pages;
+    std::unordered_map<const Texture *, Region> _regions;
+
+    TextureAtlas(const TextureAtlas &) = delete;
+    TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+    /**
+     * Converts the base level of the texture to RGBA.
+     *
+     * @return false if the texture cannot be packed
+     */
+    static bool getPixels(const Texture &texture, ByteArray &pixels);
+
+    std::shared_ptr<Texture> newPage();
+};
+
+} // namespace render
+
+} // namespace reone
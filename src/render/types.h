@@ -48,15 +48,30 @@ enum AnimationFlags {
     kAnimationPropagate = 2
 };
 
+enum class AnimationLOD {
+    Full,
+    Reduced,
+    Frozen
+};
+
 enum class CameraType {
     FirstPerson,
     ThirdPerson
 };
 
+struct AnimationLODOptions {
+    float nearDistance { 16.0f }; /**< models nearer to the camera are animated every frame */
+    float farDistance { 48.0f }; /**< models farther from the camera are not animated */
+    int reducedRate { 4 }; /**< models in between are animated every Nth frame */
+};
+
 struct GraphicsOptions {
     int width { 0 };
     int height { 0 };
     bool fullscreen { false };
+    AnimationLODOptions animLod;
+    bool keepMeshData { false }; /**< keep mesh data in client memory after upload, for debugging */
+    bool headless { false }; /**< run without a window, using the null render backend */
 };
 
 struct TextureFeatures {
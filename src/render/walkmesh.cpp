@@ -17,13 +17,19 @@
 
 #include "walkmesh.h"
 
+#include <limits>
+
 #include "glm/gtx/intersect.hpp"
 #include "glm/gtx/norm.hpp"
 
+using namespace std;
+
 namespace reone {
 
 namespace render {
 
+static const int kMaxTraversalStackSize = 64;
+
 void Walkmesh::computeAABB() {
     _aabb.reset();
 
@@ -34,50 +40,168 @@ void Walkmesh::computeAABB() {
 
 bool Walkmesh::findObstacle(const glm::vec3 &from, const glm::vec3 &to, glm::vec3 &intersection) const {
     glm::vec3 delta(to - from);
-    glm::vec3 dir(glm::normalize(delta));
+    float length2 = glm::length2(delta);
+    if (length2 == 0.0f) return false;
 
-    for (auto &face : _nonWalkableFaces) {
-        const glm::vec3 &p0 = _vertices[face.indices[0]];
-        const glm::vec3 &p1 = _vertices[face.indices[1]];
-        const glm::vec3 &p2 = _vertices[face.indices[2]];
+    float length = glm::sqrt(length2);
+    glm::vec3 dir(delta / length);
+    float distance = 0.0f;
 
-        glm::vec2 baryIntersection { 0.0f };
-        float distance = 0.0f;
+    if (raycast(_nonWalkableBVH, from, dir, length, distance)) {
+        intersection = from + dir * distance;
+        return true;
+    }
+
+    return false;
+}
 
-        if (glm::intersectRayTriangle(from, dir, p0, p1, p2, baryIntersection, distance) &&
-            distance >= 0.0f &&
-            distance * distance <= glm::length2(delta)) {
+bool Walkmesh::findElevationAt(const glm::vec3 &position, float &z, int *face) const {
+    float distance = 0.0f;
 
-            intersection = from + dir * distance;
-            return true;
-        }
+    if (raycast(_walkableBVH, position, glm::vec3(0.0f, 0.0f, -1.0f), numeric_limits<float>::max(), distance, face)) {
+        z = position.z - distance;
+        return true;
     }
 
     return false;
 }
 
-bool Walkmesh::findElevationAt(const glm::vec3 &position, float &z) const {
-    for (auto &face : _walkableFaces) {
-        const glm::vec3 &p0 = _vertices[face.indices[0]];
-        const glm::vec3 &p1 = _vertices[face.indices[1]];
-        const glm::vec3 &p2 = _vertices[face.indices[2]];
+bool Walkmesh::findElevationAround(int face, const glm::vec3 &position, float maxDistance, float &z, int *foundFace) const {
+    if (face < 0 || 3 * face >= static_cast<int>(_adjacentFaces.size())) return false;
+
+    float nearest = maxDistance;
+    int nearestFace = -1;
+    float distance = 0.0f;
 
-        glm::vec2 intersection(0.0f);
-        float distance = 0.0f;
+    if (findElevationAtFace(face, position, distance) && distance <= nearest) {
+        nearest = distance;
+        nearestFace = face;
+    }
+    for (int i = 0; i < 3; ++i) {
+        int adjacentFace = _adjacentFaces[3 * face + i];
+        if (adjacentFace == -1) continue;
 
-        if (glm::intersectRayTriangle(position, glm::vec3(0.0f, 0.0f, -1.0f), p0, p1, p2, intersection, distance)) {
-            z = position.z - distance;
-            return true;
+        if (findElevationAtFace(adjacentFace, position, distance) && distance < nearest) {
+            nearest = distance;
+            nearestFace = adjacentFace;
         }
     }
+    if (nearestFace == -1) return false;
 
-    return false;
+    z = position.z - nearest;
+    if (foundFace) {
+        *foundFace = nearestFace;
+    }
+
+    return true;
+}
+
+bool Walkmesh::findElevationAtFace(int face, const glm::vec3 &position, float &distance) const {
+    const uint32_t *indices = &_indices[3 * face];
+    glm::vec2 baryPosition(0.0f);
+
+    return
+        glm::intersectRayTriangle(position, glm::vec3(0.0f, 0.0f, -1.0f), _vertices[indices[0]], _vertices[indices[1]], _vertices[indices[2]], baryPosition, distance) &&
+        distance >= 0.0f;
+}
+
+static inline bool intersectRayNode(const glm::vec3 &origin, const glm::vec3 &invDir, const WalkmeshBVH::Node &node, float maxDistance, float &entry) {
+    glm::vec3 t1((node.min - origin) * invDir);
+    glm::vec3 t2((node.max - origin) * invDir);
+    glm::vec3 tMin(glm::min(t1, t2));
+    glm::vec3 tMax(glm::max(t1, t2));
+
+    entry = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+    float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+
+    return entry <= exit;
+}
+
+bool Walkmesh::raycast(const WalkmeshBVH &bvh, const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance, float &distance, int *face) const {
+    if (bvh.nodes.empty()) return false;
+
+    glm::vec3 invDir(getSafeInverse(dir.x), getSafeInverse(dir.y), getSafeInverse(dir.z));
+    float nearest = maxDistance;
+    int nearestIdx = -1;
+
+    Ray ray;
+    ray.origin = origin;
+    ray.dir = dir;
+    RayHit leafHit;
+
+    // Nodes pending traversal, along with distances at which the ray enters them
+
+    pair<uint32_t, float> stack[kMaxTraversalStackSize];
+    int stackSize = 0;
+    float entry = 0.0f;
+
+    if (!intersectRayNode(origin, invDir, bvh.nodes[0], nearest, entry)) return false;
+    stack[stackSize++] = make_pair(0, entry);
+
+    while (stackSize > 0) {
+        --stackSize;
+        uint32_t nodeIdx = stack[stackSize].first;
+        if (stack[stackSize].second > nearest) continue;
+
+        const WalkmeshBVH::Node &node = bvh.nodes[nodeIdx];
+
+        if (node.faceCount > 0) {
+            ray.maxDistance = nearest;
+            if (intersectRayTriangles(ray, bvh.triangles, node.offset, node.offset + node.faceCount, leafHit)) {
+                nearest = leafHit.distance;
+                nearestIdx = leafHit.index;
+            }
+            continue;
+        }
+
+        uint32_t leftIdx = nodeIdx + 1;
+        uint32_t rightIdx = node.offset;
+        float leftEntry = 0.0f;
+        float rightEntry = 0.0f;
+        bool leftHit = intersectRayNode(origin, invDir, bvh.nodes[leftIdx], nearest, leftEntry);
+        bool rightHit = intersectRayNode(origin, invDir, bvh.nodes[rightIdx], nearest, rightEntry);
+
+        // Push the farther child first, so that the nearer one is visited first
+
+        if (leftHit && rightHit && leftEntry <= rightEntry) {
+            stack[stackSize++] = make_pair(rightIdx, rightEntry);
+            stack[stackSize++] = make_pair(leftIdx, leftEntry);
+        } else {
+            if (leftHit) stack[stackSize++] = make_pair(leftIdx, leftEntry);
+            if (rightHit) stack[stackSize++] = make_pair(rightIdx, rightEntry);
+        }
+    }
+
+    if (nearestIdx == -1) return false;
+
+    distance = nearest;
+    if (face) {
+        *face = static_cast<int>(bvh.faces[nearestIdx]);
+    }
+
+    return true;
 }
 
 const AABB &Walkmesh::aabb() const {
     return _aabb;
 }
 
+const vector<glm::vec3> &Walkmesh::vertices() const {
+    return _vertices;
+}
+
+const vector<uint32_t> &Walkmesh::indices() const {
+    return _indices;
+}
+
+const vector<uint32_t> &Walkmesh::walkableFaces() const {
+    return _walkableFaces;
+}
+
+const vector<int> &Walkmesh::adjacentFaces() const {
+    return _adjacentFaces;
+}
+
 } // namespace render
 
 } // namespace reone
@@ -17,9 +17,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "aabb.h"
+#include "raykernels.h"
 
 namespace reone {
 
@@ -31,24 +33,76 @@ class BwmFile;
 
 namespace render {
 
-class Walkmesh {
-public:
-    struct Face {
-        uint32_t type { 0 };
-        std::vector<uint16_t> indices;
+static const uint32_t kWalkmeshPaddingFace = 0xffffffff;
+
+/**
+ * Bounding volume hierarchy over a subset of walkmesh faces.
+ */
+struct WalkmeshBVH {
+    /**
+     * Nodes are stored in depth-first order: the left child of an inner node
+     * immediately follows it, the right child is at the index stored in
+     * offset. For leaf nodes, offset is the first triangle in triangles.
+     */
+    struct Node {
+        glm::vec3 min { 0.0f };
+        glm::vec3 max { 0.0f };
+        uint32_t offset { 0 };
+        uint32_t faceCount { 0 }; /**< zero for inner nodes */
     };
 
+    std::vector<Node> nodes;
+    /**
+     * Triangles of leaves in depth-first order. Every leaf starts at a
+     * multiple of its maximum size and is padded with degenerate triangles.
+     */
+    TriangleBatch triangles;
+
+    std::vector<uint32_t> faces; /**< walkmesh face index of every triangle, or kWalkmeshPaddingFace */
+};
+
+class Walkmesh {
+public:
     Walkmesh() = default;
 
+    /**
+     * Finds the non-walkable face nearest to from, intersected by the line
+     * segment from-to.
+     */
     bool findObstacle(const glm::vec3 &from, const glm::vec3 &to, glm::vec3 &intersection) const;
-    bool findElevationAt(const glm::vec3 &position, float &z) const;
+
+    /**
+     * Finds the highest walkable face below position.
+     *
+     * @param face if not null, receives index of the found face
+     */
+    bool findElevationAt(const glm::vec3 &position, float &z, int *face = nullptr) const;
+
+    /**
+     * Finds elevation at position, only testing the walkable face and faces
+     * adjacent to it. Intended for objects moving across the walkmesh, which
+     * rarely leave the face they were on in one step.
+     *
+     * @param face index of the walkable face to start with
+     * @param maxDistance maximum distance from position down to the face
+     * @param foundFace if not null, receives index of the found face
+     */
+    bool findElevationAround(int face, const glm::vec3 &position, float maxDistance, float &z, int *foundFace = nullptr) const;
 
     const AABB &aabb() const;
+    const std::vector<glm::vec3> &vertices() const;
+    const std::vector<uint32_t> &indices() const;
+    const std::vector<uint32_t> &walkableFaces() const;
+    const std::vector<int> &adjacentFaces() const;
 
 private:
     std::vector<glm::vec3> _vertices;
-    std::vector<Face> _walkableFaces;
-    std::vector<Face> _nonWalkableFaces;
+    std::vector<uint32_t> _indices; /**< three vertex indices per face */
+    std::vector<uint32_t> _faceTypes;
+    std::vector<uint32_t> _walkableFaces;
+    std::vector<int> _adjacentFaces; /**< three per face, across its edges, or -1; only links walkable faces */
+    WalkmeshBVH _walkableBVH;
+    WalkmeshBVH _nonWalkableBVH;
     AABB _aabb;
 
     Walkmesh(const Walkmesh &) = delete;
@@ -56,6 +110,14 @@ private:
 
     void computeAABB();
 
+    /**
+     * Finds the nearest face in the hierarchy, intersected by the ray within
+     * maxDistance.
+     */
+    bool raycast(const WalkmeshBVH &bvh, const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance, float &distance, int *face = nullptr) const;
+
+    bool findElevationAtFace(int face, const glm::vec3 &position, float &distance) const;
+
     friend class resources::BwmFile;
 };
 
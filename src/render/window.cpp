@@ -19,15 +19,18 @@
 
 #include <stdexcept>
 
-#include "GL/glew.h"
-
 #include "SDL2/SDL.h"
 
 #include "glm/ext.hpp"
 
 #include "mesh/aabb.h"
+#include "mesh/bufferarena.h"
 #include "mesh/guiquad.h"
 
+#include "backend.h"
+#include "glapi.h"
+#include "guibatch.h"
+#include "instancebuffer.h"
 #include "shaders.h"
 
 using namespace std;
@@ -40,6 +43,27 @@ RenderWindow::RenderWindow(const GraphicsOptions &opts, IEventHandler *eventHand
 }
 
 void RenderWindow::init() {
+    if (_opts.headless) {
+        SDL_Init(SDL_INIT_TIMER);
+        TheRenderBackend.init(RenderBackendType::Null);
+    } else {
+        initWindow();
+        TheRenderBackend.init(RenderBackendType::OpenGL);
+    }
+
+    BufferArena::instance().setKeepClientData(_opts.keepMeshData);
+
+    ShaderManager::instance().initGL();
+    InstanceBuffer::instance().initGL();
+    AABBMesh::instance().initGL();
+    GUIQuad::instance().initGL();
+    GUIBatch::instance().initGL();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void RenderWindow::initWindow() {
     SDL_Init(SDL_INIT_VIDEO);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
@@ -66,30 +90,31 @@ void RenderWindow::init() {
     }
 
     SDL_GL_SetSwapInterval(0);
-    glewInit();
-
-    ShaderManager::instance().initGL();
-    AABBMesh::instance().initGL();
-    GUIQuad::instance().initGL();
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void RenderWindow::deinit() {
+    GUIBatch::instance().deinitGL();
     GUIQuad::instance().deinitGL();
     AABBMesh::instance().deinitGL();
+    BufferArena::instance().deinitGL();
+    InstanceBuffer::instance().deinitGL();
     ShaderManager::instance().deinitGL();
-    SDL_GL_DeleteContext(_context);
-    SDL_DestroyWindow(_window);
+
+    if (_context) SDL_GL_DeleteContext(_context);
+    if (_window) SDL_DestroyWindow(_window);
+
     SDL_Quit();
 }
 
 void RenderWindow::show() {
+    if (!_window) return;
+
     SDL_ShowWindow(_window);
 }
 
 void RenderWindow::processEvents(bool &quit) {
+    if (!_window) return;
+
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (handleEvent(event, quit)) continue;
@@ -160,6 +185,8 @@ void RenderWindow::drawCursor() const {
 }
 
 void RenderWindow::swapBuffers() const {
+    if (!_window) return;
+
     SDL_GL_SwapWindow(_window);
 }
 
@@ -62,6 +62,7 @@ private:
     std::function<void()> _onRenderWorld;
     std::function<void()> _onRenderGUI;
 
+    void initWindow();
     bool handleEvent(const SDL_Event &event, bool &quit);
     bool handleKeyDownEvent(const SDL_KeyboardEvent &event, bool &quit);
 };
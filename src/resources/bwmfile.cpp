@@ -17,6 +17,12 @@
 
 #include "bwmfile.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <tuple>
+
 #include "glm/ext.hpp"
 
 using namespace std;
@@ -27,6 +33,8 @@ namespace reone {
 
 namespace resources {
 
+static const uint32_t kMaxBVHLeafSize = 4;
+
 static vector<uint32_t> g_walkableTypes = { 1, 3, 4, 5, 9, 10 };
 
 BwmFile::BwmFile() : BinaryFile(8, "BWM V1.0") {
@@ -84,33 +92,153 @@ void BwmFile::loadFaceTypes() {
 void BwmFile::makeWalkmesh() {
     _walkmesh = make_shared<Walkmesh>();
     _walkmesh->_vertices.reserve(_vertexCount);
-    _walkmesh->_walkableFaces.reserve(_faceCount);
 
     for (uint32_t i = 0; i < 3 * _vertexCount; i += 3) {
         _walkmesh->_vertices.push_back(glm::make_vec3(&_vertices[i]));
     }
+    _walkmesh->_indices = _indices;
+    _walkmesh->_faceTypes = _faceTypes;
+
+    vector<uint32_t> walkableFaces;
+    vector<uint32_t> nonWalkableFaces;
 
     for (uint32_t i = 0; i < _faceCount; ++i) {
         uint32_t type = _faceTypes[i];
         bool walkable = find(g_walkableTypes.begin(), g_walkableTypes.end(), type) != g_walkableTypes.end();
 
-        int off = 3 * i;
-        Walkmesh::Face face;
-        face.type = type;
-        face.indices.push_back(_indices[off + 0]);
-        face.indices.push_back(_indices[off + 1]);
-        face.indices.push_back(_indices[off + 2]);
-
         if (walkable) {
-            _walkmesh->_walkableFaces.push_back(move(face));
+            walkableFaces.push_back(i);
         } else {
-            _walkmesh->_nonWalkableFaces.push_back(move(face));
+            nonWalkableFaces.push_back(i);
         }
     }
 
+    _walkmesh->_walkableFaces = walkableFaces;
+
+    makeAdjacentFaces(walkableFaces);
+    makeBVH(move(walkableFaces), _walkmesh->_walkableBVH);
+    makeBVH(move(nonWalkableFaces), _walkmesh->_nonWalkableBVH);
+
     _walkmesh->computeAABB();
 }
 
+void BwmFile::makeBVH(vector<uint32_t> faces, WalkmeshBVH &bvh) const {
+    if (faces.empty()) return;
+
+    const vector<glm::vec3> &vertices = _walkmesh->_vertices;
+
+    vector<glm::vec3> centroids(_faceCount);
+    for (uint32_t face : faces) {
+        const uint32_t *indices = &_indices[3 * face];
+        centroids[face] = (vertices[indices[0]] + vertices[indices[1]] + vertices[indices[2]]) / 3.0f;
+    }
+
+    // Split ranges of faces at the median centroid along the longest axis,
+    // which keeps the hierarchy balanced and its depth logarithmic
+
+    bvh.nodes.reserve(2 * faces.size() / kMaxBVHLeafSize + 1);
+
+    function<uint32_t(uint32_t, uint32_t)> makeNode = [&](uint32_t begin, uint32_t end) {
+        uint32_t nodeIdx = static_cast<uint32_t>(bvh.nodes.size());
+        bvh.nodes.push_back(WalkmeshBVH::Node());
+
+        glm::vec3 min(numeric_limits<float>::max());
+        glm::vec3 max(-numeric_limits<float>::max());
+        glm::vec3 centroidMin(min);
+        glm::vec3 centroidMax(max);
+
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t *indices = &_indices[3 * faces[i]];
+            for (int j = 0; j < 3; ++j) {
+                min = glm::min(min, vertices[indices[j]]);
+                max = glm::max(max, vertices[indices[j]]);
+            }
+            centroidMin = glm::min(centroidMin, centroids[faces[i]]);
+            centroidMax = glm::max(centroidMax, centroids[faces[i]]);
+        }
+        bvh.nodes[nodeIdx].min = min;
+        bvh.nodes[nodeIdx].max = max;
+
+        if (end - begin <= kMaxBVHLeafSize) {
+            bvh.nodes[nodeIdx].offset = begin;
+            bvh.nodes[nodeIdx].faceCount = end - begin;
+            return nodeIdx;
+        }
+
+        glm::vec3 extent(centroidMax - centroidMin);
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t mid = begin + (end - begin) / 2;
+
+        nth_element(faces.begin() + begin, faces.begin() + mid, faces.begin() + end, [&](uint32_t left, uint32_t right) {
+            return centroids[left][axis] < centroids[right][axis];
+        });
+
+        makeNode(begin, mid);
+        uint32_t rightIdx = makeNode(mid, end);
+        bvh.nodes[nodeIdx].offset = rightIdx;
+
+        return nodeIdx;
+    };
+    makeNode(0, static_cast<uint32_t>(faces.size()));
+
+    // Store triangles of every leaf contiguously, starting at a multiple of
+    // the leaf size, so that a leaf is tested with a single SIMD operation
+
+    for (auto &node : bvh.nodes) {
+        if (node.faceCount == 0) continue;
+
+        uint32_t offset = static_cast<uint32_t>(bvh.triangles.count);
+        for (uint32_t i = node.offset; i < node.offset + node.faceCount; ++i) {
+            const uint32_t *indices = &_indices[3 * faces[i]];
+            bvh.triangles.add(vertices[indices[0]], vertices[indices[1]], vertices[indices[2]]);
+            bvh.faces.push_back(faces[i]);
+        }
+        while (bvh.triangles.count % kMaxBVHLeafSize != 0) {
+            bvh.triangles.add(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f));
+            bvh.faces.push_back(kWalkmeshPaddingFace);
+        }
+        node.offset = offset;
+    }
+}
+
+void BwmFile::makeAdjacentFaces(const vector<uint32_t> &faces) {
+    const vector<glm::vec3> &vertices = _walkmesh->_vertices;
+
+    // Vertices may be duplicated, so edges are matched by vertex positions
+
+    map<tuple<float, float, float>, uint32_t> uniqueVertices;
+    vector<uint32_t> vertexIds(_vertexCount);
+    for (uint32_t i = 0; i < _vertexCount; ++i) {
+        auto key = make_tuple(vertices[i].x, vertices[i].y, vertices[i].z);
+        vertexIds[i] = uniqueVertices.insert(make_pair(key, i)).first->second;
+    }
+
+    // Link faces sharing an edge. Should more than two faces share one, they
+    // are linked in pairs.
+
+    map<pair<uint32_t, uint32_t>, int> unpairedEdges;
+    vector<int> &adjacentFaces = _walkmesh->_adjacentFaces;
+    adjacentFaces.assign(3 * _faceCount, -1);
+
+    for (uint32_t face : faces) {
+        for (int i = 0; i < 3; ++i) {
+            uint32_t a = vertexIds[_indices[3 * face + i]];
+            uint32_t b = vertexIds[_indices[3 * face + (i + 1) % 3]];
+            auto key = make_pair(glm::min(a, b), glm::max(a, b));
+
+            auto maybeEdge = unpairedEdges.find(key);
+            if (maybeEdge == unpairedEdges.end()) {
+                unpairedEdges.insert(make_pair(key, 3 * face + i));
+                continue;
+            }
+            int otherEdge = maybeEdge->second;
+            adjacentFaces[3 * face + i] = otherEdge / 3;
+            adjacentFaces[otherEdge] = face;
+            unpairedEdges.erase(maybeEdge);
+        }
+    }
+}
+
 shared_ptr<render::Walkmesh> BwmFile::walkmesh() const {
     return _walkmesh;
 }
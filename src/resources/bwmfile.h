@@ -47,6 +47,8 @@ private:
     void loadFaces();
     void loadFaceTypes();
     void makeWalkmesh();
+    void makeBVH(std::vector<uint32_t> faces, render::WalkmeshBVH &bvh) const;
+    void makeAdjacentFaces(const std::vector<uint32_t> &faces);
 };
 
 } // namespace resources
@@ -281,7 +281,8 @@ void MdlFile::readControllers(uint32_t keyCount, uint32_t keyOffset, const vecto
 
 void MdlFile::readPositionController(uint16_t rowCount, uint8_t columnCount, uint16_t timeIndex, uint16_t dataIndex, const vector<float> &data, ModelNode &node) {
     bool bezier = columnCount & 16;
-    node._positionFrames.reserve(rowCount);
+    node._positionTimes.reserve(rowCount);
+    node._positions.reserve(rowCount);
 
     switch (columnCount) {
         case 3:
@@ -290,11 +291,8 @@ void MdlFile::readPositionController(uint16_t rowCount, uint8_t columnCount, uin
                 int rowTimeIdx = timeIndex + i;
                 int rowDataIdx = dataIndex + i * (bezier ? 9 : 3);
 
-                ModelNode::PositionKeyframe frame;
-                frame.time = data[rowTimeIdx];
-                frame.position = glm::make_vec3(&data[rowDataIdx]);
-
-                node._positionFrames.push_back(move(frame));
+                node._positionTimes.push_back(data[rowTimeIdx]);
+                node._positions.push_back(glm::make_vec3(&data[rowDataIdx]));
             }
             break;
         default:
@@ -303,7 +301,8 @@ void MdlFile::readPositionController(uint16_t rowCount, uint8_t columnCount, uin
 }
 
 void MdlFile::readOrientationController(uint16_t rowCount, uint8_t columnCount, uint16_t timeIndex, uint16_t dataIndex, const vector<float> &data, ModelNode &node) {
-    node._orientationFrames.reserve(rowCount);
+    node._orientationTimes.reserve(rowCount);
+    node._orientations.reserve(rowCount);
 
     switch (columnCount) {
         case 2:
@@ -328,11 +327,8 @@ void MdlFile::readOrientationController(uint16_t rowCount, uint8_t columnCount,
                     w = -glm::sqrt(1.0f - dot);
                 }
 
-                ModelNode::OrientationKeyframe frame;
-                frame.time = data[rowTimeIdx];
-                frame.orientation = glm::quat(w, x, y, z);
-
-                node._orientationFrames.push_back(move(frame));
+                node._orientationTimes.push_back(data[rowTimeIdx]);
+                node._orientations.push_back(glm::quat(w, x, y, z));
             }
             break;
 
@@ -341,14 +337,14 @@ void MdlFile::readOrientationController(uint16_t rowCount, uint8_t columnCount,
                 int rowTimeIdx = timeIndex + i;
                 int rowDataIdx = dataIndex + i * 4;
 
-                ModelNode::OrientationKeyframe frame;
-                frame.time = data[rowTimeIdx];
-                frame.orientation.x = data[rowDataIdx + 0];
-                frame.orientation.y = data[rowDataIdx + 1];
-                frame.orientation.z = data[rowDataIdx + 2];
-                frame.orientation.w = data[rowDataIdx + 3];
+                glm::quat orientation;
+                orientation.x = data[rowDataIdx + 0];
+                orientation.y = data[rowDataIdx + 1];
+                orientation.z = data[rowDataIdx + 2];
+                orientation.w = data[rowDataIdx + 3];
 
-                node._orientationFrames.push_back(move(frame));
+                node._orientationTimes.push_back(data[rowTimeIdx]);
+                node._orientations.push_back(move(orientation));
             }
             break;
         default:
@@ -511,15 +507,17 @@ void MdlFile::readSkin(ModelNode &node) {
     node._mesh->_offsets.boneWeights = boneWeightsOffset;
     node._mesh->_offsets.boneIndices = boneIndicesOffset;
 
-    map<uint16_t, uint16_t> nodeIdxByBoneIdx;
+    vector<uint16_t> nodeIdxByBoneIdx;
     seek(kMdlDataOffset + bonesOffset);
 
     for (uint32_t i = 0; i < boneCount; ++i) {
         uint16_t boneIdx = static_cast<uint16_t>(readFloat());
         if (boneIdx == 0xffff) continue;
 
-        uint16_t nodeIdx = i;
-        nodeIdxByBoneIdx.insert(make_pair(boneIdx, nodeIdx));
+        if (boneIdx >= nodeIdxByBoneIdx.size()) {
+            nodeIdxByBoneIdx.resize(boneIdx + 1, 0xffff);
+        }
+        nodeIdxByBoneIdx[boneIdx] = i;
     }
 
     node._skin = make_unique<ModelNode::Skin>();
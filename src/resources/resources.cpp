@@ -23,6 +23,7 @@
 
 #include "../core/log.h"
 #include "../core/pathutil.h"
+#include "../core/profiler.h"
 #include "../core/streamutil.h"
 
 #include "erffile.h"
@@ -235,6 +236,7 @@ shared_ptr<ByteArray> ResourceManager::find(const string &resRef, ResourceType t
     if (it != g_resCache.end()) {
         return it->second;
     }
+    PROFILE_SCOPE("ResourceManager::find");
     debug("Resources: load " + cacheKey, 2);
 
     shared_ptr<ByteArray> data = find(_transientProviders, resRef, type);
@@ -363,6 +365,7 @@ shared_ptr<Model> ResourceManager::findModel(const string &resRef) {
     if (it != g_modelCache.end()) {
         return it->second;
     }
+    PROFILE_SCOPE("ResourceManager::findModel");
     shared_ptr<ByteArray> mdlData(find(resRef, ResourceType::Model));
     shared_ptr<ByteArray> mdxData(find(resRef, ResourceType::Mdx));
     shared_ptr<Model> model;
@@ -383,6 +386,7 @@ shared_ptr<Walkmesh> ResourceManager::findWalkmesh(const string &resRef, Resourc
     if (it != g_walkmeshCache.end()) {
         return it->second;
     }
+    PROFILE_SCOPE("ResourceManager::findWalkmesh");
     shared_ptr<ByteArray> bwmData(find(resRef, type));
     shared_ptr<Walkmesh> walkmesh;
 
@@ -402,6 +406,7 @@ shared_ptr<Texture> ResourceManager::findTexture(const string &resRef, TextureTy
     if (it != g_texCache.end()) {
         return it->second;
     }
+    PROFILE_SCOPE("ResourceManager::findTexture");
     bool tryCur = type == TextureType::Cursor;
     bool tryTpc = _version == GameVersion::TheSithLords || type != TextureType::Lightmap;
     shared_ptr<Texture> texture;
@@ -471,6 +476,8 @@ shared_ptr<ScriptProgram> ResourceManager::findScript(const string &resRef) {
     auto it = g_scripts.find(resRef);
     if (it != g_scripts.end()) return it->second;
 
+    PROFILE_SCOPE("ResourceManager::findScript");
+
     shared_ptr<ScriptProgram> program;
     shared_ptr<ByteArray> ncsData(ResMan.find(resRef, ResourceType::CompiledScript));
 
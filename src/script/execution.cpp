@@ -22,6 +22,7 @@
 #include <boost/format.hpp>
 
 #include "../core/log.h"
+#include "../core/profiler.h"
 
 #include "routine.h"
 #include "util.h"
@@ -83,6 +84,8 @@ ScriptExecution::ScriptExecution(const shared_ptr<ScriptProgram> &program, const
 }
 
 int ScriptExecution::run() {
+    PROFILE_SCOPE("ScriptExecution::run");
+
     debug("Script: " + _program->name());
     uint32_t insOff = kStartInstructionOffset;
 